@@ -30,10 +30,21 @@
 #include <functional>
 
 #include <Utils/StringUtils.h>
-#include <Utils/DebugHandler.h>
 
 #include "ConsoleCommands/QuitCommand.h"
 #include "ConsoleCommands/PingCommand.h"
+#include "ConsoleCommands/StatsCommand.h"
+#include "ConsoleCommands/SlowStartCommand.h"
+#include "ConsoleCommands/DrainCommand.h"
+#include "ConsoleCommands/WeightCommand.h"
+#include "ConsoleCommands/PolicyCommand.h"
+#include "ConsoleCommands/ResyncCommand.h"
+#include "ConsoleCommands/PoolsCommand.h"
+#include "ConsoleCommands/RttCommand.h"
+#include "ConsoleCommands/TraceCommand.h"
+#include "Utils/CommandOutput.h"
+
+using ConsoleCommand = std::function<void(EngineLoop&, std::vector<std::string>, std::shared_ptr<CommandOutput>)>;
 
 class ConsoleCommandHandler
 {
@@ -42,9 +53,20 @@ public:
     {
         RegisterCommand("quit"_h, &QuitCommand);
         RegisterCommand("ping"_h, &PingCommand);
+        RegisterCommand("stats"_h, &StatsCommand);
+        RegisterCommand("slowstart"_h, &SlowStartCommand);
+        RegisterCommand("drain"_h, &DrainCommand);
+        RegisterCommand("undrain"_h, &UndrainCommand);
+        RegisterCommand("weight"_h, &WeightCommand);
+        RegisterCommand("policy"_h, &PolicyCommand);
+        RegisterCommand("resync"_h, &ResyncCommand);
+        RegisterCommand("pools"_h, &PoolsCommand);
+        RegisterCommand("rtt"_h, &RttCommand);
+        RegisterCommand("trace"_h, &TraceCommand);
     }
 
-    void HandleCommand(EngineLoop& engineLoop, std::string& command)
+    // Called from the main thread for the console and from the asio thread for the admin socket, the handlers are never modified after construction
+    void HandleCommand(EngineLoop& engineLoop, std::string& command, std::shared_ptr<CommandOutput> output)
     {
         if (command.size() == 0)
             return;
@@ -56,19 +78,19 @@ public:
         if (commandHandler != commandHandlers.end())
         {
             splitCommand.erase(splitCommand.begin());
-            commandHandler->second(engineLoop, splitCommand);
+            commandHandler->second(engineLoop, splitCommand, output);
         }
         else
         {
-            DebugHandler::PrintWarning("Unhandled command: " + command);
+            output->PrintWarning("Unhandled command: %s", command.c_str());
         }
     }
 
 private:
-    void RegisterCommand(u32 id, const std::function<void(EngineLoop&, std::vector<std::string>)>& handler)
+    void RegisterCommand(u32 id, const ConsoleCommand& handler)
     {
         commandHandlers.insert_or_assign(id, handler);
     }
 
-    std::map<u16, std::function<void(EngineLoop&, std::vector<std::string>)>> commandHandlers = {};
+    std::map<u16, ConsoleCommand> commandHandlers = {};
 };
@@ -0,0 +1,67 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/Message.h>
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../Utils/AddressTypeUtils.h"
+#include "../ECS/Components/Network/LoadBalanceSingleton.h"
+
+inline void SetServerState(EngineLoop& engineLoop, std::vector<std::string>& subCommands, std::shared_ptr<CommandOutput>& output, ServerState state, const char* usage)
+{
+    AddressType type = AddressType::INVALID;
+    if (subCommands.size() < 2 || subCommands.size() > 3 || !AddressTypeUtils::FromName(subCommands[0], type))
+    {
+        output->PrintWarning("%s", usage);
+        return;
+    }
+
+    entt::entity entity = static_cast<entt::entity>(std::strtoul(subCommands[1].c_str(), nullptr, 10));
+    u8 realmId = subCommands.size() == 3 ? static_cast<u8>(std::strtoul(subCommands[2].c_str(), nullptr, 10)) : 0;
+
+    engineLoop.PassCommand([output, type, entity, realmId, state](entt::registry& registry)
+    {
+        LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+        if (!loadBalanceSingleton.SetState(type, realmId, entity, state))
+        {
+            output->PrintWarning("[LoadBalancer]: No %s server (Realm %u, Entity %u)", AddressTypeUtils::GetName(type), realmId, static_cast<u32>(entity));
+            return;
+        }
+
+        output->Print("[LoadBalancer]: %s server (Realm %u, Entity %u) is now %s", AddressTypeUtils::GetName(type), realmId, static_cast<u32>(entity), state == ServerState::DRAINING ? "draining" : "active");
+    });
+}
+
+// drain <type> <entity> [realmId], the server keeps its leases but gets no new assignments, "stats" shows what is still outstanding
+void DrainCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    SetServerState(engineLoop, subCommands, output, ServerState::DRAINING, "Usage: drain <type> <entity> [realmId]");
+}
+
+// undrain <type> <entity> [realmId]
+void UndrainCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    SetServerState(engineLoop, subCommands, output, ServerState::ACTIVE, "Usage: undrain <type> <entity> [realmId]");
+}
\ No newline at end of file
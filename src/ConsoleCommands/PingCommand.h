@@ -24,10 +24,66 @@
 #pragma once
 #include <Utils/Message.h>
 #include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../ECS/Systems/Network/RttSystems.h"
 
-void PingCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands)
+// ping, ping service or ping <ip:port>, without arguments it only checks that the engine loop is running
+void PingCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
 {
-    Message pingMessage;
-    pingMessage.code = MSG_IN_PING;
-    engineLoop.PassMessage(pingMessage);
+    if (subCommands.empty())
+    {
+        // Answered from the engine thread, so a reply also means the engine loop is running
+        engineLoop.PassCommand([output](entt::registry& registry)
+        {
+            output->Print("PONG!");
+        });
+        return;
+    }
+
+    if (subCommands[0] == "service")
+    {
+        engineLoop.PassCommand([output](entt::registry& registry)
+        {
+            f32 rttMS = 0.0f;
+            if (RttUpdateSystem::SampleService(registry, rttMS))
+            {
+                output->Print("[RTT]: Novus-Service %.3f ms", rttMS);
+            }
+            else
+            {
+                output->PrintWarning("[RTT]: Not connected to Novus-Service, or its RTT isn't available on this platform");
+            }
+        });
+        return;
+    }
+
+    size_t separator = subCommands[0].find(':');
+
+    asio::error_code error;
+    asio::ip::address_v4 address = asio::ip::make_address_v4(subCommands[0].substr(0, separator), error);
+    if (separator == std::string::npos || error)
+    {
+        output->PrintWarning("Usage: ping [service | <ip:port>]");
+        return;
+    }
+
+    std::string target = subCommands[0];
+    u32 targetAddress = address.to_uint();
+    u16 targetPort = static_cast<u16>(std::strtoul(subCommands[0].c_str() + separator + 1, nullptr, 10));
+
+    // The probe starts on the engine thread since that is where the results are recorded, the answer is printed from the asio thread
+    engineLoop.PassCommand([output, target, targetAddress, targetPort](entt::registry& registry)
+    {
+        RttUpdateSystem::ProbeBackend(registry, targetAddress, targetPort, [output, target](bool success, f32 rttMS)
+        {
+            if (success)
+            {
+                output->Print("[RTT]: %s %.3f ms", target.c_str(), rttMS);
+            }
+            else
+            {
+                output->PrintWarning("[RTT]: %s didn't accept a connection", target.c_str());
+            }
+        });
+    });
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/Message.h>
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../ECS/Components/Network/LoadBalanceSingleton.h"
+
+// policy <bestfit|worstfit>, how INSTANCE requests are placed on servers that advertise capacity
+void PolicyCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    if (subCommands.size() != 1 || (subCommands[0] != "bestfit" && subCommands[0] != "worstfit"))
+    {
+        output->PrintWarning("Usage: policy <bestfit|worstfit>");
+        return;
+    }
+
+    PlacementPolicy policy = subCommands[0] == "bestfit" ? PlacementPolicy::BEST_FIT : PlacementPolicy::WORST_FIT;
+
+    engineLoop.PassCommand([output, policy](entt::registry& registry)
+    {
+        LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+        loadBalanceSingleton.placementPolicy = policy;
+
+        output->Print("[LoadBalancer]: Placement policy set to %s", policy == PlacementPolicy::BEST_FIT ? "bestfit" : "worstfit");
+    });
+}
\ No newline at end of file
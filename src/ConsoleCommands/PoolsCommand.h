@@ -0,0 +1,53 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../Utils/BufferPool.h"
+
+static void PrintPoolStatistics(std::shared_ptr<CommandOutput>& output, const char* name, const BufferPoolStatistics& statistics)
+{
+    output->Print("    %s: %llu borrows, %.1f%% hits, %llu in use (peak %llu), %llu retained, %llu bytes wasted", name, statistics.borrows, statistics.GetHitRate() * 100.0f, statistics.inUse, statistics.highWater, statistics.retained, statistics.GetBytesWasted());
+}
+
+// pools, the pool counters are atomics so this doesn't have to wait for the engine thread
+void PoolsCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    output->Print("[BufferPool]: Summed over every thread's arena");
+    PrintPoolStatistics(output, "Packets", BufferPool::GetPacketStatistics());
+
+    for (const BufferPoolStatistics& statistics : BufferPool::GetClassStatistics())
+    {
+        if (!statistics.borrows)
+            continue;
+
+        std::string name = std::to_string(statistics.size) + " bytes";
+        PrintPoolStatistics(output, name.c_str(), statistics);
+    }
+
+    for (const BufferPoolOpcodeStatistics& statistics : BufferPool::GetOpcodeStatistics())
+    {
+        output->Print("    Opcode %u: %llu packets, %llu bytes on average, largest %u, size hint %u", static_cast<u32>(statistics.opcode), statistics.packets, statistics.bytes / statistics.packets, statistics.maxSize, static_cast<u32>(BufferPool::GetSizeHint(statistics.opcode)));
+    }
+}
\ No newline at end of file
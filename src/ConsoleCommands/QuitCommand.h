@@ -24,8 +24,9 @@
 #pragma once
 #include <Utils/Message.h>
 #include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
 
-void QuitCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands)
+void QuitCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
 {
     engineLoop.Stop();
 }
\ No newline at end of file
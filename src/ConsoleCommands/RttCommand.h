@@ -0,0 +1,79 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../ECS/Components/Network/RttSingleton.h"
+
+static const char* GetRttTargetKindName(RttTargetKind kind)
+{
+    switch (kind)
+    {
+        case RttTargetKind::SERVICE: return "Service";
+        case RttTargetKind::PEER: return "Peer";
+        case RttTargetKind::BACKEND: return "Backend";
+    }
+
+    return "Unknown";
+}
+
+// rtt, min, avg and p99 over the last RTT_WINDOW_SIZE samples of every target that has been measured
+void RttCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    engineLoop.PassCommand([output](entt::registry& registry)
+    {
+        RttSingleton& rttSingleton = registry.ctx<RttSingleton>();
+        if (rttSingleton.targets.empty())
+        {
+            output->Print("[RTT]: Nothing measured yet");
+            return;
+        }
+
+        std::vector<const RttTarget*> targets;
+        for (auto& [key, target] : rttSingleton.targets)
+        {
+            targets.push_back(&target);
+        }
+
+        std::sort(targets.begin(), targets.end(), [](const RttTarget* a, const RttTarget* b)
+        {
+            return RttSingleton::GetTargetKey(a->kind, a->address, a->port) < RttSingleton::GetTargetKey(b->kind, b->address, b->port);
+        });
+
+        for (const RttTarget* target : targets)
+        {
+            const RttStatistics& statistics = target->statistics;
+            std::string address = asio::ip::address_v4(target->address).to_string();
+
+            if (!statistics.numSamples)
+            {
+                output->Print("[RTT]: %s %s:%u, no samples, %llu failed", GetRttTargetKindName(target->kind), address.c_str(), target->port, statistics.numFailures);
+                continue;
+            }
+
+            output->Print("[RTT]: %s %s:%u, last %.3f ms, min %.3f ms, avg %.3f ms, p99 %.3f ms (%llu samples, %llu failed)", GetRttTargetKindName(target->kind), address.c_str(), target->port,
+                statistics.lastSample, statistics.GetMin(), statistics.GetAverage(), statistics.GetPercentile(0.99f), static_cast<u64>(statistics.numSamples), statistics.numFailures);
+        }
+    });
+}
\ No newline at end of file
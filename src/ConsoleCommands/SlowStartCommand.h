@@ -0,0 +1,53 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/Message.h>
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../ECS/Components/Network/LoadBalanceSingleton.h"
+
+// slowstart <seconds>, 0 disables the ramp for servers added from now on as well as the ones currently ramping
+void SlowStartCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    if (subCommands.size() != 1)
+    {
+        output->PrintWarning("Usage: slowstart <seconds>");
+        return;
+    }
+
+    f32 duration = std::strtof(subCommands[0].c_str(), nullptr);
+    if (duration < 0.0f)
+    {
+        output->PrintWarning("Slow start duration can't be negative");
+        return;
+    }
+
+    engineLoop.PassCommand([output, duration](entt::registry& registry)
+    {
+        LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+        loadBalanceSingleton.slowStartDuration = duration;
+
+        output->Print("[LoadBalancer]: Slow start duration set to %.1f seconds", duration);
+    });
+}
\ No newline at end of file
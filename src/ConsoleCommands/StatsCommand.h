@@ -0,0 +1,121 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/Message.h>
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../Utils/AddressTypeUtils.h"
+#include "../ECS/Components/Network/LoadBalanceSingleton.h"
+#include "../ECS/Components/Network/ReplicationSingleton.h"
+#include "../ECS/Components/Network/ConnectionSingleton.h"
+#include "../ECS/Components/Network/SharedTableSingleton.h"
+#include "../ECS/Components/Singletons/TimerSingleton.h"
+#include "../ECS/Components/Singletons/FrameSingleton.h"
+
+void StatsCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    engineLoop.PassCommand([output](entt::registry& registry)
+    {
+        LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+        output->Print("[LoadBalancer]: Table version %u, %u active leases, %llu revoked", loadBalanceSingleton.GetTableVersion(), loadBalanceSingleton.GetNumActiveLeases(), loadBalanceSingleton.GetNumRevokedLeases());
+
+        TimerSingleton& timerSingleton = registry.ctx<TimerSingleton>();
+        output->Print("[Timers]: %llu scheduled", static_cast<u64>(timerSingleton.wheel.GetNumTimers()));
+
+        FrameSingleton& frameSingleton = registry.ctx<FrameSingleton>();
+        output->Print("[Frames]: %llu frames, p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms, %llu stalls over %.1f ms", frameSingleton.histogram.numFrames, frameSingleton.histogram.GetPercentile(0.5f),
+            frameSingleton.histogram.GetPercentile(0.99f), frameSingleton.histogram.GetPercentile(0.999f), frameSingleton.histogram.maxFrameTime, frameSingleton.numStalls, frameSingleton.stallThreshold * 1000.0f);
+
+        ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+        const BackpressureStatistics& backpressure = connectionSingleton.backpressure;
+        output->Print("[Backpressure]: %s, %llu bytes in %llu buffers queued (peak %llu in %llu), %llu episodes for %.3f s, %llu deferred (%llu waiting), %llu overloaded, %llu dropped", connectionSingleton.isCongested ? "Congested" : "Clear",
+            static_cast<u64>(connectionSingleton.sendQueue.bytes), static_cast<u64>(connectionSingleton.sendQueue.buffers), static_cast<u64>(backpressure.peakBytes), static_cast<u64>(backpressure.peakBuffers),
+            backpressure.episodes, connectionSingleton.GetCongestedTime(), backpressure.deferredRequests, static_cast<u64>(connectionSingleton.deferredRequests.size()), backpressure.overloadedRequests,
+            backpressure.droppedRequests);
+
+        if (u64 droppedLogRecords = Logger::GetNumDropped())
+        {
+            output->Print("[Logger]: %llu records dropped", droppedLogRecords);
+        }
+
+        SharedTableSingleton& sharedTableSingleton = registry.ctx<SharedTableSingleton>();
+        if (sharedTableSingleton.writer.IsOpen())
+        {
+            const SharedTableWriter& writer = sharedTableSingleton.writer;
+            output->Print("[SharedTable]: %u of %u entries at table version %u, %llu writes, %llu servers left out", writer.GetNumEntries(), writer.GetMaxEntries(), sharedTableSingleton.publishedVersion, writer.GetNumWrites(), writer.GetNumDropped());
+        }
+
+        ReplicationSingleton& replicationSingleton = registry.ctx<ReplicationSingleton>();
+        if (replicationSingleton.role == ReplicationRole::ACTIVE)
+        {
+            output->Print("[Replication]: Active in epoch %u, %u snapshots sent", replicationSingleton.epoch, replicationSingleton.snapshotId);
+        }
+        else if (replicationSingleton.role == ReplicationRole::STANDBY)
+        {
+            output->Print("[Replication]: Standby in epoch %u, %llu snapshots applied", replicationSingleton.epoch, replicationSingleton.snapshotsApplied);
+        }
+
+        loadBalanceSingleton.ForEach([&output, &loadBalanceSingleton](AddressType type, u8 realmId, const ServerEntry& entry)
+        {
+            std::string address = AddressTypeUtils::AddressToString(entry.info.address);
+
+            output->Print("    %s (Realm %u, Entity %u) %s:%u, Weight: %.2f, Ramp: %.0f%%, Load: %.1f (%.1f from peers), Leases: %u", AddressTypeUtils::GetName(type), realmId, static_cast<u32>(entry.info.entity), address.c_str(), entry.info.port,
+                entry.weight, loadBalanceSingleton.GetRamp(entry) * 100.0f, loadBalanceSingleton.GetLoad(entry), entry.peerLoad, entry.activeLeases);
+
+            if (entry.state == ServerState::DRAINING)
+            {
+                output->Print("        Draining: %u outstanding leases, %u reserved capacity%s", entry.activeLeases, entry.reservedCapacity, entry.IsDrained() ? ", safe to stop" : "");
+            }
+
+            if (entry.hasCapacity)
+            {
+                output->Print("        Capacity: %u free of %u, %u reserved", entry.GetFreeCapacity(), entry.capacity, entry.reservedCapacity);
+            }
+
+            if (entry.region != REGION_NONE)
+            {
+                output->Print("        Region: %u, RTT: %.2f ms", entry.region, entry.rtt);
+            }
+        });
+
+        CandidateStatistics candidateStatistics = loadBalanceSingleton.GetAllCandidateStatistics();
+        if (candidateStatistics.requests || candidateStatistics.primaryUsed || candidateStatistics.alternateUsed || candidateStatistics.noneConnected)
+        {
+            output->Print("    Candidates: %llu requests, %llu alternates handed out, reported connections: %llu primary, %llu alternate, %llu none", candidateStatistics.requests, candidateStatistics.candidates,
+                candidateStatistics.primaryUsed, candidateStatistics.alternateUsed, candidateStatistics.noneConnected);
+        }
+
+        RegionStatistics regionStatistics = loadBalanceSingleton.GetAllRegionStatistics();
+        if (regionStatistics.requests)
+        {
+            output->Print("    Regions: %llu requests from a known region, %llu sent to another region", regionStatistics.requests, regionStatistics.remote);
+        }
+
+        for (auto& [realmId, realmStatistics] : loadBalanceSingleton.GetAllRealmStatistics())
+        {
+            output->Print("    Realm %u: %llu requests, %llu failed, %llu for an unknown realm", realmId, realmStatistics.requests, realmStatistics.failures, realmStatistics.unknownRealm);
+        }
+    });
+}
\ No newline at end of file
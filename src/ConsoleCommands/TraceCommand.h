@@ -0,0 +1,70 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../Utils/RequestTracer.h"
+
+// trace [rate | off], traces one in every rate address requests, without arguments it shows what is being traced
+void TraceCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    if (subCommands.empty())
+    {
+        u32 sampleRate = RequestTracer::GetSampleRate();
+        if (sampleRate)
+        {
+            output->Print("[Trace]: Tracing 1 in %u requests to %s", sampleRate, RequestTracer::GetPath().c_str());
+        }
+        else
+        {
+            output->Print("[Trace]: Off");
+        }
+
+        output->Print("[Trace]: %llu records written, %llu dropped", RequestTracer::GetNumWritten(), RequestTracer::GetNumDropped());
+        return;
+    }
+
+    char* end = nullptr;
+    u32 sampleRate = subCommands[0] == "off" ? 0 : static_cast<u32>(std::strtoul(subCommands[0].c_str(), &end, 10));
+    if (end && *end != '\0')
+    {
+        output->PrintWarning("Usage: trace [rate | off]");
+        return;
+    }
+
+    if (!RequestTracer::SetSampleRate(sampleRate))
+    {
+        output->PrintWarning("[Trace]: Failed to open %s", RequestTracer::GetPath().c_str());
+        return;
+    }
+
+    if (sampleRate)
+    {
+        output->Print("[Trace]: Tracing 1 in %u requests to %s", sampleRate, RequestTracer::GetPath().c_str());
+    }
+    else
+    {
+        output->Print("[Trace]: Off");
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <Utils/Message.h>
+#include <cmath>
+#include "../EngineLoop.h"
+#include "../Utils/CommandOutput.h"
+#include "../Utils/AddressTypeUtils.h"
+#include "../ECS/Components/Network/LoadBalanceSingleton.h"
+
+// weight <type> <entity> <weight> [realmId], servers get a share of new assignments proportional to their weight
+void WeightCommand(EngineLoop& engineLoop, std::vector<std::string> subCommands, std::shared_ptr<CommandOutput> output)
+{
+    AddressType type = AddressType::INVALID;
+    if (subCommands.size() < 3 || subCommands.size() > 4 || !AddressTypeUtils::FromName(subCommands[0], type))
+    {
+        output->PrintWarning("Usage: weight <type> <entity> <weight> [realmId]");
+        return;
+    }
+
+    entt::entity entity = static_cast<entt::entity>(std::strtoul(subCommands[1].c_str(), nullptr, 10));
+    char* weightEnd = nullptr;
+    f32 weight = std::strtof(subCommands[2].c_str(), &weightEnd);
+    bool isNumber = weightEnd != subCommands[2].c_str() && *weightEnd == '\0';
+    u8 realmId = subCommands.size() == 4 ? static_cast<u8>(std::strtoul(subCommands[3].c_str(), nullptr, 10)) : 0;
+
+    // A weight of 0 would divide by zero in selection, use drain to stop assignments instead. NaN or infinity would break every score comparison
+    if (!isNumber || !std::isfinite(weight) || weight <= 0.0f)
+    {
+        output->PrintWarning("Weight must be a positive number, use drain to stop assignments");
+        return;
+    }
+
+    engineLoop.PassCommand([output, type, entity, realmId, weight](entt::registry& registry)
+    {
+        LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+        if (!loadBalanceSingleton.SetWeight(type, realmId, entity, weight))
+        {
+            output->PrintWarning("[LoadBalancer]: No %s server (Realm %u, Entity %u)", AddressTypeUtils::GetName(type), realmId, static_cast<u32>(entity));
+            return;
+        }
+
+        output->Print("[LoadBalancer]: %s server (Realm %u, Entity %u) weight set to %.2f", AddressTypeUtils::GetName(type), realmId, static_cast<u32>(entity), weight);
+    });
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+#include <Networking/NetworkPacket.h>
+#include "LoadBalanceSingleton.h"
+#include "../../../Network/AddressRequest.h"
+#include "../../../Utils/TraceFormat.h"
+
+// Largest SMSG_SEND_ADDRESS we write, header, status, address, port, lease, candidates and the echoed payload
+constexpr size_t ADDRESS_RESPONSE_MAX_SIZE = sizeof(Opcode) + sizeof(u16) + sizeof(u8) + sizeof(u32) + sizeof(u16) + sizeof(u32) + sizeof(u32) +
+    sizeof(u8) + ADDRESS_MAX_CANDIDATES * (sizeof(u32) + sizeof(u16)) + ADDRESS_REQUEST_MAX_SIZE;
+
+struct PendingAddressRequest
+{
+    std::shared_ptr<NetworkPacket> packet; // Owns the payload we echo back
+    AddressRequest request;
+    bool isValid = false;
+
+    // Filled in by the route stage
+    ServerInformation serverInformation;
+    AddressResponseTemplate responseTemplate;
+    u8 numCandidates = 0;
+    AddressCandidate candidates[ADDRESS_MAX_CANDIDATES];
+    u8 status = ADDRESS_STATUS_NOT_FOUND;
+    f32 leaseDuration = 0.0f;
+    u32 tableVersion = 0;
+
+    std::shared_ptr<TraceRecord> trace; // Set if RequestTracer sampled this request
+};
+
+/*
+    Address requests received this frame, they go through the update framework in stages.
+    Decode and encode are split into chunks and routing is split by routing shard, each part runs as its own task on the Taskflow workers.
+*/
+struct AddressRequestSingleton
+{
+    std::vector<PendingAddressRequest> requests;
+    std::vector<std::vector<u32>> shardRequests; // Indices into requests for every routing shard, in arrival order
+    std::vector<std::shared_ptr<Bytebuffer>> responseBuffers; // One per encode chunk
+
+    bool isOverloaded = false; // Set by ConnectionUpdateSystem, requests that reach us while congested are only told so
+
+    size_t numWorkers = 1;
+    size_t minChunkSize = 32; // Smaller batches aren't worth the scheduling overhead and run inline
+    size_t maxChunkSize = NETWORK_BUFFER_SIZE / ADDRESS_RESPONSE_MAX_SIZE; // A chunk's responses have to fit in one buffer
+
+    size_t GetChunkSize() const
+    {
+        size_t chunkSize = (requests.size() + numWorkers - 1) / numWorkers;
+        return std::min(std::max(chunkSize, minChunkSize), maxChunkSize);
+    }
+    size_t GetNumChunks() const
+    {
+        size_t chunkSize = GetChunkSize();
+        return (requests.size() + chunkSize - 1) / chunkSize;
+    }
+};
\ No newline at end of file
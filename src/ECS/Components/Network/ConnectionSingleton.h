@@ -1,13 +1,76 @@
 #pragma once
 #include <NovusTypes.h>
+#include <deque>
+#include <chrono>
+#include <atomic>
 #include <Utils/ConcurrentQueue.h>
 #include <Networking/NetworkPacket.h>
 #include <Networking/NetworkClient.h>
+#include "../../../Network/Transport.h"
+#include "../../../Utils/TimerWheel.h"
+#include "../../../Utils/TraceFormat.h"
 
+struct QueuedPacket
+{
+    std::shared_ptr<NetworkPacket> packet;
+    std::shared_ptr<TraceRecord> trace; // Only set for sampled address requests
+};
+
+struct BackpressureStatistics
+{
+    u64 episodes = 0;
+    f64 congestedTime = 0.0; // Seconds, finished episodes only
+    u64 deferredRequests = 0;
+    u64 overloadedRequests = 0; // Answered with ADDRESS_STATUS_OVERLOADED, or NOT_FOUND for legacy requesters
+    u64 droppedRequests = 0; // Past maxDeferredRequests after the episode's overloaded reply, never answered
+    size_t peakBytes = 0;
+    size_t peakBuffers = 0;
+};
+
+/*
+    Once more than sendQueueMaxBytes or sendQueueMaxBuffers wait in the transport, Novus-Service isn't reading our responses fast enough.
+    Address requests are then deferred instead of answered, up to maxDeferredRequests. The first one past that is told we are overloaded,
+    every reply would only add to the queue Novus-Service isn't reading, so the rest of the episode's overflow is dropped.
+    Everything else is still handled, and the congestion clears once the queue is back under half of both limits.
+*/
 struct ConnectionSingleton
 {
     ConnectionSingleton() : packetQueue(256) { }
 
     std::shared_ptr<NetworkClient> networkClient;
-    moodycamel::ConcurrentQueue<std::shared_ptr<NetworkPacket>> packetQueue;
+    std::string serviceAddress = "127.0.0.1"; // Novus-Service
+    u16 servicePort = 8000;
+    std::unique_ptr<Transport> transport;
+    moodycamel::ConcurrentQueue<QueuedPacket> packetQueue;
+
+    // Set from the asio thread when the connection drops or fails to connect, ConnectionUpdateSystem then schedules the reconnect reconnectDelay later
+    std::atomic<bool> isDisconnected = false;
+    f32 reconnectDelay = 1.0f;
+    TimerId reconnectTimer = TIMER_INVALID; // Armed while we wait to reconnect
+
+    // The trace of the packet whose handler is running, the handler signature has no room for it
+    std::shared_ptr<TraceRecord> currentTrace;
+
+    size_t sendQueueMaxBytes = 4 * 1024 * 1024;
+    size_t sendQueueMaxBuffers = 256;
+    size_t maxDeferredRequests = 4096;
+
+    bool isCongested = false;
+    bool hasSignaledOverload = false; // This congestion episode already sent its overloaded reply
+    std::chrono::steady_clock::time_point congestedSince;
+    SendQueueState sendQueue; // Sampled at the start of every frame
+    std::deque<QueuedPacket> deferredRequests;
+
+    // A packet that arrived after this frame's address requests and would change what they are routed against, it is handled first thing next frame
+    QueuedPacket heldPacket;
+    BackpressureStatistics backpressure;
+
+    f64 GetCongestedTime() const
+    {
+        f64 congestedTime = backpressure.congestedTime;
+        if (isCongested)
+            congestedTime += std::chrono::duration<f64>(std::chrono::steady_clock::now() - congestedSince).count();
+
+        return congestedTime;
+    }
 };
\ No newline at end of file
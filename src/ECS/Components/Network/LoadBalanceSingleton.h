@@ -3,6 +3,13 @@
 #include <Networking/AddressType.h>
 #include <entity/fwd.hpp>
 #include <vector>
+#include <deque>
+#include <cmath>
+#include <limits>
+#include "../../../Network/AddressRequest.h"
+#include "../../../Utils/AddressTypeUtils.h"
+#include "../../../Utils/RegionMap.h"
+#include "../../../Utils/TimerWheel.h"
 
 #pragma pack(push, 1)
 struct ServerInformation
@@ -14,10 +21,142 @@ struct ServerInformation
     u16 port = 0;
 };
 #pragma pack(pop)
+
+enum class ServerState : u8
+{
+    ACTIVE,
+    DRAINING // Gets no new assignments, but stays in the table so outstanding leases and reservations remain valid
+};
+
+// Routing state we keep next to the ServerInformation received from Novus-Service
+struct ServerEntry
+{
+    ServerEntry() { }
+    ServerEntry(const ServerInformation& inInfo, u32 inId, f32 inAddedTime) : info(inInfo), id(inId), addedTime(inAddedTime) { responseTemplate.Build(info.address, info.port); }
+
+    ServerInformation info;
+    AddressResponseTemplate responseTemplate; // Rebuilt whenever info changes
+    u32 id = 0; // Unique for the lifetime of the entry, leases reference this so a removed and re-added server doesn't inherit old leases
+    u32 activeLeases = 0;
+
+    ServerState state = ServerState::ACTIVE;
+    bool drainReported = false;
+    bool isSynced = true; // Cleared by BeginFullSync, entries still unsynced at EndFullSync are gone from Novus-Service
+
+    f32 addedTime = 0.0f;
+    f32 weight = 1.0f;
+
+    // Assignments handed out recently, decays with LoadBalanceSingleton::loadHalfLife
+    f32 recentAssignments = 0.0f;
+    f32 recentAssignmentsTime = 0.0f;
+
+    // Sum of the loads other load balancers reported for this server, see PeerUpdateSystem
+    f32 peerLoad = 0.0f;
+
+    u8 region = REGION_NONE; // Where regionMap places the server's address
+    f32 rtt = 0.0f; // Median connect time in milliseconds from RttUpdateSystem's backend probes, 0 until one succeeded
+
+    // Advertised by INSTANCE servers, in the same cost units the requests use
+    bool hasCapacity = false;
+    u32 capacity = 0;
+    u32 reservedCapacity = 0;
+    u32 capacityGeneration = 0; // Bumped on every advertisement, reservations made against an older advertisement are already accounted for
+
+    u32 GetFreeCapacity() const { return capacity > reservedCapacity ? capacity - reservedCapacity : 0; }
+
+    // Assignments clients may still act on, a draining server is safe to stop once this reaches 0
+    u32 GetOutstandingAssignments() const { return activeLeases + reservedCapacity; }
+    bool IsDrained() const { return state == ServerState::DRAINING && GetOutstandingAssignments() == 0; }
+};
+
+struct ServerLease
+{
+    u32 entryId = 0;
+    AddressType type = AddressType::INVALID;
+    u8 realmId = 0;
+    f32 expireTime = 0.0f;
+};
+
+// Seconds until the first and the last of a server's leases expire, replicated so a standby's leases run out when the active's do
+struct LeaseWindow
+{
+    f32 first = 0.0f;
+    f32 last = 0.0f;
+};
+
+struct CapacityReservation
+{
+    u32 entryId = 0;
+    u8 realmId = 0;
+    u32 capacityGeneration = 0;
+    u16 cost = 0;
+    f32 expireTime = 0.0f;
+};
+
+enum class PlacementPolicy : u8
+{
+    BEST_FIT, // Pack instances onto the fullest server that still fits them
+    WORST_FIT // Spread instances onto the emptiest server
+};
+
+struct SelectionParameters
+{
+    u8 realmId = 0;
+    f32 leaseDuration = 0.0f; // When above 0 the selected server is charged with a lease that counts towards its load until it expires
+    u16 cost = 1; // Expected size of the instance, only used for INSTANCE placement
+    u8 region = REGION_NONE; // The requester's region, its servers are preferred
+};
+
+struct RealmStatistics
+{
+    u64 requests = 0;
+    u64 failures = 0;
+    u64 unknownRealm = 0;
+};
+
+// How often requesters asked for alternates and, going by what they report on their next request, which server they ended up on
+struct CandidateStatistics
+{
+    u64 requests = 0;
+    u64 candidates = 0; // Alternates handed out
+    u64 primaryUsed = 0;
+    u64 alternateUsed = 0;
+    u64 noneConnected = 0;
+};
+
+// Requests that came with a region, and how many of them had to be sent to a server in another one
+struct RegionStatistics
+{
+    u64 requests = 0;
+    u64 remote = 0;
+};
+
+/*
+    The mutable state routing touches besides the server entries themselves.
+    Every (AddressType, realmId) belongs to exactly one shard, so requests for different shards can be routed concurrently.
+*/
+struct RoutingShard
+{
+    u32 activeLeases = 0;
+    std::deque<ServerLease> leases;
+    std::deque<CapacityReservation> reservations;
+    robin_hood::unordered_map<u8, RealmStatistics> realmStatistics;
+    CandidateStatistics candidateStatistics;
+    RegionStatistics regionStatistics;
+};
+
+struct ShardExpiryTimer
+{
+    TimerId timer = TIMER_INVALID;
+    f32 expireTime = 0.0f; // The lease or reservation the timer was armed for
+};
+
 struct LoadBalanceSingleton
 {
     LoadBalanceSingleton()
     {
+        _shards.resize(1);
+
         authServers.reserve(8);
         loadBalancers.reserve(8);
         regionServers.reserve(8);
@@ -32,207 +171,973 @@ struct LoadBalanceSingleton
         instanceServersMap.reserve(8);
         instanceServersIndex.reserve(8);
     }
-    
-    inline void Clear()
+
+    // How long a client may reuse an answer before it has to ask again
+    f32 leaseDuration = 30.0f;
+
+    // How INSTANCE servers that advertise capacity are chosen, and how long capacity stays reserved if the server never readvertises
+    PlacementPolicy placementPolicy = PlacementPolicy::WORST_FIT;
+    f32 reservationTimeout = 10.0f;
+
+    // Newly added servers ramp their weight from slowStartMinRamp up to full over slowStartDuration seconds, 0 disables the ramp
+    f32 slowStartDuration = 30.0f;
+    f32 slowStartMinRamp = 0.05f;
+
+    // How quickly past assignments stop counting towards a server's load
+    f32 loadHalfLife = 1.0f;
+
+    // One per shard, armed by LoadBalanceUpdateSystem at the shard's next expiry
+    std::vector<ShardExpiryTimer> expiryTimers;
+
+    u32 GetTableVersion() const { return _tableVersion; }
+    u32 GetNumActiveLeases() const
     {
-        authServers.clear();
-        loadBalancers.clear();
-        regionServers.clear();
-        chatServers.clear();
+        u32 activeLeases = 0;
+        for (const RoutingShard& shard : _shards)
+            activeLeases += shard.activeLeases;
 
-        realmServersMap.clear();
-        realmServersIndex.clear();
+        return activeLeases;
+    }
+    u64 GetNumRevokedLeases() const { return _revokedLeases; }
+    u32 GetNumDraining() const { return _numDraining; }
+    f32 GetLifeTime() const { return _lifeTime; }
 
-        worldServersMap.clear();
-        worldServersIndex.clear();
+    // Fraction of its weight a server gets while warming up, 1.0 once slowStartDuration has passed since it was added
+    inline f32 GetRamp(const ServerEntry& entry) const
+    {
+        if (slowStartDuration <= 0.0f)
+            return 1.0f;
 
-        instanceServersMap.clear();
-        instanceServersIndex.clear();
+        f32 ramp = (_lifeTime - entry.addedTime) / slowStartDuration;
+        return std::clamp(ramp, slowStartMinRamp, 1.0f);
     }
 
-    inline void Remove(AddressType type, entt::entity entity, u8 realmId = 0)
+    inline f32 GetEffectiveWeight(const ServerEntry& entry) const
+    {
+        return entry.weight * GetRamp(entry);
+    }
+
+    inline f32 GetRecentAssignments(const ServerEntry& entry) const
+    {
+        if (loadHalfLife <= 0.0f)
+            return 0.0f;
+
+        f32 elapsed = _lifeTime - entry.recentAssignmentsTime;
+        return entry.recentAssignments * std::exp2(-elapsed / loadHalfLife);
+    }
+
+    // Outstanding leases plus the decayed count of unleased assignments, this is what we report to our peers
+    inline f32 GetLocalLoad(const ServerEntry& entry) const
+    {
+        return static_cast<f32>(entry.activeLeases) + GetRecentAssignments(entry);
+    }
+
+    // Cluster wide view, our own load plus what the other load balancers are sending to the server
+    inline f32 GetLoad(const ServerEntry& entry) const
+    {
+        return GetLocalLoad(entry) + entry.peerLoad;
+    }
+
+    // Servers are placed when they are added, so this places the ones we already know about again
+    inline void SetRegionMap(const RegionMap& regionMap)
+    {
+        _regionMap = regionMap;
+        ForEach([this](AddressType type, u8 realmId, ServerEntry& entry)
+        {
+            entry.region = _regionMap.Find(entry.info.address);
+        });
+    }
+    inline const RegionMap& GetRegionMap() const { return _regionMap; }
+    inline u8 GetRegion(u32 address) const { return _regionMap.Find(address); }
+
+    // Applies a backend probe result to every entry of that host, a server registered for several realms has one entry per realm
+    inline void SetRtt(u32 address, u16 port, f32 rttMS)
+    {
+        ForEach([address, port, rttMS](AddressType type, u8 realmId, ServerEntry& entry)
+        {
+            if (entry.info.address == address && entry.info.port == port)
+                entry.rtt = rttMS;
+        });
+    }
+
+    // Visits every server as (AddressType, realmId, ServerEntry&)
+    template <typename Func>
+    inline void ForEach(Func&& func)
+    {
+        ForEachEntry(*this, func);
+    }
+    template <typename Func>
+    inline void ForEach(Func&& func) const
+    {
+        ForEachEntry(*this, func);
+    }
+
+    // REALM, WORLD and INSTANCE servers are partitioned per realm, every other type is shared by all realms
+    static constexpr bool IsRealmScoped(AddressType type)
+    {
+        return type == AddressType::REALM || type == AddressType::WORLD || type == AddressType::INSTANCE;
+    }
+
+    // Peers are the other load balancers Novus-Service told us about, datagrams from anywhere else are not trusted
+    inline bool IsPeer(u32 address, u16 port) const
     {
-        std::vector<ServerInformation>* serverInformations = nullptr;
+        return std::any_of(loadBalancers.begin(), loadBalancers.end(), [address, port](const ServerEntry& entry) { return entry.info.address == address && entry.info.port == port; });
+    }
+
+    // A realm is known for a type once Novus-Service has told us about at least one server of that type in it
+    inline bool HasRealm(AddressType type, u8 realmId)
+    {
+        return !IsRealmScoped(type) || GetServerEntries(type, realmId) != nullptr;
+    }
+
+    inline ServerEntry* FindServer(AddressType type, u8 realmId, entt::entity entity)
+    {
+        std::vector<ServerEntry>* serverEntries = GetServerEntries(type, realmId);
+        if (!serverEntries)
+            return nullptr;
+
+        auto itr = std::find_if(serverEntries->begin(), serverEntries->end(), [&entity](const ServerEntry& entry) -> bool { return entry.info.entity == entity; });
+        return itr != serverEntries->end() ? &(*itr) : nullptr;
+    }
+
+    inline bool SetState(AddressType type, u8 realmId, entt::entity entity, ServerState state)
+    {
+        ServerEntry* entry = FindServer(type, realmId, entity);
+        if (!entry)
+            return false;
+
+        if (entry->state != state)
+            _numDraining += state == ServerState::DRAINING ? 1 : -1;
+
+        entry->state = state;
+        entry->drainReported = false;
+        return true;
+    }
+
+    inline bool SetWeight(AddressType type, u8 realmId, entt::entity entity, f32 weight)
+    {
+        ServerEntry* entry = FindServer(type, realmId, entity);
+        if (!entry)
+            return false;
+
+        entry->weight = weight;
+        return true;
+    }
+
+    inline bool HasServers(AddressType type, u8 realmId)
+    {
+        std::vector<ServerEntry>* serverEntries = GetServerEntries(type, realmId);
+        return serverEntries && serverEntries->size();
+    }
+
+    inline RealmStatistics& GetRealmStatistics(u8 realmId) { return GetShard(AddressType::REALM, realmId).realmStatistics[realmId]; }
+    inline robin_hood::unordered_map<u8, RealmStatistics> GetAllRealmStatistics() const
+    {
+        // A realm only ever lives in one shard
+        robin_hood::unordered_map<u8, RealmStatistics> allRealmStatistics;
+        for (const RoutingShard& shard : _shards)
+            for (auto& [realmId, realmStatistics] : shard.realmStatistics)
+                allRealmStatistics[realmId] = realmStatistics;
+
+        return allRealmStatistics;
+    }
 
-        if (type == AddressType::AUTH)
+    inline CandidateStatistics& GetCandidateStatistics(AddressType type, u8 realmId) { return GetShard(type, realmId).candidateStatistics; }
+    inline RegionStatistics GetAllRegionStatistics() const
+    {
+        RegionStatistics allRegionStatistics;
+        for (const RoutingShard& shard : _shards)
         {
-            serverInformations = &authServers;
+            allRegionStatistics.requests += shard.regionStatistics.requests;
+            allRegionStatistics.remote += shard.regionStatistics.remote;
         }
-        else if (type == AddressType::LOADBALANCE)
+
+        return allRegionStatistics;
+    }
+
+    inline CandidateStatistics GetAllCandidateStatistics() const
+    {
+        CandidateStatistics allCandidateStatistics;
+        for (const RoutingShard& shard : _shards)
         {
-            serverInformations = &loadBalancers;
+            allCandidateStatistics.requests += shard.candidateStatistics.requests;
+            allCandidateStatistics.candidates += shard.candidateStatistics.candidates;
+            allCandidateStatistics.primaryUsed += shard.candidateStatistics.primaryUsed;
+            allCandidateStatistics.alternateUsed += shard.candidateStatistics.alternateUsed;
+            allCandidateStatistics.noneConnected += shard.candidateStatistics.noneConnected;
         }
-        else if (type == AddressType::REGION)
+
+        return allCandidateStatistics;
+    }
+
+    /*
+        Realm scoped types are sharded by realm, so a realm's REALM, WORLD and INSTANCE servers and its statistics share a shard.
+        Shared types are sharded by type. Only call this before any server is added.
+    */
+    inline void SetNumShards(size_t numShards)
+    {
+        _shards.clear();
+        _shards.resize(std::max<size_t>(numShards, 1));
+    }
+    inline size_t GetNumShards() const { return _shards.size(); }
+    inline size_t GetShardIndex(AddressType type, u8 realmId) const
+    {
+        return (IsRealmScoped(type) ? realmId : static_cast<size_t>(type)) % _shards.size();
+    }
+
+    // Sets the time and expires everything that ran out, for callers without a timer wheel like lbsim
+    inline void Update(f32 lifeTimeInS)
+    {
+        SetLifeTime(lifeTimeInS);
+
+        for (size_t i = 0; i < _shards.size(); i++)
         {
-            serverInformations = &regionServers;
+            Expire(i, lifeTimeInS);
         }
-        else if (type == AddressType::CHAT)
+    }
+
+    // New leases and reservations run out relative to this
+    inline void SetLifeTime(f32 lifeTimeInS) { _lifeTime = lifeTimeInS; }
+
+    // Expires the shard's leases and reservations that ran out by lifeTimeInS
+    inline void Expire(size_t shardIndex, f32 lifeTimeInS)
+    {
+        RoutingShard& shard = _shards[shardIndex];
+
+        // All leases share the same duration, so the queue is ordered by expireTime
+        while (shard.leases.size() && shard.leases.front().expireTime <= lifeTimeInS)
         {
-            serverInformations = &chatServers;
+            const ServerLease& lease = shard.leases.front();
+
+            if (ServerEntry* entry = FindEntry(lease.type, lease.realmId, lease.entryId))
+            {
+                entry->activeLeases--;
+                shard.activeLeases--;
+            }
+
+            shard.leases.pop_front();
         }
-        else if (type == AddressType::REALM)
+
+        while (shard.reservations.size() && shard.reservations.front().expireTime <= lifeTimeInS)
         {
-            serverInformations = &realmServersMap[realmId];
+            const CapacityReservation& reservation = shard.reservations.front();
+
+            ServerEntry* entry = FindEntry(AddressType::INSTANCE, reservation.realmId, reservation.entryId);
+            if (entry && entry->capacityGeneration == reservation.capacityGeneration)
+            {
+                entry->reservedCapacity -= std::min<u32>(entry->reservedCapacity, reservation.cost);
+            }
+
+            shard.reservations.pop_front();
         }
-        else if (type == AddressType::WORLD)
+    }
+
+    // When the shard's next lease or reservation runs out, infinity if it has none
+    inline f32 GetNextExpiry(size_t shardIndex) const
+    {
+        const RoutingShard& shard = _shards[shardIndex];
+
+        f32 nextExpiry = std::numeric_limits<f32>::infinity();
+        if (shard.leases.size())
+            nextExpiry = shard.leases.front().expireTime;
+
+        if (shard.reservations.size())
+            nextExpiry = std::min(nextExpiry, shard.reservations.front().expireTime);
+
+        return nextExpiry;
+    }
+
+    /*
+        An instance server advertising its free capacity also confirms every instance we placed on it so far,
+        the advertised value already accounts for them so outstanding reservations are dropped.
+    */
+    inline bool SetCapacity(u8 realmId, entt::entity entity, u32 capacity)
+    {
+        ServerEntry* entry = FindServer(AddressType::INSTANCE, realmId, entity);
+        if (!entry)
+            return false;
+
+        entry->hasCapacity = true;
+        entry->capacity = capacity;
+        entry->reservedCapacity = 0;
+        entry->capacityGeneration++;
+        return true;
+    }
+
+    /*
+        A full sync from Novus-Service is applied as a diff, servers that are still there keep their leases, drain state and slow start progress.
+        Call Add for every server in the sync between BeginFullSync and EndFullSync.
+    */
+    inline void BeginFullSync()
+    {
+        ForEach([](AddressType type, u8 realmId, ServerEntry& entry)
+        {
+            entry.isSynced = false;
+        });
+    }
+    inline void EndFullSync()
+    {
+        std::vector<std::pair<AddressType, ServerInformation>> removed;
+        ForEach([&removed](AddressType type, u8 realmId, ServerEntry& entry)
+        {
+            if (!entry.isSynced)
+                removed.push_back({ type, entry.info });
+        });
+
+        for (auto& [type, info] : removed)
+        {
+            Remove(type, info.entity, info.realmId);
+        }
+    }
+
+    // Keyed by ServerEntry::id, servers without leases are left out
+    inline void GetLeaseWindows(robin_hood::unordered_map<u32, LeaseWindow>& leaseWindows) const
+    {
+        for (const RoutingShard& shard : _shards)
         {
-            serverInformations = &worldServersMap[realmId];
+            // The queue is ordered by expireTime, the first lease we see of an entry is the first to expire
+            for (const ServerLease& lease : shard.leases)
+            {
+                f32 remaining = std::max(lease.expireTime - _lifeTime, 0.0f);
+
+                auto itr = leaseWindows.find(lease.entryId);
+                if (itr == leaseWindows.end())
+                    leaseWindows[lease.entryId] = { remaining, remaining };
+                else
+                    itr->second.last = remaining;
+            }
         }
-        else if (type == AddressType::INSTANCE)
+    }
+
+    /*
+        Replaces the whole table with state replicated from the active load balancer, leaseWindows holds one window per entry.
+        Leases are replicated as a count and a window, and spread evenly over it since they were handed out at a steady rate as far as we know.
+        Only reservation totals are replicated, so they are recreated as if they had just been made.
+    */
+    inline void Restore(std::vector<ServerEntry>& serverEntries, const std::vector<LeaseWindow>& leaseWindows, u32 tableVersion)
+    {
+        ClearServers();
+        ClearShards();
+
+        for (size_t entryIndex = 0; entryIndex < serverEntries.size(); entryIndex++)
         {
-            serverInformations = &instanceServersMap[realmId];
+            ServerEntry& entry = serverEntries[entryIndex];
+            const LeaseWindow& leaseWindow = leaseWindows[entryIndex];
+
+            entry.id = _nextEntryId++;
+            entry.region = _regionMap.Find(entry.info.address);
+            entry.responseTemplate.Build(entry.info.address, entry.info.port);
+            RoutingShard& shard = GetShard(entry.info.type, entry.info.realmId);
+
+            for (u32 i = 0; i < entry.activeLeases; i++)
+            {
+                ServerLease& lease = shard.leases.emplace_back();
+                lease.entryId = entry.id;
+                lease.type = entry.info.type;
+                lease.realmId = entry.info.realmId;
+
+                f32 spread = entry.activeLeases > 1 ? static_cast<f32>(i) / (entry.activeLeases - 1) : 1.0f;
+                lease.expireTime = _lifeTime + leaseWindow.first + (leaseWindow.last - leaseWindow.first) * spread;
+            }
+            shard.activeLeases += entry.activeLeases;
+
+            if (entry.reservedCapacity)
+            {
+                CapacityReservation& reservation = shard.reservations.emplace_back();
+                reservation.entryId = entry.id;
+                reservation.realmId = entry.info.realmId;
+                reservation.capacityGeneration = entry.capacityGeneration;
+                reservation.cost = static_cast<u16>(std::min<u32>(entry.reservedCapacity, std::numeric_limits<u16>::max()));
+                reservation.expireTime = _lifeTime + reservationTimeout;
+            }
+
+            if (entry.state == ServerState::DRAINING)
+                _numDraining++;
+
+            GetOrCreateServerEntries(entry.info.type, entry.info.realmId).push_back(entry);
         }
 
-        auto itr = std::find_if(serverInformations->begin(), serverInformations->end(), [&entity](const ServerInformation& info) -> bool { return info.entity == entity; });
-        if (itr != serverInformations->end())
+        // Every server's leases were appended on their own, Expire and GetNextExpiry expect each queue ordered by expireTime
+        for (RoutingShard& shard : _shards)
         {
-            serverInformations->erase(itr);
+            std::sort(shard.leases.begin(), shard.leases.end(), [](const ServerLease& a, const ServerLease& b) { return a.expireTime < b.expireTime; });
+        }
+
+        _tableVersion = tableVersion;
+    }
+
+    inline void Clear()
+    {
+        ClearServers();
+
+        // Every entry is gone so every outstanding lease is revoked, the version bump tells clients their cached answers are stale
+        _revokedLeases += GetNumActiveLeases();
+        ClearShards();
+        _tableVersion++;
+    }
+
+    inline void Remove(AddressType type, entt::entity entity, u8 realmId = 0)
+    {
+        std::vector<ServerEntry>* serverEntries = GetServerEntries(type, realmId);
+        if (!serverEntries)
+            return;
+
+        auto itr = std::find_if(serverEntries->begin(), serverEntries->end(), [&entity](const ServerEntry& entry) -> bool { return entry.info.entity == entity; });
+        if (itr != serverEntries->end())
+        {
+            // Leases pointing at this entry are revoked early, they will be skipped when they reach the front of the queue
+            _revokedLeases += itr->activeLeases;
+            GetShard(type, realmId).activeLeases -= itr->activeLeases;
+            _tableVersion++;
+
+            if (itr->state == ServerState::DRAINING)
+                _numDraining--;
+
+            serverEntries->erase(itr);
         }
     }
     
     template <AddressType type>
     inline void Add(ServerInformation info)
     {
+        _tableVersion++;
+
+        // Novus-Service resends servers whose information changed, update those in place so they keep their routing state
+        if (std::vector<ServerEntry>* serverEntries = GetServerEntries<type>(info.realmId))
+        {
+            auto itr = std::find_if(serverEntries->begin(), serverEntries->end(), [&info](const ServerEntry& entry) -> bool { return entry.info.entity == info.entity; });
+            if (itr != serverEntries->end())
+            {
+                itr->info = info;
+                itr->region = _regionMap.Find(info.address);
+                itr->responseTemplate.Build(info.address, info.port);
+                itr->isSynced = true;
+                return;
+            }
+        }
+
+        // A server that moved to another realm is still listed under its old one, it must stop being routed there
+        if constexpr (IsRealmScoped(type))
+        {
+            robin_hood::unordered_map<u8, std::vector<ServerEntry>>& serversMap = type == AddressType::REALM ? realmServersMap : type == AddressType::WORLD ? worldServersMap : instanceServersMap;
+            for (auto& [realmId, serverEntries] : serversMap)
+            {
+                bool isListed = std::any_of(serverEntries.begin(), serverEntries.end(), [&info](const ServerEntry& entry) { return entry.info.entity == info.entity; });
+                if (realmId != info.realmId && isListed)
+                {
+                    Remove(type, info.entity, realmId);
+                    break;
+                }
+            }
+        }
+
+        ServerEntry entry(info, _nextEntryId++, _lifeTime);
+        entry.region = _regionMap.Find(info.address);
+
         if constexpr (type == AddressType::AUTH)
         {
-            authServers.emplace_back(info);
+            authServers.emplace_back(entry);
         }
         else if constexpr (type == AddressType::LOADBALANCE)
         {
-            loadBalancers.emplace_back(info);
+            loadBalancers.emplace_back(entry);
         }
         else if constexpr (type == AddressType::REGION)
         {
-            regionServers.emplace_back(info);
+            regionServers.emplace_back(entry);
         }
         else if constexpr (type == AddressType::CHAT)
         {
-            chatServers.emplace_back(info);
+            chatServers.emplace_back(entry);
         }
         else if constexpr (type == AddressType::REALM)
         {
             if (realmServersMap.find(info.realmId) == realmServersMap.end())
             {
-                realmServersMap[info.realmId] = std::vector<ServerInformation>();
+                realmServersMap[info.realmId] = std::vector<ServerEntry>();
                 realmServersMap[info.realmId].reserve(8);
-                realmServersIndex.push_back(0);
+                realmServersIndex[info.realmId] = 0;
             }
 
-            realmServersMap[info.realmId].push_back(info);
+            realmServersMap[info.realmId].push_back(entry);
         }
         else if constexpr (type == AddressType::WORLD)
         {
             if (worldServersMap.find(info.realmId) == worldServersMap.end())
             {
-                worldServersMap[info.realmId] = std::vector<ServerInformation>();
+                worldServersMap[info.realmId] = std::vector<ServerEntry>();
                 worldServersMap[info.realmId].reserve(8);
+                worldServersIndex[info.realmId] = 0;
             }
 
-            worldServersMap[info.realmId].push_back(info);
+            worldServersMap[info.realmId].push_back(entry);
         }
         else if constexpr (type == AddressType::INSTANCE)
         {
             if (instanceServersMap.find(info.realmId) == instanceServersMap.end())
             {
-                instanceServersMap[info.realmId] = std::vector<ServerInformation>();
+                instanceServersMap[info.realmId] = std::vector<ServerEntry>();
                 instanceServersMap[info.realmId].reserve(8);
+                instanceServersIndex[info.realmId] = 0;
             }
 
-            instanceServersMap[info.realmId].push_back(info);
+            instanceServersMap[info.realmId].push_back(entry);
         }
     }
+
     template <AddressType type>
-    inline bool Get(ServerInformation& serverInformation, u8 realmId = 0)
+    inline bool Get(ServerInformation& serverInformation, const SelectionParameters& parameters = SelectionParameters(), AddressResponseTemplate* responseTemplate = nullptr)
     {
+        ServerEntry* entry = nullptr;
+
         if constexpr (type == AddressType::AUTH)
         {
-            size_t numOf = authServers.size();
-            if (numOf == 0)
+            entry = SelectNearest(authServers, authIndex, parameters.region);
+        }
+        else if constexpr (type == AddressType::LOADBALANCE)
+        {
+            entry = SelectNearest(loadBalancers, loadBalanceIndex, parameters.region);
+        }
+        else if constexpr (type == AddressType::REGION)
+        {
+            entry = SelectNearest(regionServers, regionIndex, parameters.region);
+        }
+        else if constexpr (type == AddressType::CHAT)
+        {
+            entry = SelectNearest(chatServers, chatIndex, parameters.region);
+        }
+        else if constexpr (IsRealmScoped(type))
+        {
+            // Look the realm up without inserting, requests for realms we have never seen must not grow the maps
+            std::vector<ServerEntry>* serverEntries = GetServerEntries<type>(parameters.realmId);
+            if (!serverEntries)
                 return false;
 
-            serverInformation = authServers[authIndex++];
+            if constexpr (type == AddressType::INSTANCE)
+            {
+                u8& index = GetRealmIndex(type, parameters.realmId);
+                entry = PickNearest(*serverEntries, parameters.region, [this, serverEntries, &index, &parameters](auto filter)
+                {
+                    return Place(*serverEntries, index, parameters, filter);
+                });
+            }
+            else
+            {
+                entry = SelectNearest(*serverEntries, GetRealmIndex(type, parameters.realmId), parameters.region);
+            }
+        }
+
+        if (!entry)
+            return false;
 
-            // Wrap index around if needed
-            if (authIndex == numOf)
-                authIndex = 0;
+        serverInformation = entry->info;
+        if (responseTemplate)
+            *responseTemplate = entry->responseTemplate;
+
+        if (parameters.region != REGION_NONE)
+        {
+            RegionStatistics& regionStatistics = GetShard(type, parameters.realmId).regionStatistics;
+            regionStatistics.requests++;
+            regionStatistics.remote += entry->region != parameters.region;
         }
-        else if constexpr (type == AddressType::LOADBALANCE)
+
+        if (parameters.leaseDuration <= 0.0f)
         {
-            size_t numOf = loadBalancers.size();
-            if (numOf == 0)
-                return false;
+            entry->recentAssignments = GetRecentAssignments(*entry) + 1.0f;
+            entry->recentAssignmentsTime = _lifeTime;
+        }
+        else
+        {
+            RoutingShard& shard = GetShard(type, parameters.realmId);
 
-            serverInformation = loadBalancers[loadBalanceIndex++];
+            ServerLease& lease = shard.leases.emplace_back();
+            lease.entryId = entry->id;
+            lease.type = type;
+            lease.realmId = parameters.realmId;
+            lease.expireTime = _lifeTime + parameters.leaseDuration;
 
-            // Wrap index around if needed
-            if (loadBalanceIndex == numOf)
-                loadBalanceIndex = 0;
+            entry->activeLeases++;
+            shard.activeLeases++;
         }
-        else if constexpr (type == AddressType::REGION)
+
+        return true;
+    }
+
+    // Add<type> for info.type, which has to be a valid type
+    inline void Add(const ServerInformation& info)
+    {
+        AddressTypeUtils::Dispatch(info.type, [this, &info](auto typeConstant)
         {
-            size_t numOf = regionServers.size();
-            if (numOf == 0)
-                return false;
+            Add<decltype(typeConstant)::value>(info);
+        });
+    }
+
+    // Get<type> for a type only known at runtime, which has to be a valid type
+    inline bool Get(AddressType type, ServerInformation& serverInformation, const SelectionParameters& parameters = SelectionParameters(), AddressResponseTemplate* responseTemplate = nullptr)
+    {
+        return AddressTypeUtils::Dispatch(type, [this, &serverInformation, &parameters, responseTemplate](auto typeConstant)
+        {
+            return Get<decltype(typeConstant)::value>(serverInformation, parameters, responseTemplate);
+        });
+    }
+
+    /*
+        Ranks the servers the active policy would have picked after the selected one, best first.
+        They are not charged a lease, reservation or assignment, a requester only falls back to them when the selected server doesn't answer in time.
+    */
+    inline u8 GetCandidates(AddressType type, const SelectionParameters& parameters, entt::entity selected, AddressCandidate* candidates, u8 maxCandidates)
+    {
+        maxCandidates = std::min(maxCandidates, ADDRESS_MAX_CANDIDATES);
+
+        std::vector<ServerEntry>* serverEntries = GetServerEntries(type, parameters.realmId);
+        if (!serverEntries || maxCandidates == 0)
+            return 0;
+
+        // Lower tier first, then lower score. INSTANCE servers that fit the cost come before the ones that never advertised, like in Place
+        struct RankedEntry
+        {
+            u8 tier;
+            f32 score;
+            const ServerEntry* entry;
+        };
+
+        RankedEntry ranked[ADDRESS_MAX_CANDIDATES];
+        u8 numRanked = 0;
+
+        u8 nearestRegion = GetNearestRegion(*serverEntries, parameters.region);
+
+        for (const ServerEntry& entry : *serverEntries)
+        {
+            if (entry.state != ServerState::ACTIVE || entry.info.entity == selected)
+                continue;
+
+            // Regions rank in the order PickNearest tries them, each one below every server of the one before
+            u8 regionTier = GetRegionTier(entry, parameters.region, nearestRegion);
+            RankedEntry rankedEntry = { static_cast<u8>(regionTier * 2), 0.0f, &entry };
+            if (type == AddressType::INSTANCE && entry.hasCapacity)
+            {
+                u32 freeCapacity = entry.GetFreeCapacity();
+                if (freeCapacity < parameters.cost)
+                    continue;
+
+                rankedEntry.score = placementPolicy == PlacementPolicy::BEST_FIT ? static_cast<f32>(freeCapacity) : -static_cast<f32>(freeCapacity);
+            }
+            else
+            {
+                f32 effectiveWeight = GetEffectiveWeight(entry);
+                if (effectiveWeight <= 0.0f)
+                    continue;
+
+                rankedEntry.tier += type == AddressType::INSTANCE ? 1 : 0;
+                rankedEntry.score = (GetLoad(entry) + 1.0f) / effectiveWeight;
+            }
+
+            u8 position = numRanked;
+            while (position > 0 && (rankedEntry.tier < ranked[position - 1].tier || (rankedEntry.tier == ranked[position - 1].tier && rankedEntry.score < ranked[position - 1].score)))
+                position--;
 
-            serverInformation = regionServers[regionIndex++];
+            if (position >= maxCandidates)
+                continue;
 
-            // Wrap index around if needed
-            if (regionIndex == numOf)
-                regionIndex = 0;
+            for (u8 i = std::min<u8>(numRanked, maxCandidates - 1); i > position; i--)
+                ranked[i] = ranked[i - 1];
+
+            ranked[position] = rankedEntry;
+            numRanked = std::min<u8>(numRanked + 1, maxCandidates);
         }
-        else if constexpr (type == AddressType::CHAT)
+
+        for (u8 i = 0; i < numRanked; i++)
         {
-            size_t numOf = chatServers.size();
-            if (numOf == 0)
-                return false;
+            candidates[i].address = ranked[i].entry->info.address;
+            candidates[i].port = ranked[i].entry->info.port;
+        }
 
-            serverInformation = chatServers[chatIndex++];
+        return numRanked;
+    }
+
+private:
+    inline RoutingShard& GetShard(AddressType type, u8 realmId) { return _shards[GetShardIndex(type, realmId)]; }
 
-            // Wrap index around if needed
-            if (chatIndex == numOf)
-                chatIndex = 0;
+    inline void ClearShards()
+    {
+        for (RoutingShard& shard : _shards)
+        {
+            shard.activeLeases = 0;
+            shard.leases.clear();
+            shard.reservations.clear();
         }
-        else if constexpr (type == AddressType::REALM)
+    }
+
+    inline void ClearServers()
+    {
+        _numDraining = 0;
+        authServers.clear();
+        loadBalancers.clear();
+        regionServers.clear();
+        chatServers.clear();
+
+        realmServersMap.clear();
+        realmServersIndex.clear();
+
+        worldServersMap.clear();
+        worldServersIndex.clear();
+
+        instanceServersMap.clear();
+        instanceServersIndex.clear();
+    }
+
+    inline std::vector<ServerEntry>& GetOrCreateServerEntries(AddressType type, u8 realmId)
+    {
+        if (std::vector<ServerEntry>* serverEntries = GetServerEntries(type, realmId))
+            return *serverEntries;
+
+        // Only realm scoped types can be missing
+        robin_hood::unordered_map<u8, std::vector<ServerEntry>>& serversMap = type == AddressType::REALM ? realmServersMap : type == AddressType::WORLD ? worldServersMap : instanceServersMap;
+
+        std::vector<ServerEntry>& serverEntries = serversMap[realmId];
+        serverEntries.reserve(8);
+        GetRealmIndex(type, realmId) = 0;
+
+        return serverEntries;
+    }
+
+    template <typename Self, typename Func>
+    static void ForEachEntry(Self& self, Func& func)
+    {
+        for (auto& entry : self.authServers)
+            func(AddressType::AUTH, u8(0), entry);
+        for (auto& entry : self.loadBalancers)
+            func(AddressType::LOADBALANCE, u8(0), entry);
+        for (auto& entry : self.regionServers)
+            func(AddressType::REGION, u8(0), entry);
+        for (auto& entry : self.chatServers)
+            func(AddressType::CHAT, u8(0), entry);
+
+        for (auto& [realmId, serverEntries] : self.realmServersMap)
+            for (auto& entry : serverEntries)
+                func(AddressType::REALM, realmId, entry);
+        for (auto& [realmId, serverEntries] : self.worldServersMap)
+            for (auto& entry : serverEntries)
+                func(AddressType::WORLD, realmId, entry);
+        for (auto& [realmId, serverEntries] : self.instanceServersMap)
+            for (auto& entry : serverEntries)
+                func(AddressType::INSTANCE, realmId, entry);
+    }
+
+    static bool AcceptAll(const ServerEntry&) { return true; }
+
+    /*
+        Picks the server with the lowest load relative to its effective weight, starting at the round-robin cursor so ties keep round-robin order.
+        Recent assignments count as load, so equally weighted servers still alternate while ramping servers get a share that follows their weight.
+    */
+    template <typename Filter = decltype(&AcceptAll)>
+    inline ServerEntry* Select(std::vector<ServerEntry>& serverEntries, u8& index, Filter filter = &AcceptAll)
+    {
+        size_t numOf = serverEntries.size();
+        if (numOf == 0)
+            return nullptr;
+
+        size_t selected = numOf;
+        f32 selectedScore = 0.0f;
+        for (size_t i = 0; i < numOf; i++)
         {
-            size_t numOf = realmServersMap[realmId].size();
-            if (numOf == 0)
-                return false;
+            size_t candidate = (index + i) % numOf;
+            const ServerEntry& entry = serverEntries[candidate];
+            if (entry.state != ServerState::ACTIVE || !filter(entry))
+                continue;
 
-            u8& index = realmServersIndex[realmId];
-            serverInformation = realmServersMap[realmId][index++];
+            f32 effectiveWeight = GetEffectiveWeight(entry);
+            if (effectiveWeight <= 0.0f)
+                continue;
 
-            // Wrap index around if needed
-            if (index == numOf)
-                index = 0;
+            f32 score = (GetLoad(entry) + 1.0f) / effectiveWeight;
+            if (selected == numOf || score < selectedScore)
+            {
+                selected = candidate;
+                selectedScore = score;
+            }
         }
-        else if constexpr (type == AddressType::WORLD)
+
+        if (selected == numOf)
+            return nullptr;
+
+        // Wrap index around if needed
+        index = static_cast<u8>((selected + 1) % numOf);
+        return &serverEntries[selected];
+    }
+
+    // The region whose servers answered our probes fastest, other than the requester's own
+    inline u8 GetNearestRegion(const std::vector<ServerEntry>& serverEntries, u8 region) const
+    {
+        if (region == REGION_NONE)
+            return REGION_NONE;
+
+        u8 nearestRegion = REGION_NONE;
+        f32 nearestRtt = 0.0f;
+        for (const ServerEntry& entry : serverEntries)
         {
-            size_t numOf = worldServersMap[realmId].size();
-            if (numOf == 0)
-                return false;
+            if (entry.state != ServerState::ACTIVE || entry.region == region || entry.region == REGION_NONE || entry.rtt <= 0.0f)
+                continue;
 
-            u8& index = worldServersIndex[realmId];
-            serverInformation = worldServersMap[realmId][index++];
+            if (nearestRegion == REGION_NONE || entry.rtt < nearestRtt)
+            {
+                nearestRegion = entry.region;
+                nearestRtt = entry.rtt;
+            }
+        }
+
+        return nearestRegion;
+    }
 
-            // Wrap index around if needed
-            if (index == numOf)
-                index = 0;
+    // 0 for the requester's region, 1 for the nearest one and 2 for every other server, the order PickNearest tries them in
+    static u8 GetRegionTier(const ServerEntry& entry, u8 region, u8 nearestRegion)
+    {
+        if (region == REGION_NONE || entry.region == region)
+            return 0;
+
+        return nearestRegion != REGION_NONE && entry.region == nearestRegion ? 1 : 2;
+    }
+
+    /*
+        Runs pick(filter) on the requester's region first. Only when nothing there can take the request it moves on to the region
+        whose servers answered our probes fastest, and then to every server. Requesters without a region pick from every server.
+    */
+    template <typename Pick>
+    inline ServerEntry* PickNearest(std::vector<ServerEntry>& serverEntries, u8 region, Pick pick)
+    {
+        if (region == REGION_NONE)
+            return pick(&AcceptAll);
+
+        if (ServerEntry* entry = pick([region](const ServerEntry& entry) { return entry.region == region; }))
+            return entry;
+
+        u8 nearestRegion = GetNearestRegion(serverEntries, region);
+        if (nearestRegion != REGION_NONE)
+        {
+            if (ServerEntry* entry = pick([nearestRegion](const ServerEntry& entry) { return entry.region == nearestRegion; }))
+                return entry;
         }
-        else if constexpr (type == AddressType::INSTANCE)
+
+        return pick(&AcceptAll);
+    }
+
+    inline ServerEntry* SelectNearest(std::vector<ServerEntry>& serverEntries, u8& index, u8 region)
+    {
+        return PickNearest(serverEntries, region, [this, &serverEntries, &index](auto filter)
         {
-            size_t numOf = instanceServersMap[realmId].size();
-            if (numOf == 0)
-                return false;
+            return Select(serverEntries, index, filter);
+        });
+    }
 
-            u8& index = instanceServersIndex[realmId];
-            serverInformation = instanceServersMap[realmId][index++];
+    /*
+        Bin-packs instances onto the servers that advertise capacity and reserves the cost on the chosen one,
+        servers that never advertised are only used when none of the advertising ones can fit the instance.
+    */
+    template <typename Filter = decltype(&AcceptAll)>
+    inline ServerEntry* Place(std::vector<ServerEntry>& serverEntries, u8& index, const SelectionParameters& parameters, Filter filter = &AcceptAll)
+    {
+        ServerEntry* selected = nullptr;
+        for (ServerEntry& entry : serverEntries)
+        {
+            if (entry.state != ServerState::ACTIVE || !entry.hasCapacity || !filter(entry))
+                continue;
 
-            // Wrap index around if needed
-            if (index == numOf)
-                index = 0;
+            u32 freeCapacity = entry.GetFreeCapacity();
+            if (freeCapacity < parameters.cost)
+                continue;
+
+            if (!selected ||
+                (placementPolicy == PlacementPolicy::BEST_FIT && freeCapacity < selected->GetFreeCapacity()) ||
+                (placementPolicy == PlacementPolicy::WORST_FIT && freeCapacity > selected->GetFreeCapacity()))
+            {
+                selected = &entry;
+            }
         }
 
-        return true;
+        if (!selected)
+            return Select(serverEntries, index, [&filter](const ServerEntry& entry) { return !entry.hasCapacity && filter(entry); });
+
+        selected->reservedCapacity += parameters.cost;
+
+        CapacityReservation& reservation = GetShard(AddressType::INSTANCE, parameters.realmId).reservations.emplace_back();
+        reservation.entryId = selected->id;
+        reservation.realmId = parameters.realmId;
+        reservation.capacityGeneration = selected->capacityGeneration;
+        reservation.cost = parameters.cost;
+        reservation.expireTime = _lifeTime + reservationTimeout;
+
+        return selected;
+    }
+
+    template <AddressType type>
+    inline std::vector<ServerEntry>* GetServerEntries(u8 realmId)
+    {
+        if constexpr (type == AddressType::AUTH)
+        {
+            return &authServers;
+        }
+        else if constexpr (type == AddressType::LOADBALANCE)
+        {
+            return &loadBalancers;
+        }
+        else if constexpr (type == AddressType::REGION)
+        {
+            return &regionServers;
+        }
+        else if constexpr (type == AddressType::CHAT)
+        {
+            return &chatServers;
+        }
+        else if constexpr (type == AddressType::REALM)
+        {
+            auto itr = realmServersMap.find(realmId);
+            return itr != realmServersMap.end() ? &itr->second : nullptr;
+        }
+        else if constexpr (type == AddressType::WORLD)
+        {
+            auto itr = worldServersMap.find(realmId);
+            return itr != worldServersMap.end() ? &itr->second : nullptr;
+        }
+        else if constexpr (type == AddressType::INSTANCE)
+        {
+            auto itr = instanceServersMap.find(realmId);
+            return itr != instanceServersMap.end() ? &itr->second : nullptr;
+        }
+
+        return nullptr;
+    }
+
+    // Console commands and peers can name any type, so this one checks before dispatching
+    inline std::vector<ServerEntry>* GetServerEntries(AddressType type, u8 realmId)
+    {
+        if (type < AddressType::AUTH || type >= AddressType::COUNT)
+            return nullptr;
+
+        return AddressTypeUtils::Dispatch(type, [this, realmId](auto typeConstant)
+        {
+            return GetServerEntries<decltype(typeConstant)::value>(realmId);
+        });
+    }
+
+    // Routing shards call this concurrently, the cursor is created together with the realm's entries so lookups from Get never insert
+    inline u8& GetRealmIndex(AddressType type, u8 realmId)
+    {
+        if (type == AddressType::REALM)
+            return realmServersIndex[realmId];
+        else if (type == AddressType::WORLD)
+            return worldServersIndex[realmId];
+
+        return instanceServersIndex[realmId];
+    }
+
+    inline ServerEntry* FindEntry(AddressType type, u8 realmId, u32 entryId)
+    {
+        std::vector<ServerEntry>* serverEntries = GetServerEntries(type, realmId);
+        if (!serverEntries)
+            return nullptr;
+
+        auto itr = std::find_if(serverEntries->begin(), serverEntries->end(), [&entryId](const ServerEntry& entry) -> bool { return entry.id == entryId; });
+        return itr != serverEntries->end() ? &(*itr) : nullptr;
     }
 
 private:
@@ -241,16 +1146,24 @@ private:
     u8 regionIndex = 0;
     u8 chatIndex = 0;
 
-    std::vector<ServerInformation> authServers;
-    std::vector<ServerInformation> loadBalancers;
-    std::vector<ServerInformation> regionServers;
-    std::vector<ServerInformation> chatServers;
+    std::vector<ServerEntry> authServers;
+    std::vector<ServerEntry> loadBalancers;
+    std::vector<ServerEntry> regionServers;
+    std::vector<ServerEntry> chatServers;
+
+    robin_hood::unordered_map<u8, u8> realmServersIndex;
+    robin_hood::unordered_map<u8, u8> worldServersIndex;
+    robin_hood::unordered_map<u8, u8> instanceServersIndex;
 
-    std::vector<u8> realmServersIndex;
-    std::vector<u8> worldServersIndex;
-    std::vector<u8> instanceServersIndex;
+    robin_hood::unordered_map<u8, std::vector<ServerEntry>> realmServersMap;
+    robin_hood::unordered_map<u8, std::vector<ServerEntry>> worldServersMap;
+    robin_hood::unordered_map<u8, std::vector<ServerEntry>> instanceServersMap;
 
-    robin_hood::unordered_map<u8, std::vector<ServerInformation>> realmServersMap;
-    robin_hood::unordered_map<u8, std::vector<ServerInformation>> worldServersMap;
-    robin_hood::unordered_map<u8, std::vector<ServerInformation>> instanceServersMap;
+    f32 _lifeTime = 0.0f;
+    u32 _tableVersion = 0;
+    u32 _numDraining = 0; // Servers in ServerState::DRAINING, kept so the drain report only walks the table while there are any
+    u32 _nextEntryId = 0;
+    u64 _revokedLeases = 0;
+    std::vector<RoutingShard> _shards;
+    RegionMap _regionMap;
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/AddressType.h>
+#include "../../../Network/PeerSocket.h"
+#include "../../../Utils/TimerWheel.h"
+
+struct PeerServerLoad
+{
+    u32 entity = 0;
+    AddressType type = AddressType::INVALID;
+    u8 realmId = 0;
+    f32 load = 0.0f;
+    f32 reportTime = 0.0f;
+};
+
+struct PeerState
+{
+    // Keyed by (entity << 16 | type << 8 | realmId), reports may only cover part of the table so every server ages on its own
+    robin_hood::unordered_map<u64, PeerServerLoad> loads;
+};
+
+struct PeerSingleton
+{
+    std::shared_ptr<PeerSocket> socket;
+    u32 localAddress = 0; // Set once we are registered with Novus-Service, used to skip ourselves in the load balancer list
+
+    f32 gossipInterval = 0.25f;
+    f32 peerTimeout = 1.0f; // Reports older than this no longer count, bounds how stale the cluster wide view can get
+    size_t gossipBudget = PEER_DATAGRAM_SIZE; // Bytes sent to each peer per interval, servers that don't fit are sent on the next interval
+
+    TimerId gossipTimer = TIMER_INVALID;
+    size_t gossipCursor = 0;
+
+    // Keyed by (address << 16 | port) of the peer
+    robin_hood::unordered_map<u64, PeerState> peers;
+};
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+#include "LoadBalanceSingleton.h"
+#include "../../../Utils/TimerWheel.h"
+
+enum class ReplicationRole : u8
+{
+    NONE,
+    ACTIVE, // Streams its routing state to the standby every heartbeat
+    STANDBY // Authenticates with Novus-Service but only registers once the active load balancer stops sending heartbeats
+};
+
+/*
+    Every takeover starts a new epoch, and every snapshot carries the epoch of its sender.
+    When both halves end up active, e.g. after a partition heals, the one with the lower epoch steps down, the higher address:port wins a tie.
+*/
+
+struct ReplicationSingleton
+{
+    ReplicationRole role = ReplicationRole::NONE;
+
+    // The other half of the pair, snapshots are sent over the PeerSocket
+    u32 partnerAddress = 0;
+    u16 partnerPort = 0;
+
+    f32 heartbeatInterval = 0.2f;
+    f32 failoverTimeout = 0.5f; // Longer than one heartbeat on purpose, a single lost or late datagram shouldn't cause a takeover
+
+    u32 epoch = 0;
+
+    TimerId heartbeatTimer = TIMER_INVALID; // Repeating, only sends while we are active
+    TimerId failoverTimer = TIMER_INVALID; // Armed while we are standby, for when the partner's heartbeat would time out
+    f32 lastHeartbeatTime = 0.0f;
+    u32 snapshotId = 0;
+    u64 snapshotsApplied = 0;
+
+    // Set by AuthHandlers when a standby holds back CMSG_CONNECTED, promotion sends it
+    bool isAwaitingRegistration = false;
+
+    // Chunks of the snapshot currently being received
+    u32 pendingSnapshotId = 0;
+    u32 pendingTableVersion = 0;
+    std::vector<bool> pendingChunks;
+    std::vector<ServerEntry> pendingEntries;
+    std::vector<LeaseWindow> pendingLeaseWindows; // One per pending entry
+
+    void ClearPending()
+    {
+        pendingChunks.clear();
+        pendingEntries.clear();
+        pendingLeaseWindows.clear();
+    }
+};
\ No newline at end of file
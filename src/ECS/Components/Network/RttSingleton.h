@@ -0,0 +1,143 @@
+#pragma once
+#include <NovusTypes.h>
+#include <asio.hpp>
+#include <array>
+#include <algorithm>
+#include <Utils/ConcurrentQueue.h>
+#include "../../../Utils/TimerWheel.h"
+
+enum class RttTargetKind : u8
+{
+    SERVICE, // Novus-Service, sampled from the kernel's view of the upstream connection
+    PEER,    // Other load balancers, PING/PONG over the peer socket
+    BACKEND  // Registered servers or anything given to "ping ip:port", timed TCP handshakes
+};
+
+constexpr size_t RTT_WINDOW_SIZE = 256;
+
+// The last RTT_WINDOW_SIZE samples of one target, min, avg and p99 are over the window so an old spike doesn't stick
+struct RttStatistics
+{
+    std::array<f32, RTT_WINDOW_SIZE> samples = { };
+    size_t numSamples = 0; // Total, the window holds min(numSamples, RTT_WINDOW_SIZE) of them
+    u64 numFailures = 0;
+    f32 lastSample = 0.0f;
+
+    void AddSample(f32 rttMS)
+    {
+        samples[numSamples % RTT_WINDOW_SIZE] = rttMS;
+        numSamples++;
+        lastSample = rttMS;
+    }
+
+    size_t GetWindowSize() const { return std::min(numSamples, RTT_WINDOW_SIZE); }
+
+    f32 GetMin() const
+    {
+        size_t windowSize = GetWindowSize();
+        return windowSize ? *std::min_element(samples.begin(), samples.begin() + windowSize) : 0.0f;
+    }
+
+    f32 GetAverage() const
+    {
+        size_t windowSize = GetWindowSize();
+        if (!windowSize)
+            return 0.0f;
+
+        f32 total = 0.0f;
+        for (size_t i = 0; i < windowSize; i++)
+        {
+            total += samples[i];
+        }
+
+        return total / windowSize;
+    }
+
+    // Nearest rank, linear in the window. Called by the console and once per backend probe result, never per request
+    f32 GetPercentile(f32 percentile) const
+    {
+        size_t windowSize = GetWindowSize();
+        if (!windowSize)
+            return 0.0f;
+
+        std::array<f32, RTT_WINDOW_SIZE> sorted;
+        std::copy_n(samples.begin(), windowSize, sorted.begin());
+        size_t rank = std::min(static_cast<size_t>(percentile * windowSize), windowSize - 1);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + windowSize);
+        return sorted[rank];
+    }
+};
+
+struct RttTarget
+{
+    RttTargetKind kind = RttTargetKind::SERVICE;
+    u32 address = 0;
+    u16 port = 0;
+    RttStatistics statistics;
+
+    u64 pendingPing = 0; // Send time of an unanswered peer PING, still set at the next ping means it was lost
+};
+
+// Measurements finished on the asio thread, applied by RttUpdateSystem
+struct RttProbeResult
+{
+    RttTargetKind kind = RttTargetKind::BACKEND;
+    u32 address = 0;
+    u16 port = 0;
+    bool success = false;
+    f32 rttMS = 0.0f;
+};
+
+struct RttSingleton
+{
+    RttSingleton() : probeResults(64) { }
+
+    std::shared_ptr<asio::io_service> asioService;
+
+    f32 sampleInterval = 1.0f; // Novus-Service samples and peer pings, 0 disables both
+    f32 backendProbeInterval = 0.0f; // Every registered server, off by default since each probe is a connection the server sees
+    u32 probeTimeout = 1000; // MS, a probe or ping without an answer by then counts as a failure
+
+    TimerId sampleTimer = TIMER_INVALID;
+    TimerId backendProbeTimer = TIMER_INVALID;
+
+    moodycamel::ConcurrentQueue<RttProbeResult> probeResults;
+
+    // Keyed by (kind << 48 | address << 16 | port)
+    robin_hood::unordered_map<u64, RttTarget> targets;
+
+    static u64 GetTargetKey(RttTargetKind kind, u32 address, u16 port)
+    {
+        return (static_cast<u64>(kind) << 48) | (static_cast<u64>(address) << 16) | port;
+    }
+
+    // Creates the target, only for ones we measure ourselves
+    RttTarget& GetTarget(RttTargetKind kind, u32 address, u16 port)
+    {
+        RttTarget& target = targets[GetTargetKey(kind, address, port)];
+        target.kind = kind;
+        target.address = address;
+        target.port = port;
+        return target;
+    }
+
+    // For anything a datagram names, a spoofed source must not grow the map
+    RttTarget* FindTarget(RttTargetKind kind, u32 address, u16 port)
+    {
+        auto itr = targets.find(GetTargetKey(kind, address, port));
+        return itr != targets.end() ? &itr->second : nullptr;
+    }
+
+    void AddResult(const RttProbeResult& result)
+    {
+        RttStatistics& statistics = GetTarget(result.kind, result.address, result.port).statistics;
+        if (result.success)
+        {
+            statistics.AddSample(result.rttMS);
+        }
+        else
+        {
+            statistics.numFailures++;
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#include <NovusTypes.h>
+#include "../../../Utils/SharedTableWriter.h"
+#include "../../../Utils/TimerWheel.h"
+
+/*
+    The routing table as published to processes on the same host, see SharedTableFormat.h. Only open when shm.name is set.
+    Server adds and removes are applied to the shared copy in place by their handlers, the loads change with every assignment and the ones that did are rewritten every refreshInterval.
+*/
+struct SharedTableSingleton
+{
+    SharedTableWriter writer;
+
+    f32 refreshInterval = 0.1f;
+    TimerId refreshTimer = TIMER_INVALID;
+    u32 publishedVersion = 0; // The table version the shared copy matches, any other version is republished in full
+
+    std::vector<SharedTableEntry> entries; // Kept between refreshes so they don't allocate
+};
\ No newline at end of file
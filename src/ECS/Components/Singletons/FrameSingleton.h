@@ -0,0 +1,137 @@
+#pragma once
+#include <NovusTypes.h>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <Networking/Opcode.h>
+
+// The parts of a frame that are timed for the stall report, the systems can run at the same time
+enum class FrameStage : u8
+{
+    MESSAGES,
+    COMMANDS,
+    TIMERS,
+    CONNECTION,
+    ADDRESS_REQUEST_DECODE,
+    ADDRESS_REQUEST_ROUTE,
+    ADDRESS_RESPONSE_ENCODE,
+    ADDRESS_RESPONSE_SEND,
+    LOAD_BALANCE,
+    PEER,
+    REPLICATION,
+    RTT,
+    SHARED_TABLE,
+    COUNT
+};
+
+inline const char* GetFrameStageName(FrameStage stage)
+{
+    constexpr const char* names[] = { "Messages", "Commands", "Timers", "ConnectionUpdateSystem", "AddressRequestDecodeSystem", "AddressRequestRouteSystem",
+        "AddressResponseEncodeSystem", "AddressResponseSendSystem", "LoadBalanceUpdateSystem", "PeerUpdateSystem", "ReplicationUpdateSystem", "RttUpdateSystem", "SharedTableUpdateSystem" };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(FrameStage::COUNT));
+
+    return stage < FrameStage::COUNT ? names[static_cast<size_t>(stage)] : "Unknown";
+}
+
+// Bucket i counts frames that took [2^i, 2^(i+1)) microseconds, the last bucket takes everything longer
+constexpr size_t FRAME_HISTOGRAM_BUCKETS = 24;
+
+struct FrameHistogram
+{
+    std::array<u64, FRAME_HISTOGRAM_BUCKETS> buckets = { };
+    u64 numFrames = 0;
+    f32 maxFrameTime = 0.0f; // MS
+
+    void Add(f32 frameTimeMS)
+    {
+        u64 frameTimeUS = static_cast<u64>(frameTimeMS * 1000.0f);
+
+        size_t bucket = 0;
+        while (bucket < FRAME_HISTOGRAM_BUCKETS - 1 && (frameTimeUS >> (bucket + 1)) != 0)
+        {
+            bucket++;
+        }
+
+        buckets[bucket]++;
+        numFrames++;
+        maxFrameTime = std::max(maxFrameTime, frameTimeMS);
+    }
+
+    // Upper bound of the bucket the percentile falls in, in MS
+    f32 GetPercentile(f32 percentile) const
+    {
+        u64 rank = static_cast<u64>(percentile * numFrames);
+        u64 count = 0;
+
+        for (size_t i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+        {
+            count += buckets[i];
+            if (count > rank)
+                return std::min(static_cast<f32>(2ull << i) / 1000.0f, maxFrameTime);
+        }
+
+        return maxFrameTime;
+    }
+};
+
+// What a single frame did, reset when it starts and reported when it turns out to be a stall
+struct FrameDiagnostics
+{
+    std::array<f32, static_cast<size_t>(FrameStage::COUNT)> stageTimes = { }; // MS, every stage has its own slot so the workers never share one
+    std::array<std::chrono::steady_clock::time_point, static_cast<size_t>(FrameStage::COUNT)> stageStartTimes = { };
+
+    size_t inputQueueDepth = 0;
+    size_t commandQueueDepth = 0;
+    size_t packetQueueDepth = 0;
+
+    u32 numPackets = 0;
+    u32 numAddressRequests = 0; // Set by AddressResponseSendSystem, the requests are cleared before the frame ends
+    Opcode lastOpcode = Opcode::INVALID;
+    Opcode slowestOpcode = Opcode::INVALID; // The packet whose handler took the longest
+    f32 slowestHandlerTime = 0.0f; // MS
+};
+
+struct FrameSingleton
+{
+    FrameHistogram histogram;
+    FrameDiagnostics diagnostics;
+
+    f32 stallThreshold = 0.1f; // Frames that take longer are counted and reported with their diagnostics
+    f32 watchdogTimeout = 1.0f; // A frame still running after this is reported by the watchdog thread while it hangs, 0 disables it
+    f32 reportInterval = 1.0f; // Stalls are always counted but reported at most this often, a slow stretch would flood the log otherwise
+
+    u64 numStalls = 0;
+    u64 numSuppressedStalls = 0;
+    f32 lastReportTime = -1000.0f;
+
+    // Read by the watchdog thread
+    std::atomic<u64> frameNumber = 0;
+    std::atomic<i64> frameStartTime = 0; // Steady clock NS, 0 while the engine is idle between frames
+    std::atomic<u32> activeStages = 0; // One bit per FrameStage
+
+    // Times a stage of the current frame and marks it as running for the watchdog, a stage is begun and ended once per frame
+    void BeginStage(FrameStage stage)
+    {
+        diagnostics.stageStartTimes[static_cast<size_t>(stage)] = std::chrono::steady_clock::now();
+        activeStages.fetch_or(1u << static_cast<u32>(stage));
+    }
+
+    void EndStage(FrameStage stage)
+    {
+        activeStages.fetch_and(~(1u << static_cast<u32>(stage)));
+        diagnostics.stageTimes[static_cast<size_t>(stage)] = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - diagnostics.stageStartTimes[static_cast<size_t>(stage)]).count();
+    }
+};
+
+// For stages that are done when their scope ends, stages that fan out into a subflow are ended by the task that follows them
+class FrameStageScope
+{
+public:
+    FrameStageScope(FrameSingleton& frameSingleton, FrameStage stage) : _frameSingleton(frameSingleton), _stage(stage) { _frameSingleton.BeginStage(_stage); }
+    ~FrameStageScope() { _frameSingleton.EndStage(_stage); }
+
+private:
+    FrameSingleton& _frameSingleton;
+    FrameStage _stage;
+};
\ No newline at end of file
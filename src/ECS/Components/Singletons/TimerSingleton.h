@@ -0,0 +1,9 @@
+#pragma once
+#include <NovusTypes.h>
+#include "../../../Utils/TimerWheel.h"
+
+// Not thread safe, timers fire on the engine thread and are armed by systems the frame runs one after the other. Periodic and deadline work is scheduled here instead of being checked every frame
+struct TimerSingleton
+{
+    TimerWheel wheel;
+};
\ No newline at end of file
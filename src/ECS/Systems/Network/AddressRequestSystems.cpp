@@ -0,0 +1,301 @@
+#include "AddressRequestSystems.h"
+#include <entt.hpp>
+#include <taskflow/taskflow.hpp>
+#include <Networking/NetworkClient.h>
+#include <Networking/PacketUtils.h>
+#include "../../Components/Network/ConnectionSingleton.h"
+#include "../../Components/Network/LoadBalanceSingleton.h"
+#include "../../Components/Network/AddressRequestSingleton.h"
+#include "../../Components/Singletons/FrameSingleton.h"
+#include "../../../Utils/BufferPool.h"
+#include "../../../Utils/RequestTracer.h"
+#include <tracy/Tracy.hpp>
+
+// Calls func(chunkIndex, begin, end) for every chunk of the batch, a batch that fits in one chunk runs inline
+template <typename Func>
+static void ForEachChunk(AddressRequestSingleton& addressRequestSingleton, tf::Subflow& subflow, Func func)
+{
+    size_t numRequests = addressRequestSingleton.requests.size();
+    size_t chunkSize = addressRequestSingleton.GetChunkSize();
+    size_t numChunks = addressRequestSingleton.GetNumChunks();
+
+    if (numChunks == 1)
+    {
+        func(0, 0, numRequests);
+        return;
+    }
+
+    for (size_t chunk = 0; chunk < numChunks; chunk++)
+    {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(begin + chunkSize, numRequests);
+
+        subflow.emplace([func, chunk, begin, end]()
+        {
+            func(chunk, begin, end);
+        });
+    }
+}
+
+static void Route(LoadBalanceSingleton& loadBalanceSingleton, PendingAddressRequest& pendingRequest, bool isOverloaded)
+{
+    const AddressRequest& request = pendingRequest.request;
+
+    // Picking a server would charge it for a requester that was told to go elsewhere
+    if (isOverloaded)
+    {
+        pendingRequest.status = request.IsExtended() ? ADDRESS_STATUS_OVERLOADED : ADDRESS_STATUS_NOT_FOUND;
+        pendingRequest.tableVersion = loadBalanceSingleton.GetTableVersion();
+
+        if (pendingRequest.trace)
+        {
+            pendingRequest.trace->status = pendingRequest.status;
+            RequestTracer::Mark(*pendingRequest.trace, TraceStage::ROUTE);
+        }
+        return;
+    }
+
+    SelectionParameters parameters;
+    parameters.realmId = request.realmId;
+    parameters.leaseDuration = request.HasFlag(ADDRESS_REQUEST_FLAG_LEASE) ? loadBalanceSingleton.leaseDuration : 0.0f;
+    parameters.cost = request.cost;
+    parameters.region = request.HasFlag(ADDRESS_REQUEST_FLAG_SOURCE) ? loadBalanceSingleton.GetRegion(request.sourceAddress) : REGION_NONE;
+
+    ServerInformation& serverInformation = pendingRequest.serverInformation;
+    loadBalanceSingleton.Get(request.type, serverInformation, parameters, &pendingRequest.responseTemplate);
+
+    u8 status = ADDRESS_STATUS_SUCCESS;
+
+    // If the load balancer couldn't find a valid server, we send status 0 back
+    if (serverInformation.type == AddressType::INVALID)
+    {
+        status = ADDRESS_STATUS_NOT_FOUND;
+
+        // Tell extended requesters why, the realm was never registered, or it has servers that could not take the request
+        if (request.IsExtended())
+        {
+            if (!loadBalanceSingleton.HasRealm(request.type, request.realmId))
+                status = ADDRESS_STATUS_UNKNOWN_REALM;
+            else if (loadBalanceSingleton.HasServers(request.type, request.realmId))
+                status = ADDRESS_STATUS_NO_CAPACITY;
+        }
+    }
+
+    if (LoadBalanceSingleton::IsRealmScoped(request.type))
+    {
+        RealmStatistics& realmStatistics = loadBalanceSingleton.GetRealmStatistics(request.realmId);
+        realmStatistics.requests++;
+        realmStatistics.failures += status != ADDRESS_STATUS_SUCCESS;
+        realmStatistics.unknownRealm += !loadBalanceSingleton.HasRealm(request.type, request.realmId);
+    }
+
+    if (status == ADDRESS_STATUS_SUCCESS && request.numCandidates)
+    {
+        pendingRequest.numCandidates = loadBalanceSingleton.GetCandidates(request.type, parameters, serverInformation.entity, pendingRequest.candidates, request.numCandidates);
+    }
+
+    if (request.HasFlag(ADDRESS_REQUEST_FLAG_CANDIDATES) || request.HasFlag(ADDRESS_REQUEST_FLAG_RACE_RESULT))
+    {
+        CandidateStatistics& candidateStatistics = loadBalanceSingleton.GetCandidateStatistics(request.type, request.realmId);
+        candidateStatistics.requests += request.HasFlag(ADDRESS_REQUEST_FLAG_CANDIDATES);
+        candidateStatistics.candidates += pendingRequest.numCandidates;
+
+        // The race result is about the requester's previous answer, it tells us whether handing out alternates pays off
+        if (request.HasFlag(ADDRESS_REQUEST_FLAG_RACE_RESULT))
+        {
+            if (request.raceResult == 0)
+                candidateStatistics.primaryUsed++;
+            else if (request.raceResult == ADDRESS_RACE_NONE)
+                candidateStatistics.noneConnected++;
+            else
+                candidateStatistics.alternateUsed++;
+        }
+    }
+
+    pendingRequest.status = status;
+    pendingRequest.leaseDuration = parameters.leaseDuration;
+    pendingRequest.tableVersion = loadBalanceSingleton.GetTableVersion();
+
+    if (pendingRequest.trace)
+    {
+        pendingRequest.trace->status = status;
+        RequestTracer::Mark(*pendingRequest.trace, TraceStage::ROUTE);
+    }
+}
+
+static bool Encode(std::shared_ptr<Bytebuffer>& buffer, PendingAddressRequest& pendingRequest)
+{
+    const AddressRequest& request = pendingRequest.request;
+    std::shared_ptr<Bytebuffer>& payload = pendingRequest.packet->payload;
+
+    if (pendingRequest.status == ADDRESS_STATUS_SUCCESS)
+    {
+        u32 leaseDurationMS = static_cast<u32>(pendingRequest.leaseDuration * 1000);
+        return pendingRequest.responseTemplate.Write(buffer, request, leaseDurationMS, pendingRequest.tableVersion, payload->GetReadPointer(), payload->GetReadSpace(), pendingRequest.candidates, pendingRequest.numCandidates);
+    }
+
+    if (request.IsExtended())
+    {
+        AddressResponse response;
+        response.status = pendingRequest.status;
+        response.address = pendingRequest.serverInformation.address;
+        response.port = pendingRequest.serverInformation.port;
+
+        // A failed lookup is never cached, leaseDurationMS stays 0
+        response.tableVersion = pendingRequest.tableVersion;
+
+        return response.Serialize(buffer, request, payload->GetReadPointer(), payload->GetReadSpace());
+    }
+
+    return PacketUtils::Write_SMSG_SEND_ADDRESS(buffer, pendingRequest.status, pendingRequest.serverInformation.address, pendingRequest.serverInformation.port, payload->GetReadPointer(), payload->GetReadSpace());
+}
+
+void AddressRequestDecodeSystem::Update(entt::registry& registry, tf::Subflow& subflow)
+{
+    ZoneScopedNC("AddressRequestDecodeSystem::Update", tracy::Color::Blue)
+    AddressRequestSingleton& addressRequestSingleton = registry.ctx<AddressRequestSingleton>();
+
+    ForEachChunk(addressRequestSingleton, subflow, [&addressRequestSingleton](size_t chunk, size_t begin, size_t end)
+    {
+        ZoneScopedNC("AddressRequestDecodeSystem::Chunk", tracy::Color::Blue)
+        for (size_t i = begin; i < end; i++)
+        {
+            PendingAddressRequest& pendingRequest = addressRequestSingleton.requests[i];
+            pendingRequest.isValid = pendingRequest.request.Deserialize(pendingRequest.packet->payload);
+
+            if (pendingRequest.trace)
+            {
+                pendingRequest.trace->addressType = static_cast<u8>(pendingRequest.request.type);
+                pendingRequest.trace->flags = pendingRequest.request.flags;
+                RequestTracer::Mark(*pendingRequest.trace, TraceStage::DECODE);
+            }
+        }
+    });
+}
+
+void AddressRequestRouteSystem::Update(entt::registry& registry, tf::Subflow& subflow)
+{
+    ZoneScopedNC("AddressRequestRouteSystem::Update", tracy::Color::Blue)
+    AddressRequestSingleton& addressRequestSingleton = registry.ctx<AddressRequestSingleton>();
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    // Dispatch every request to the shard that owns its (AddressType, realmId), shards share no mutable routing state
+    std::vector<std::vector<u32>>& shardRequests = addressRequestSingleton.shardRequests;
+    shardRequests.resize(loadBalanceSingleton.GetNumShards());
+
+    size_t numActiveShards = 0;
+    for (u32 i = 0; i < addressRequestSingleton.requests.size(); i++)
+    {
+        // A malformed request closes the connection, like its handler used to, nothing that arrived after it is answered
+        if (!addressRequestSingleton.requests[i].isValid)
+        {
+            for (u32 j = i + 1; j < addressRequestSingleton.requests.size(); j++)
+            {
+                addressRequestSingleton.requests[j].isValid = false;
+            }
+            break;
+        }
+
+        const PendingAddressRequest& pendingRequest = addressRequestSingleton.requests[i];
+
+        std::vector<u32>& requestIndices = shardRequests[loadBalanceSingleton.GetShardIndex(pendingRequest.request.type, pendingRequest.request.realmId)];
+        numActiveShards += requestIndices.empty();
+        requestIndices.push_back(i);
+    }
+
+    auto routeShard = [&addressRequestSingleton, &loadBalanceSingleton](std::vector<u32>& requestIndices)
+    {
+        ZoneScopedNC("AddressRequestRouteSystem::Shard", tracy::Color::Blue)
+        for (u32 index : requestIndices)
+        {
+            Route(loadBalanceSingleton, addressRequestSingleton.requests[index], addressRequestSingleton.isOverloaded);
+        }
+
+        requestIndices.clear();
+    };
+
+    for (std::vector<u32>& requestIndices : shardRequests)
+    {
+        if (requestIndices.empty())
+            continue;
+
+        // With a single busy shard there is nothing to run in parallel
+        if (numActiveShards == 1)
+        {
+            routeShard(requestIndices);
+            continue;
+        }
+
+        subflow.emplace([routeShard, &requestIndices]()
+        {
+            routeShard(requestIndices);
+        });
+    }
+}
+
+void AddressResponseEncodeSystem::Update(entt::registry& registry, tf::Subflow& subflow)
+{
+    ZoneScopedNC("AddressResponseEncodeSystem::Update", tracy::Color::Blue)
+    AddressRequestSingleton& addressRequestSingleton = registry.ctx<AddressRequestSingleton>();
+
+    addressRequestSingleton.responseBuffers.resize(addressRequestSingleton.GetNumChunks());
+
+    // Every chunk writes its responses back to back into one buffer, so a chunk costs a single send
+    ForEachChunk(addressRequestSingleton, subflow, [&addressRequestSingleton](size_t chunk, size_t begin, size_t end)
+    {
+        ZoneScopedNC("AddressResponseEncodeSystem::Chunk", tracy::Color::Blue)
+        std::shared_ptr<Bytebuffer> buffer = BufferPool::Borrow((end - begin) * ADDRESS_RESPONSE_MAX_SIZE);
+
+        for (size_t i = begin; i < end; i++)
+        {
+            PendingAddressRequest& pendingRequest = addressRequestSingleton.requests[i];
+            if (pendingRequest.isValid)
+                pendingRequest.isValid = Encode(buffer, pendingRequest);
+
+            if (pendingRequest.trace && pendingRequest.isValid)
+                RequestTracer::Mark(*pendingRequest.trace, TraceStage::ENCODE);
+        }
+
+        addressRequestSingleton.responseBuffers[chunk] = buffer;
+    });
+}
+
+void AddressResponseSendSystem::Update(entt::registry& registry)
+{
+    ZoneScopedNC("AddressResponseSendSystem::Update", tracy::Color::Blue)
+    AddressRequestSingleton& addressRequestSingleton = registry.ctx<AddressRequestSingleton>();
+
+    if (addressRequestSingleton.requests.empty())
+        return;
+
+    ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+    bool isBroken = !connectionSingleton.transport->Send(connectionSingleton.networkClient, addressRequestSingleton.responseBuffers);
+
+    // Stages a request never reached stay 0, an invalid request stops after decode
+    for (PendingAddressRequest& pendingRequest : addressRequestSingleton.requests)
+    {
+        if (!pendingRequest.trace)
+            continue;
+
+        if (pendingRequest.isValid && !isBroken)
+            RequestTracer::Mark(*pendingRequest.trace, TraceStage::SEND);
+
+        RequestTracer::Submit(*pendingRequest.trace);
+    }
+
+    // Requests before a malformed one are answered before the connection is closed
+    bool hasInvalidRequest = isBroken || std::any_of(addressRequestSingleton.requests.begin(), addressRequestSingleton.requests.end(), [](const PendingAddressRequest& pendingRequest)
+    {
+        return !pendingRequest.isValid;
+    });
+
+    if (hasInvalidRequest)
+    {
+        connectionSingleton.networkClient->Close(asio::error::shut_down);
+    }
+
+    registry.ctx<FrameSingleton>().diagnostics.numAddressRequests = static_cast<u32>(addressRequestSingleton.requests.size());
+
+    addressRequestSingleton.requests.clear();
+    addressRequestSingleton.responseBuffers.clear();
+}
\ No newline at end of file
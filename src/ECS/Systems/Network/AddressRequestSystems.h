@@ -0,0 +1,32 @@
+#pragma once
+#include <entity/fwd.hpp>
+
+namespace tf
+{
+class Subflow;
+}
+
+// The stages every MSG_REQUEST_ADDRESS goes through, GeneralHandlers only queues the packets into the AddressRequestSingleton
+class AddressRequestDecodeSystem
+{
+public:
+    static void Update(entt::registry& registry, tf::Subflow& subflow);
+};
+
+class AddressRequestRouteSystem
+{
+public:
+    static void Update(entt::registry& registry, tf::Subflow& subflow);
+};
+
+class AddressResponseEncodeSystem
+{
+public:
+    static void Update(entt::registry& registry, tf::Subflow& subflow);
+};
+
+class AddressResponseSendSystem
+{
+public:
+    static void Update(entt::registry& registry);
+};
\ No newline at end of file
@@ -4,48 +4,243 @@
 #include <Networking/NetworkServer.h>
 #include "../../Components/Network/ConnectionSingleton.h"
 #include "../../Components/Network/AuthenticationSingleton.h"
+#include "../../Components/Network/AddressRequestSingleton.h"
+#include "../../Components/Singletons/FrameSingleton.h"
+#include "../../Components/Singletons/TimerSingleton.h"
 #include "../../../Utils/ServiceLocator.h"
+#include "../../../Utils/Logger.h"
+#include "../../../Utils/BufferPool.h"
+#include "../../../Utils/WakeEvent.h"
+#include "../../../Utils/RequestTracer.h"
 #include <tracy/Tracy.hpp>
 
+// Runs the packet's handler, false means the connection was closed
+static bool HandlePacket(ConnectionSingleton& connectionSingleton, FrameDiagnostics& diagnostics, MessageHandler* networkMessageHandler, QueuedPacket& queuedPacket)
+{
+    std::shared_ptr<NetworkPacket>& packet = queuedPacket.packet;
+    if (Logger::IsVerbose())
+    {
+        Logger::PrintSuccess("[Network/Socket]: CMD: %u, Size: %u", packet->header.opcode, packet->header.size);
+    }
+
+    // Kept for the stall report, a single slow handler is the usual suspect
+    Opcode opcode = packet->header.opcode;
+    diagnostics.numPackets++;
+    diagnostics.lastOpcode = opcode;
+
+    std::chrono::steady_clock::time_point handlerStartTime = std::chrono::steady_clock::now();
+    connectionSingleton.currentTrace = std::move(queuedPacket.trace);
+    bool handled = networkMessageHandler->CallHandler(connectionSingleton.networkClient, packet);
+    connectionSingleton.currentTrace = nullptr;
+
+    f32 handlerTime = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - handlerStartTime).count();
+    if (handlerTime > diagnostics.slowestHandlerTime)
+    {
+        diagnostics.slowestHandlerTime = handlerTime;
+        diagnostics.slowestOpcode = opcode;
+    }
+
+    if (!handled)
+    {
+        connectionSingleton.networkClient->Close(asio::error::shut_down);
+        return false;
+    }
+
+    return true;
+}
+
+// Samples the transport's send queue, congestion starts at the limits and clears under half of them so we don't flap at the edge
+static void UpdateCongestion(ConnectionSingleton& connectionSingleton)
+{
+    SendQueueState& sendQueue = connectionSingleton.sendQueue;
+    sendQueue = connectionSingleton.transport->GetSendQueue(connectionSingleton.networkClient);
+
+    BackpressureStatistics& backpressure = connectionSingleton.backpressure;
+    backpressure.peakBytes = std::max(backpressure.peakBytes, sendQueue.bytes);
+    backpressure.peakBuffers = std::max(backpressure.peakBuffers, sendQueue.buffers);
+
+    if (!connectionSingleton.isCongested)
+    {
+        if (sendQueue.bytes < connectionSingleton.sendQueueMaxBytes && sendQueue.buffers < connectionSingleton.sendQueueMaxBuffers)
+            return;
+
+        connectionSingleton.isCongested = true;
+        connectionSingleton.hasSignaledOverload = false;
+        connectionSingleton.congestedSince = std::chrono::steady_clock::now();
+        backpressure.episodes++;
+
+        Logger::PrintWarning("[Network]: Novus-Service isn't keeping up, %llu bytes in %llu buffers waiting to be sent, deferring address requests", static_cast<u64>(sendQueue.bytes), static_cast<u64>(sendQueue.buffers));
+    }
+    else
+    {
+        if (sendQueue.bytes > connectionSingleton.sendQueueMaxBytes / 2 || sendQueue.buffers > connectionSingleton.sendQueueMaxBuffers / 2)
+            return;
+
+        f64 congestedTime = std::chrono::duration<f64>(std::chrono::steady_clock::now() - connectionSingleton.congestedSince).count();
+        connectionSingleton.isCongested = false;
+        backpressure.congestedTime += congestedTime;
+
+        Logger::Print("[Network]: Send queue drained after %.3f s, answering %llu deferred address requests", congestedTime, static_cast<u64>(connectionSingleton.deferredRequests.size()));
+    }
+}
+
+static void Reconnect(entt::registry& registry);
+
+static void ScheduleReconnect(entt::registry& registry)
+{
+    ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+    if (connectionSingleton.reconnectTimer != TIMER_INVALID)
+        return;
+
+    entt::registry* registryPointer = &registry;
+    connectionSingleton.reconnectTimer = registry.ctx<TimerSingleton>().wheel.Schedule(static_cast<u64>(connectionSingleton.reconnectDelay * 1000.0f), [registryPointer]()
+    {
+        Reconnect(*registryPointer);
+    });
+}
+
+// Runs off the timer wheel, an attempt that fails right away waits another reconnectDelay
+static void Reconnect(entt::registry& registry)
+{
+    ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+    connectionSingleton.reconnectTimer = TIMER_INVALID;
+
+    Logger::Print("[Network]: Reconnecting to Novus-Service (%s:%u)", connectionSingleton.serviceAddress.c_str(), connectionSingleton.servicePort);
+
+    if (!connectionSingleton.transport->Connect(connectionSingleton.networkClient, connectionSingleton.serviceAddress, connectionSingleton.servicePort))
+        ScheduleReconnect(registry);
+}
+
+// Nothing received on a connection may be answered on the next one, Novus-Service has forgotten those requesters
+static void EndSession(entt::registry& registry, ConnectionSingleton& connectionSingleton)
+{
+    QueuedPacket queuedPacket;
+    while (connectionSingleton.packetQueue.try_dequeue(queuedPacket)) { }
+
+    connectionSingleton.heldPacket = QueuedPacket();
+    connectionSingleton.deferredRequests.clear();
+    if (connectionSingleton.isCongested)
+    {
+        connectionSingleton.isCongested = false;
+        connectionSingleton.backpressure.congestedTime += std::chrono::duration<f64>(std::chrono::steady_clock::now() - connectionSingleton.congestedSince).count();
+    }
+
+    ScheduleReconnect(registry);
+}
+
 void ConnectionUpdateSystem::Update(entt::registry& registry)
 {
     ZoneScopedNC("ConnectionUpdateSystem::Update", tracy::Color::Blue)
     ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
 
-    if (connectionSingleton.networkClient)
+    if (connectionSingleton.isDisconnected.exchange(false))
     {
-        std::shared_ptr<NetworkPacket> packet = nullptr;
+        EndSession(registry, connectionSingleton);
+    }
 
+    // The old connection is gone, there is nothing to flush or handle until the reconnect goes through
+    if (connectionSingleton.reconnectTimer != TIMER_INVALID)
+        return;
+
+    if (connectionSingleton.networkClient)
+    {
+        FrameDiagnostics& diagnostics = registry.ctx<FrameSingleton>().diagnostics;
         MessageHandler* networkMessageHandler = ServiceLocator::GetNetworkMessageHandler();
-        while (connectionSingleton.packetQueue.try_dequeue(packet))
+
+        AddressRequestSingleton& addressRequestSingleton = registry.ctx<AddressRequestSingleton>();
+
+        if (!connectionSingleton.transport->Flush(connectionSingleton.networkClient))
         {
-#ifdef NC_Debug
-            DebugHandler::PrintSuccess("[Network/Socket]: CMD: %u, Size: %u", packet->header.opcode, packet->header.size);
-#endif // NC_Debug
+            connectionSingleton.networkClient->Close(asio::error::broken_pipe);
+            return;
+        }
+
+        UpdateCongestion(connectionSingleton);
+        addressRequestSingleton.isOverloaded = connectionSingleton.isCongested;
 
-            if (!networkMessageHandler->CallHandler(connectionSingleton.networkClient, packet))
+        if (connectionSingleton.heldPacket.packet)
+        {
+            QueuedPacket heldPacket = std::move(connectionSingleton.heldPacket);
+            connectionSingleton.heldPacket = QueuedPacket();
+
+            if (!HandlePacket(connectionSingleton, diagnostics, networkMessageHandler, heldPacket))
+                return;
+        }
+
+        // Deferred requests arrived before anything in the queue, they go first
+        while (!connectionSingleton.isCongested && !connectionSingleton.deferredRequests.empty())
+        {
+            QueuedPacket queuedPacket = std::move(connectionSingleton.deferredRequests.front());
+            connectionSingleton.deferredRequests.pop_front();
+
+            if (!HandlePacket(connectionSingleton, diagnostics, networkMessageHandler, queuedPacket))
+                return;
+        }
+
+        QueuedPacket queuedPacket;
+        while (connectionSingleton.packetQueue.try_dequeue(queuedPacket))
+        {
+            if (queuedPacket.trace)
+                RequestTracer::Mark(*queuedPacket.trace, TraceStage::DEQUEUE);
+
+            /*
+                Address requests are only routed after every packet of the frame was handled, while server updates apply right away.
+                So a server update stops the frame once requests are waiting, which keeps the order Novus-Service sent them in.
+                Requests deferred by backpressure are the exception, they are routed against the table as it is once the congestion clears.
+            */
+            if (queuedPacket.packet->header.opcode != Opcode::MSG_REQUEST_ADDRESS && !addressRequestSingleton.requests.empty())
             {
-                connectionSingleton.networkClient->Close(asio::error::shut_down);
+                connectionSingleton.heldPacket = std::move(queuedPacket);
                 break;
             }
+
+            // Only the data plane waits, server registrations and updates still go through while congested
+            if (connectionSingleton.isCongested && queuedPacket.packet->header.opcode == Opcode::MSG_REQUEST_ADDRESS)
+            {
+                if (connectionSingleton.deferredRequests.size() < connectionSingleton.maxDeferredRequests)
+                {
+                    connectionSingleton.deferredRequests.push_back(std::move(queuedPacket));
+                    connectionSingleton.backpressure.deferredRequests++;
+                    continue;
+                }
+
+                if (connectionSingleton.hasSignaledOverload)
+                {
+                    connectionSingleton.backpressure.droppedRequests++;
+                    continue;
+                }
+
+                connectionSingleton.hasSignaledOverload = true;
+                connectionSingleton.backpressure.overloadedRequests++;
+            }
+
+            if (!HandlePacket(connectionSingleton, diagnostics, networkMessageHandler, queuedPacket))
+                break;
         }
     }
 }
 
+// Runs on the asio thread, the engine thread cleans up and reconnects
+static void SetDisconnected()
+{
+    entt::registry* registry = ServiceLocator::GetRegistry();
+    registry->ctx<ConnectionSingleton>().isDisconnected = true;
+
+    ServiceLocator::GetEngineWakeEvent()->Wake();
+}
+
 void ConnectionUpdateSystem::HandleConnect(BaseSocket* socket, bool connected)
 {
     if (connected)
     {
 #ifdef NC_Debug
-        DebugHandler::PrintSuccess("[Network/Socket]: Successfully connected to (%s, %u)", socket->socket()->remote_endpoint().address().to_string().c_str(), socket->socket()->remote_endpoint().port());
+        Logger::PrintSuccess("[Network/Socket]: Successfully connected to (%s, %u)", socket->socket()->remote_endpoint().address().to_string().c_str(), socket->socket()->remote_endpoint().port());
 #endif // NC_Debug
 
         entt::registry* registry = ServiceLocator::GetRegistry();
         AuthenticationSingleton& authentication = registry->ctx<AuthenticationSingleton>();
         
         /* Send Initial Packet */
-        std::shared_ptr<Bytebuffer> buffer = Bytebuffer::Borrow<512>();
-
         authentication.srp.username = "loadbalancer";
         authentication.srp.password = "password";
 
@@ -53,6 +248,7 @@ void ConnectionUpdateSystem::HandleConnect(BaseSocket* socket, bool connected)
         if (!authentication.srp.StartAuthentication())
             return;
 
+        std::shared_ptr<Bytebuffer> buffer = BufferPool::BorrowFor(Opcode::CMSG_LOGON_CHALLENGE, authentication.srp.username.size() + 1 + authentication.srp.aBuffer->size);
         buffer->Put(Opcode::CMSG_LOGON_CHALLENGE);
         buffer->SkipWrite(sizeof(u16));
 
@@ -63,7 +259,14 @@ void ConnectionUpdateSystem::HandleConnect(BaseSocket* socket, bool connected)
         u16 writtenData = static_cast<u16>(buffer->writtenData) - size;
 
         buffer->Put<u16>(writtenData, 2);
-        socket->Send(buffer);
+        BufferPool::RecordPacket(Opcode::CMSG_LOGON_CHALLENGE, writtenData);
+
+        ConnectionSingleton& connectionSingleton = registry->ctx<ConnectionSingleton>();
+        if (!connectionSingleton.transport->Send(connectionSingleton.networkClient, buffer))
+        {
+            socket->Close(asio::error::broken_pipe);
+            return;
+        }
 
         NetworkClient* networkClient = static_cast<NetworkClient*>(socket);
         networkClient->SetStatus(ConnectionStatus::AUTH_CHALLENGE);
@@ -72,8 +275,10 @@ void ConnectionUpdateSystem::HandleConnect(BaseSocket* socket, bool connected)
     else
     {
 #ifdef NC_Debug
-        DebugHandler::PrintWarning("[Network/Socket]: Failed connecting to (%s, %u)", socket->socket()->remote_endpoint().address().to_string().c_str(), socket->socket()->remote_endpoint().port());
+        Logger::PrintWarning("[Network/Socket]: Failed connecting to (%s, %u)", socket->socket()->remote_endpoint().address().to_string().c_str(), socket->socket()->remote_endpoint().port());
 #endif // NC_Debug
+
+        SetDisconnected();
     }
 }
 void ConnectionUpdateSystem::HandleRead(BaseSocket* socket)
@@ -98,36 +303,40 @@ void ConnectionUpdateSystem::HandleRead(BaseSocket* socket)
             return;
         }
         
-        std::shared_ptr<NetworkPacket> packet = NetworkPacket::Borrow();
+        // Header
+        std::shared_ptr<NetworkPacket> packet = BufferPool::BorrowPacket(opcode, size);
         {
-            // Header
-            {
-                packet->header.opcode = opcode;
-                packet->header.size = size;
-            }
-
             // Payload
             {
                 if (size)
                 {
-                    packet->payload = Bytebuffer::Borrow<NETWORK_BUFFER_SIZE>();
+                    packet->payload = BufferPool::BorrowPayload(opcode, size);
                     packet->payload->size = size;
                     packet->payload->writtenData = size;
                     std::memcpy(packet->payload->GetDataPointer(), buffer->GetReadPointer(), size);
                 }
             }
 
-            connectionSingleton.packetQueue.enqueue(packet);
+            QueuedPacket queuedPacket;
+            queuedPacket.packet = packet;
+
+            if (opcode == Opcode::MSG_REQUEST_ADDRESS)
+                queuedPacket.trace = RequestTracer::Sample();
+
+            connectionSingleton.packetQueue.enqueue(queuedPacket);
         }
 
         buffer->readData += size;
     }
 
+    ServiceLocator::GetEngineWakeEvent()->Wake();
     client->Listen();
 }
 void ConnectionUpdateSystem::HandleDisconnect(BaseSocket* socket)
 {
 #ifdef NC_Debug
-    DebugHandler::PrintWarning("[Network/Socket]: Disconnected from (%s, %u)", socket->socket()->remote_endpoint().address().to_string().c_str(), socket->socket()->remote_endpoint().port());
+    Logger::PrintWarning("[Network/Socket]: Disconnected from (%s, %u)", socket->socket()->remote_endpoint().address().to_string().c_str(), socket->socket()->remote_endpoint().port());
 #endif // NC_Debug
+
+    SetDisconnected();
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "LoadBalanceSystems.h"
+#include <entt.hpp>
+#include "../../Components/Singletons/TimeSingleton.h"
+#include "../../Components/Singletons/TimerSingleton.h"
+#include "../../Components/Network/LoadBalanceSingleton.h"
+#include "../../../Utils/AddressTypeUtils.h"
+#include "../../../Utils/Logger.h"
+#include <tracy/Tracy.hpp>
+#include <cmath>
+
+static void ScheduleShardExpiry(entt::registry& registry, size_t shardIndex);
+
+// Runs off the timer wheel once the shard's earliest lease or reservation is due
+static void ExpireShard(entt::registry& registry, size_t shardIndex)
+{
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    loadBalanceSingleton.expiryTimers[shardIndex].timer = TIMER_INVALID;
+
+    loadBalanceSingleton.Expire(shardIndex, registry.ctx<TimeSingleton>().lifeTimeInS);
+    ScheduleShardExpiry(registry, shardIndex);
+}
+
+static void ScheduleShardExpiry(entt::registry& registry, size_t shardIndex)
+{
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    f32 nextExpiry = loadBalanceSingleton.GetNextExpiry(shardIndex);
+    if (std::isinf(nextExpiry))
+        return;
+
+    // New leases and reservations are queued behind the ones the timer is armed for, only Restore or a shorter reservationTimeout move it forward
+    ShardExpiryTimer& expiryTimer = loadBalanceSingleton.expiryTimers[shardIndex];
+    TimerWheel& wheel = registry.ctx<TimerSingleton>().wheel;
+
+    if (expiryTimer.timer != TIMER_INVALID)
+    {
+        if (expiryTimer.expireTime <= nextExpiry)
+            return;
+
+        wheel.Cancel(expiryTimer.timer);
+    }
+
+    // Rounded to the nearest millisecond, the wheel and lifeTimeInS are different clocks anyway and a timer that fires a little early finds nothing due and is armed again
+    f32 delay = std::max(nextExpiry - registry.ctx<TimeSingleton>().lifeTimeInS, 0.0f);
+    entt::registry* registryPointer = &registry;
+
+    expiryTimer.expireTime = nextExpiry;
+    expiryTimer.timer = wheel.Schedule(std::max<u64>(static_cast<u64>(std::round(delay * 1000.0f)), 1), [registryPointer, shardIndex]()
+    {
+        ExpireShard(*registryPointer, shardIndex);
+    });
+}
+
+void LoadBalanceUpdateSystem::ScheduleExpiry(entt::registry& registry)
+{
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    loadBalanceSingleton.expiryTimers.resize(loadBalanceSingleton.GetNumShards());
+
+    for (size_t i = 0; i < loadBalanceSingleton.GetNumShards(); i++)
+    {
+        ScheduleShardExpiry(registry, i);
+    }
+}
+
+void LoadBalanceUpdateSystem::Update(entt::registry& registry)
+{
+    ZoneScopedNC("LoadBalanceUpdateSystem::Update", tracy::Color::Blue)
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    // Expiry itself runs off the timer wheel, this only checks each shard's front so it's O(shards) however many leases are out
+    loadBalanceSingleton.SetLifeTime(timeSingleton.lifeTimeInS);
+    ScheduleExpiry(registry);
+
+    if (loadBalanceSingleton.GetNumDraining() == 0)
+        return;
+
+    // Let operators know once a draining server has nothing outstanding and can be stopped
+    loadBalanceSingleton.ForEach([](AddressType type, u8 realmId, ServerEntry& entry)
+    {
+        if (!entry.IsDrained() || entry.drainReported)
+            return;
+
+        Logger::PrintSuccess("[LoadBalancer]: %s server (Realm %u, Entity %u) finished draining and is safe to stop", AddressTypeUtils::GetName(type), realmId, static_cast<u32>(entry.info.entity));
+        entry.drainReported = true;
+    });
+}
\ No newline at end of file
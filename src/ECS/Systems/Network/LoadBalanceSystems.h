@@ -0,0 +1,11 @@
+#pragma once
+#include <entity/fwd.hpp>
+
+class LoadBalanceUpdateSystem
+{
+public:
+    static void Update(entt::registry& registry);
+
+    // Arms each shard's expiry timer for its earliest lease or reservation, call after anything that may have added an earlier one than the timer knows of
+    static void ScheduleExpiry(entt::registry& registry);
+};
\ No newline at end of file
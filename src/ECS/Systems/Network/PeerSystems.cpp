@@ -0,0 +1,224 @@
+#include "PeerSystems.h"
+#include <entt.hpp>
+#include "../../Components/Singletons/TimeSingleton.h"
+#include "../../Components/Singletons/TimerSingleton.h"
+#include "../../Components/Network/LoadBalanceSingleton.h"
+#include "../../Components/Network/PeerSingleton.h"
+#include "../../Components/Network/ReplicationSingleton.h"
+#include "ReplicationSystems.h"
+#include "RttSystems.h"
+#include "../../../Network/PeerMessages.h"
+#include "../../../Utils/BufferPool.h"
+#include <tracy/Tracy.hpp>
+
+static u64 GetPeerKey(u32 address, u16 port)
+{
+    return (static_cast<u64>(address) << 16) | port;
+}
+
+static u64 GetServerKey(u32 entity, AddressType type, u8 realmId)
+{
+    return (static_cast<u64>(entity) << 16) | (static_cast<u64>(type) << 8) | realmId;
+}
+
+static bool ReadLoadReport(std::shared_ptr<Bytebuffer>& buffer, PeerState& peerState, f32 lifeTime)
+{
+    u8 count = 0;
+    if (!buffer->GetU8(count))
+        return false;
+
+    for (u8 i = 0; i < count; i++)
+    {
+        PeerServerLoad serverLoad;
+        u16 load = 0;
+
+        if (!buffer->GetU32(serverLoad.entity) ||
+            !buffer->Get(serverLoad.type) ||
+            !buffer->GetU8(serverLoad.realmId) ||
+            !buffer->GetU16(load))
+        {
+            return false;
+        }
+
+        if (serverLoad.type < AddressType::AUTH || serverLoad.type >= AddressType::COUNT)
+            return false;
+
+        serverLoad.load = load / PEER_LOAD_SCALE;
+        serverLoad.reportTime = lifeTime;
+
+        peerState.loads[GetServerKey(serverLoad.entity, serverLoad.type, serverLoad.realmId)] = serverLoad;
+    }
+
+    return true;
+}
+
+static void ReceiveReports(entt::registry& registry, LoadBalanceSingleton& loadBalanceSingleton, PeerSingleton& peerSingleton, f32 lifeTime)
+{
+    PeerDatagram datagram;
+    while (peerSingleton.socket->TryGetDatagram(datagram))
+    {
+        u16 magic = 0;
+        PeerMessageType messageType = PeerMessageType::INVALID;
+
+        if (!datagram.buffer->GetU16(magic) || magic != PEER_MESSAGE_MAGIC || !datagram.buffer->Get(messageType))
+            continue;
+
+        if (messageType == PeerMessageType::LOAD_REPORT)
+        {
+            if (!loadBalanceSingleton.IsPeer(datagram.address, datagram.port))
+                continue;
+
+            PeerState& peerState = peerSingleton.peers[GetPeerKey(datagram.address, datagram.port)];
+            ReadLoadReport(datagram.buffer, peerState, lifeTime);
+        }
+        else if (messageType == PeerMessageType::SNAPSHOT)
+        {
+            ReplicationUpdateSystem::HandleSnapshot(registry, datagram);
+        }
+        else if (messageType == PeerMessageType::PING)
+        {
+            RttUpdateSystem::HandlePing(registry, datagram);
+        }
+        else if (messageType == PeerMessageType::PONG)
+        {
+            RttUpdateSystem::HandlePong(registry, datagram);
+        }
+    }
+}
+
+// Rebuilds every server's peerLoad from the reports that are still fresh
+static void ApplyPeerLoads(LoadBalanceSingleton& loadBalanceSingleton, PeerSingleton& peerSingleton, f32 lifeTime)
+{
+    loadBalanceSingleton.ForEach([](AddressType type, u8 realmId, ServerEntry& entry)
+    {
+        entry.peerLoad = 0.0f;
+    });
+
+    for (auto peerItr = peerSingleton.peers.begin(); peerItr != peerSingleton.peers.end();)
+    {
+        auto& loads = peerItr->second.loads;
+        for (auto loadItr = loads.begin(); loadItr != loads.end();)
+        {
+            const PeerServerLoad& serverLoad = loadItr->second;
+            if (lifeTime - serverLoad.reportTime > peerSingleton.peerTimeout)
+            {
+                loadItr = loads.erase(loadItr);
+                continue;
+            }
+
+            if (ServerEntry* entry = loadBalanceSingleton.FindServer(serverLoad.type, serverLoad.realmId, static_cast<entt::entity>(serverLoad.entity)))
+            {
+                entry->peerLoad += serverLoad.load;
+            }
+
+            loadItr++;
+        }
+
+        if (loads.empty())
+        {
+            peerItr = peerSingleton.peers.erase(peerItr);
+        }
+        else
+        {
+            peerItr++;
+        }
+    }
+}
+
+static void SendReports(LoadBalanceSingleton& loadBalanceSingleton, PeerSingleton& peerSingleton)
+{
+    std::vector<PeerServerLoad> serverLoads;
+    std::vector<std::pair<u32, u16>> peers;
+
+    loadBalanceSingleton.ForEach([&loadBalanceSingleton, &peerSingleton, &serverLoads, &peers](AddressType type, u8 realmId, const ServerEntry& entry)
+    {
+        if (type == AddressType::LOADBALANCE)
+        {
+            // Peers registered without a port predate load reporting
+            bool isSelf = entry.info.address == peerSingleton.localAddress && entry.info.port == peerSingleton.socket->GetPort();
+            if (!isSelf && entry.info.port != 0)
+                peers.push_back({ entry.info.address, entry.info.port });
+
+            return;
+        }
+
+        PeerServerLoad& serverLoad = serverLoads.emplace_back();
+        serverLoad.entity = static_cast<u32>(entry.info.entity);
+        serverLoad.type = type;
+        serverLoad.realmId = realmId;
+        serverLoad.load = loadBalanceSingleton.GetLocalLoad(entry);
+    });
+
+    if (peers.empty() || serverLoads.empty())
+        return;
+
+    size_t budget = std::min(peerSingleton.gossipBudget, PEER_DATAGRAM_SIZE);
+    size_t maxEntries = std::min<size_t>((budget - PEER_MESSAGE_HEADER_SIZE - sizeof(u8)) / PEER_LOAD_REPORT_ENTRY_SIZE, 255);
+    size_t numEntries = std::min(maxEntries, serverLoads.size());
+
+    std::shared_ptr<Bytebuffer> buffer = BufferPool::Borrow(PEER_DATAGRAM_SIZE);
+    buffer->PutU16(PEER_MESSAGE_MAGIC);
+    buffer->Put(PeerMessageType::LOAD_REPORT);
+    buffer->PutU8(static_cast<u8>(numEntries));
+
+    // When the table doesn't fit in the budget we rotate through it, every server is reported within a few intervals
+    for (size_t i = 0; i < numEntries; i++)
+    {
+        const PeerServerLoad& serverLoad = serverLoads[(peerSingleton.gossipCursor + i) % serverLoads.size()];
+        f32 load = std::min(serverLoad.load * PEER_LOAD_SCALE, 65535.0f);
+
+        buffer->PutU32(serverLoad.entity);
+        buffer->Put(serverLoad.type);
+        buffer->PutU8(serverLoad.realmId);
+        buffer->PutU16(static_cast<u16>(load));
+    }
+    peerSingleton.gossipCursor = (peerSingleton.gossipCursor + numEntries) % serverLoads.size();
+
+    for (auto& [address, port] : peers)
+    {
+        peerSingleton.socket->Send(address, port, buffer);
+    }
+}
+
+// Runs off the timer wheel every gossipInterval
+static void Gossip(entt::registry& registry)
+{
+    PeerSingleton& peerSingleton = registry.ctx<PeerSingleton>();
+    if (!peerSingleton.socket || !peerSingleton.socket->IsOpen())
+        return;
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    ApplyPeerLoads(loadBalanceSingleton, peerSingleton, registry.ctx<TimeSingleton>().lifeTimeInS);
+
+    // A standby doesn't hand out addresses, reporting its replicated leases would make peers count them twice
+    ReplicationSingleton& replicationSingleton = registry.ctx<ReplicationSingleton>();
+    if (replicationSingleton.role != ReplicationRole::STANDBY)
+    {
+        SendReports(loadBalanceSingleton, peerSingleton);
+    }
+}
+
+void PeerUpdateSystem::Update(entt::registry& registry)
+{
+    ZoneScopedNC("PeerUpdateSystem::Update", tracy::Color::Blue)
+    PeerSingleton& peerSingleton = registry.ctx<PeerSingleton>();
+
+    if (!peerSingleton.socket || !peerSingleton.socket->IsOpen())
+        return;
+
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    ReceiveReports(registry, loadBalanceSingleton, peerSingleton, timeSingleton.lifeTimeInS);
+
+    if (peerSingleton.gossipTimer == TIMER_INVALID)
+    {
+        entt::registry* registryPointer = &registry;
+        u64 gossipInterval = std::max<u64>(static_cast<u64>(peerSingleton.gossipInterval * 1000.0f), 1);
+
+        peerSingleton.gossipTimer = registry.ctx<TimerSingleton>().wheel.ScheduleRepeating(gossipInterval, [registryPointer]()
+        {
+            Gossip(*registryPointer);
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+#include <entity/fwd.hpp>
+
+class PeerUpdateSystem
+{
+public:
+    static void Update(entt::registry& registry);
+};
\ No newline at end of file
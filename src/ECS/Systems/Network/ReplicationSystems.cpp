@@ -0,0 +1,312 @@
+#include "ReplicationSystems.h"
+#include <entt.hpp>
+#include "../../../Utils/Logger.h"
+#include "../../../Utils/BufferPool.h"
+#include "../../Components/Singletons/TimeSingleton.h"
+#include "../../Components/Singletons/TimerSingleton.h"
+#include "../../Components/Network/ConnectionSingleton.h"
+#include "../../Components/Network/LoadBalanceSingleton.h"
+#include "../../Components/Network/PeerSingleton.h"
+#include "../../Components/Network/ReplicationSingleton.h"
+#include "../../../Network/PeerMessages.h"
+#include "../../../Network/Handlers/Auth/AuthHandlers.h"
+#include "LoadBalanceSystems.h"
+#include <tracy/Tracy.hpp>
+#include <cmath>
+
+static void WriteEntry(std::shared_ptr<Bytebuffer>& buffer, const ServerEntry& entry, const LeaseWindow& leaseWindow, const LoadBalanceSingleton& loadBalanceSingleton)
+{
+    buffer->PutU32(static_cast<u32>(entry.info.entity));
+    buffer->Put(entry.info.type);
+    buffer->PutU8(entry.info.realmId);
+    buffer->PutU32(entry.info.address);
+    buffer->PutU16(entry.info.port);
+    buffer->Put(entry.state);
+    buffer->Put<f32>(entry.weight);
+    buffer->Put<f32>(loadBalanceSingleton.GetLifeTime() - entry.addedTime);
+    buffer->PutU16(static_cast<u16>(std::min<u32>(entry.activeLeases, std::numeric_limits<u16>::max())));
+    buffer->Put<f32>(leaseWindow.first);
+    buffer->Put<f32>(leaseWindow.last);
+    buffer->PutU8(entry.hasCapacity);
+    buffer->PutU32(entry.capacity);
+    buffer->PutU32(entry.reservedCapacity);
+}
+
+static bool ReadEntry(std::shared_ptr<Bytebuffer>& buffer, ServerEntry& entry, LeaseWindow& leaseWindow, f32 lifeTime)
+{
+    u32 entity = 0;
+    f32 age = 0.0f;
+    u16 leases = 0;
+    u8 hasCapacity = 0;
+
+    if (!buffer->GetU32(entity) ||
+        !buffer->Get(entry.info.type) ||
+        !buffer->GetU8(entry.info.realmId) ||
+        !buffer->GetU32(entry.info.address) ||
+        !buffer->GetU16(entry.info.port) ||
+        !buffer->Get(entry.state) ||
+        !buffer->Get<f32>(entry.weight) ||
+        !buffer->Get<f32>(age) ||
+        !buffer->GetU16(leases) ||
+        !buffer->Get<f32>(leaseWindow.first) ||
+        !buffer->Get<f32>(leaseWindow.last) ||
+        !buffer->GetU8(hasCapacity) ||
+        !buffer->GetU32(entry.capacity) ||
+        !buffer->GetU32(entry.reservedCapacity))
+    {
+        return false;
+    }
+
+    if (entry.info.type < AddressType::AUTH || entry.info.type >= AddressType::COUNT)
+        return false;
+
+    entry.info.entity = static_cast<entt::entity>(entity);
+    entry.addedTime = lifeTime - age;
+    entry.recentAssignmentsTime = lifeTime;
+    entry.activeLeases = leases;
+    entry.hasCapacity = hasCapacity != 0;
+    return true;
+}
+
+static void SendSnapshot(LoadBalanceSingleton& loadBalanceSingleton, PeerSingleton& peerSingleton, ReplicationSingleton& replicationSingleton)
+{
+    std::vector<const ServerEntry*> serverEntries;
+    loadBalanceSingleton.ForEach([&serverEntries](AddressType type, u8 realmId, const ServerEntry& entry)
+    {
+        serverEntries.push_back(&entry);
+    });
+
+    robin_hood::unordered_map<u32, LeaseWindow> leaseWindows;
+    loadBalanceSingleton.GetLeaseWindows(leaseWindows);
+
+    constexpr size_t entriesPerChunk = (PEER_DATAGRAM_SIZE - PEER_MESSAGE_HEADER_SIZE - PEER_SNAPSHOT_HEADER_SIZE) / PEER_SNAPSHOT_ENTRY_SIZE;
+    size_t numChunks = std::max<size_t>((serverEntries.size() + entriesPerChunk - 1) / entriesPerChunk, 1);
+
+    if (numChunks > std::numeric_limits<u8>::max())
+    {
+        Logger::PrintWarning("[Replication]: Routing table has %u servers, only the first %u are replicated", static_cast<u32>(serverEntries.size()), static_cast<u32>(entriesPerChunk * std::numeric_limits<u8>::max()));
+        numChunks = std::numeric_limits<u8>::max();
+    }
+
+    u32 snapshotId = ++replicationSingleton.snapshotId;
+    for (size_t chunk = 0; chunk < numChunks; chunk++)
+    {
+        size_t first = chunk * entriesPerChunk;
+        size_t count = std::min(entriesPerChunk, serverEntries.size() - std::min(first, serverEntries.size()));
+
+        std::shared_ptr<Bytebuffer> buffer = BufferPool::Borrow(PEER_DATAGRAM_SIZE);
+        buffer->PutU16(PEER_MESSAGE_MAGIC);
+        buffer->Put(PeerMessageType::SNAPSHOT);
+        buffer->PutU32(replicationSingleton.epoch);
+        buffer->PutU32(snapshotId);
+        buffer->PutU8(static_cast<u8>(chunk));
+        buffer->PutU8(static_cast<u8>(numChunks));
+        buffer->PutU32(loadBalanceSingleton.GetTableVersion());
+        buffer->PutU8(static_cast<u8>(count));
+
+        for (size_t i = first; i < first + count; i++)
+        {
+            auto itr = leaseWindows.find(serverEntries[i]->id);
+            WriteEntry(buffer, *serverEntries[i], itr != leaseWindows.end() ? itr->second : LeaseWindow(), loadBalanceSingleton);
+        }
+
+        peerSingleton.socket->Send(replicationSingleton.partnerAddress, replicationSingleton.partnerPort, buffer);
+    }
+}
+
+static void Promote(entt::registry& registry, ReplicationSingleton& replicationSingleton)
+{
+    replicationSingleton.epoch++;
+    Logger::PrintWarning("[Replication]: No heartbeat from the active load balancer for %.2f seconds, taking over in epoch %u", replicationSingleton.failoverTimeout, replicationSingleton.epoch);
+
+    replicationSingleton.role = ReplicationRole::ACTIVE;
+
+    // The partner may come back, it has to learn about the takeover before its next heartbeat would
+    SendSnapshot(registry.ctx<LoadBalanceSingleton>(), registry.ctx<PeerSingleton>(), replicationSingleton);
+
+    // If we are still connecting to Novus-Service, AuthHandlers registers us as soon as the handshake completes
+    if (replicationSingleton.isAwaitingRegistration)
+    {
+        ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+        InternalSocket::AuthHandlers::SendConnected(connectionSingleton.networkClient);
+
+        replicationSingleton.isAwaitingRegistration = false;
+    }
+}
+
+// Both halves are active, the one that took over last keeps going
+static bool IsPartnerAhead(ReplicationSingleton& replicationSingleton, PeerSingleton& peerSingleton, u32 partnerEpoch)
+{
+    if (partnerEpoch != replicationSingleton.epoch)
+        return partnerEpoch > replicationSingleton.epoch;
+
+    u64 partnerKey = (static_cast<u64>(replicationSingleton.partnerAddress) << 16) | replicationSingleton.partnerPort;
+    u64 localKey = (static_cast<u64>(peerSingleton.localAddress) << 16) | peerSingleton.socket->GetPort();
+    return partnerKey > localKey;
+}
+
+static void StepDown(entt::registry& registry, ReplicationSingleton& replicationSingleton, u32 partnerEpoch)
+{
+    Logger::PrintWarning("[Replication]: Partner is active in epoch %u, ours is %u, stepping down to standby", partnerEpoch, replicationSingleton.epoch);
+
+    replicationSingleton.role = ReplicationRole::STANDBY;
+    replicationSingleton.ClearPending();
+
+    // Our registration lasts as long as the connection to Novus-Service, the reconnect authenticates again and AuthHandlers holds back the registration
+    ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+    connectionSingleton.networkClient->Close(asio::error::shut_down);
+}
+
+// Runs off the timer wheel every heartbeatInterval
+static void SendHeartbeat(entt::registry& registry)
+{
+    ReplicationSingleton& replicationSingleton = registry.ctx<ReplicationSingleton>();
+    if (replicationSingleton.role != ReplicationRole::ACTIVE)
+        return;
+
+    SendSnapshot(registry.ctx<LoadBalanceSingleton>(), registry.ctx<PeerSingleton>(), replicationSingleton);
+}
+
+static void CheckFailover(entt::registry& registry);
+
+static void ScheduleFailover(entt::registry& registry, ReplicationSingleton& replicationSingleton)
+{
+    // Heartbeats only move lastHeartbeatTime, the timer finds out how much of the timeout is left when it fires
+    f32 remaining = replicationSingleton.lastHeartbeatTime + replicationSingleton.failoverTimeout - registry.ctx<TimeSingleton>().lifeTimeInS;
+    u64 delay = std::max<u64>(static_cast<u64>(std::ceil(std::max(remaining, 0.0f) * 1000.0f)), 1);
+
+    entt::registry* registryPointer = &registry;
+    replicationSingleton.failoverTimer = registry.ctx<TimerSingleton>().wheel.Schedule(delay, [registryPointer]()
+    {
+        CheckFailover(*registryPointer);
+    });
+}
+
+// Runs off the timer wheel while we are standby
+static void CheckFailover(entt::registry& registry)
+{
+    ReplicationSingleton& replicationSingleton = registry.ctx<ReplicationSingleton>();
+    replicationSingleton.failoverTimer = TIMER_INVALID;
+
+    if (replicationSingleton.role != ReplicationRole::STANDBY)
+        return;
+
+    if (registry.ctx<TimeSingleton>().lifeTimeInS - replicationSingleton.lastHeartbeatTime > replicationSingleton.failoverTimeout)
+    {
+        Promote(registry, replicationSingleton);
+        return;
+    }
+
+    ScheduleFailover(registry, replicationSingleton);
+}
+
+void ReplicationUpdateSystem::Update(entt::registry& registry)
+{
+    ZoneScopedNC("ReplicationUpdateSystem::Update", tracy::Color::Blue)
+    ReplicationSingleton& replicationSingleton = registry.ctx<ReplicationSingleton>();
+    PeerSingleton& peerSingleton = registry.ctx<PeerSingleton>();
+
+    if (replicationSingleton.role == ReplicationRole::NONE || !peerSingleton.socket)
+        return;
+
+    // Heartbeats and the failover check run off the timer wheel, a standby that stepped down is armed again here
+    if (replicationSingleton.heartbeatTimer == TIMER_INVALID)
+    {
+        entt::registry* registryPointer = &registry;
+        u64 heartbeatInterval = std::max<u64>(static_cast<u64>(replicationSingleton.heartbeatInterval * 1000.0f), 1);
+
+        replicationSingleton.heartbeatTimer = registry.ctx<TimerSingleton>().wheel.ScheduleRepeating(heartbeatInterval, [registryPointer]()
+        {
+            SendHeartbeat(*registryPointer);
+        });
+    }
+
+    if (replicationSingleton.role == ReplicationRole::STANDBY && replicationSingleton.failoverTimer == TIMER_INVALID)
+    {
+        ScheduleFailover(registry, replicationSingleton);
+    }
+}
+
+void ReplicationUpdateSystem::HandleSnapshot(entt::registry& registry, PeerDatagram& datagram)
+{
+    ReplicationSingleton& replicationSingleton = registry.ctx<ReplicationSingleton>();
+
+    // Snapshots only come from the partner
+    if (replicationSingleton.role == ReplicationRole::NONE ||
+        datagram.address != replicationSingleton.partnerAddress || datagram.port != replicationSingleton.partnerPort)
+    {
+        return;
+    }
+
+    u32 epoch = 0;
+    u32 snapshotId = 0;
+    u8 chunkIndex = 0;
+    u8 numChunks = 0;
+    u32 tableVersion = 0;
+    u8 count = 0;
+
+    if (!datagram.buffer->GetU32(epoch) ||
+        !datagram.buffer->GetU32(snapshotId) ||
+        !datagram.buffer->GetU8(chunkIndex) ||
+        !datagram.buffer->GetU8(numChunks) ||
+        !datagram.buffer->GetU32(tableVersion) ||
+        !datagram.buffer->GetU8(count) ||
+        chunkIndex >= numChunks)
+    {
+        return;
+    }
+
+    if (replicationSingleton.role == ReplicationRole::ACTIVE)
+    {
+        // Otherwise the partner steps down once it sees one of our snapshots
+        if (!IsPartnerAhead(replicationSingleton, registry.ctx<PeerSingleton>(), epoch))
+            return;
+
+        StepDown(registry, replicationSingleton, epoch);
+    }
+    else if (epoch < replicationSingleton.epoch)
+    {
+        // A former active that hasn't seen our takeover yet
+        return;
+    }
+    replicationSingleton.epoch = epoch;
+
+    TimeSingleton& timeSingleton = registry.ctx<TimeSingleton>();
+    replicationSingleton.lastHeartbeatTime = timeSingleton.lifeTimeInS;
+
+    // A chunk of a newer snapshot means we lost part of the previous one, it will be replaced anyway
+    if (snapshotId != replicationSingleton.pendingSnapshotId || replicationSingleton.pendingChunks.size() != numChunks)
+    {
+        replicationSingleton.pendingSnapshotId = snapshotId;
+        replicationSingleton.pendingTableVersion = tableVersion;
+        replicationSingleton.ClearPending();
+        replicationSingleton.pendingChunks.assign(numChunks, false);
+    }
+
+    if (replicationSingleton.pendingChunks[chunkIndex])
+        return;
+
+    for (u8 i = 0; i < count; i++)
+    {
+        ServerEntry& entry = replicationSingleton.pendingEntries.emplace_back();
+        LeaseWindow& leaseWindow = replicationSingleton.pendingLeaseWindows.emplace_back();
+
+        // The rest of this snapshot can't complete, none of it may end up merged into the next one
+        if (!ReadEntry(datagram.buffer, entry, leaseWindow, timeSingleton.lifeTimeInS))
+        {
+            replicationSingleton.ClearPending();
+            return;
+        }
+    }
+    replicationSingleton.pendingChunks[chunkIndex] = true;
+
+    if (std::find(replicationSingleton.pendingChunks.begin(), replicationSingleton.pendingChunks.end(), false) != replicationSingleton.pendingChunks.end())
+        return;
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    loadBalanceSingleton.Restore(replicationSingleton.pendingEntries, replicationSingleton.pendingLeaseWindows, replicationSingleton.pendingTableVersion);
+    LoadBalanceUpdateSystem::ScheduleExpiry(registry);
+
+    replicationSingleton.snapshotsApplied++;
+    replicationSingleton.ClearPending();
+}
\ No newline at end of file
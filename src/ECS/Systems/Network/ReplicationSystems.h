@@ -0,0 +1,12 @@
+#pragma once
+#include <entity/fwd.hpp>
+
+struct PeerDatagram;
+class ReplicationUpdateSystem
+{
+public:
+    static void Update(entt::registry& registry);
+
+    // Called by PeerUpdateSystem for every SNAPSHOT datagram
+    static void HandleSnapshot(entt::registry& registry, PeerDatagram& datagram);
+};
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "RttSystems.h"
+#include <entt.hpp>
+#include <chrono>
+#include "../../../Utils/BufferPool.h"
+#include "../../../Utils/ServiceLocator.h"
+#include "../../../Utils/WakeEvent.h"
+#include "../../Components/Singletons/TimerSingleton.h"
+#include "../../Components/Network/ConnectionSingleton.h"
+#include "../../Components/Network/LoadBalanceSingleton.h"
+#include "../../Components/Network/PeerSingleton.h"
+#include "../../Components/Network/RttSingleton.h"
+#include "../../../Network/PeerMessages.h"
+#include <tracy/Tracy.hpp>
+
+// Pings carry the sender's own clock, so the two load balancers never need to agree on the time
+static u64 GetTimeUS()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void SendPeerMessage(PeerSingleton& peerSingleton, PeerMessageType messageType, u32 address, u16 port, u64 sendTime)
+{
+    std::shared_ptr<Bytebuffer> buffer = BufferPool::Borrow(PEER_MESSAGE_HEADER_SIZE + PEER_PING_SIZE);
+    buffer->PutU16(PEER_MESSAGE_MAGIC);
+    buffer->Put(messageType);
+    buffer->PutU64(sendTime);
+
+    peerSingleton.socket->Send(address, port, buffer);
+}
+
+static void PingPeers(entt::registry& registry)
+{
+    PeerSingleton& peerSingleton = registry.ctx<PeerSingleton>();
+    if (!peerSingleton.socket || !peerSingleton.socket->IsOpen())
+        return;
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    RttSingleton& rttSingleton = registry.ctx<RttSingleton>();
+    u64 now = GetTimeUS();
+
+    loadBalanceSingleton.ForEach([&peerSingleton, &rttSingleton, now](AddressType type, u8 realmId, const ServerEntry& entry)
+    {
+        if (type != AddressType::LOADBALANCE || entry.info.port == 0)
+            return;
+
+        // Same check as the load reports
+        bool isSelf = entry.info.address == peerSingleton.localAddress && entry.info.port == peerSingleton.socket->GetPort();
+        if (isSelf)
+            return;
+
+        RttTarget& target = rttSingleton.GetTarget(RttTargetKind::PEER, entry.info.address, entry.info.port);
+        if (target.pendingPing != 0)
+            target.statistics.numFailures++;
+
+        target.pendingPing = now;
+        SendPeerMessage(peerSingleton, PeerMessageType::PING, entry.info.address, entry.info.port, now);
+    });
+}
+
+static void ProbeBackends(entt::registry& registry)
+{
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    // A server registered for several realms is still one host
+    std::vector<std::pair<u32, u16>> backends;
+    loadBalanceSingleton.ForEach([&backends](AddressType type, u8 realmId, const ServerEntry& entry)
+    {
+        if (type == AddressType::LOADBALANCE || entry.info.address == 0)
+            return;
+
+        backends.push_back({ entry.info.address, entry.info.port });
+    });
+
+    std::sort(backends.begin(), backends.end());
+    backends.erase(std::unique(backends.begin(), backends.end()), backends.end());
+
+    for (auto& [address, port] : backends)
+    {
+        RttUpdateSystem::ProbeBackend(registry, address, port);
+    }
+}
+
+void RttUpdateSystem::Update(entt::registry& registry)
+{
+    ZoneScopedNC("RttUpdateSystem::Update", tracy::Color::Blue)
+    RttSingleton& rttSingleton = registry.ctx<RttSingleton>();
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    RttProbeResult result;
+    while (rttSingleton.probeResults.try_dequeue(result))
+    {
+        rttSingleton.AddResult(result);
+
+        // Routing falls back to the region we reach fastest, the median keeps a single slow connect from moving it
+        if (result.kind == RttTargetKind::BACKEND && result.success)
+        {
+            RttStatistics& statistics = rttSingleton.GetTarget(result.kind, result.address, result.port).statistics;
+            loadBalanceSingleton.SetRtt(result.address, result.port, statistics.GetPercentile(0.5f));
+        }
+    }
+
+    // Sampling runs off the timer wheel, the timers are armed here so they start with the first frame
+    TimerSingleton& timerSingleton = registry.ctx<TimerSingleton>();
+    entt::registry* registryPointer = &registry;
+
+    if (rttSingleton.sampleTimer == TIMER_INVALID && rttSingleton.sampleInterval > 0.0f)
+    {
+        rttSingleton.sampleTimer = timerSingleton.wheel.ScheduleRepeating(static_cast<u64>(rttSingleton.sampleInterval * 1000.0f), [registryPointer]()
+        {
+            f32 rttMS = 0.0f;
+            SampleService(*registryPointer, rttMS);
+            PingPeers(*registryPointer);
+        });
+    }
+
+    if (rttSingleton.backendProbeTimer == TIMER_INVALID && rttSingleton.backendProbeInterval > 0.0f)
+    {
+        rttSingleton.backendProbeTimer = timerSingleton.wheel.ScheduleRepeating(static_cast<u64>(rttSingleton.backendProbeInterval * 1000.0f), [registryPointer]()
+        {
+            ProbeBackends(*registryPointer);
+        });
+    }
+}
+
+bool RttUpdateSystem::SampleService(entt::registry& registry, f32& rttMS)
+{
+    ConnectionSingleton& connectionSingleton = registry.ctx<ConnectionSingleton>();
+    if (!connectionSingleton.networkClient || connectionSingleton.networkClient->IsClosed())
+        return false;
+
+    asio::ip::tcp::socket* socket = connectionSingleton.networkClient->socket();
+
+    asio::error_code error;
+    asio::ip::tcp::endpoint remoteEndpoint = socket->remote_endpoint(error);
+    if (error || !remoteEndpoint.address().is_v4())
+        return false;
+
+    if (!RttProbe::GetConnectionRtt(*socket, rttMS))
+        return false;
+
+    RttSingleton& rttSingleton = registry.ctx<RttSingleton>();
+    rttSingleton.GetTarget(RttTargetKind::SERVICE, remoteEndpoint.address().to_v4().to_uint(), remoteEndpoint.port()).statistics.AddSample(rttMS);
+    return true;
+}
+
+void RttUpdateSystem::ProbeBackend(entt::registry& registry, u32 address, u16 port, RttProbeCallback callback)
+{
+    RttSingleton& rttSingleton = registry.ctx<RttSingleton>();
+    if (!rttSingleton.asioService)
+        return;
+
+    // The singleton lives as long as the registry, which outlives the asio thread's work
+    moodycamel::ConcurrentQueue<RttProbeResult>* probeResults = &rttSingleton.probeResults;
+    RttProbe::Connect(rttSingleton.asioService, address, port, rttSingleton.probeTimeout, [probeResults, address, port, callback](bool success, f32 rttMS)
+    {
+        RttProbeResult result;
+        result.kind = RttTargetKind::BACKEND;
+        result.address = address;
+        result.port = port;
+        result.success = success;
+        result.rttMS = rttMS;
+
+        probeResults->enqueue(result);
+        ServiceLocator::GetEngineWakeEvent()->Wake();
+
+        if (callback)
+            callback(success, rttMS);
+    });
+}
+
+void RttUpdateSystem::HandlePing(entt::registry& registry, PeerDatagram& datagram)
+{
+    u64 sendTime = 0;
+    if (!datagram.buffer->GetU64(sendTime))
+        return;
+
+    // Answering anyone would turn us into a reflector for spoofed sources
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    if (!loadBalanceSingleton.IsPeer(datagram.address, datagram.port))
+        return;
+
+    PeerSingleton& peerSingleton = registry.ctx<PeerSingleton>();
+    SendPeerMessage(peerSingleton, PeerMessageType::PONG, datagram.address, datagram.port, sendTime);
+}
+
+void RttUpdateSystem::HandlePong(entt::registry& registry, PeerDatagram& datagram)
+{
+    u64 sendTime = 0;
+    if (!datagram.buffer->GetU64(sendTime))
+        return;
+
+    u64 now = GetTimeUS();
+    if (sendTime > now)
+        return;
+
+    // PingPeers creates the target, a PONG from anywhere we never pinged is dropped
+    RttSingleton& rttSingleton = registry.ctx<RttSingleton>();
+    RttTarget* target = rttSingleton.FindTarget(RttTargetKind::PEER, datagram.address, datagram.port);
+    if (!target)
+        return;
+
+    // A late answer to an earlier ping is still a valid sample, it just doesn't clear the outstanding one
+    if (sendTime == target->pendingPing)
+        target->pendingPing = 0;
+
+    target->statistics.AddSample((now - sendTime) / 1000.0f);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <NovusTypes.h>
+#include <entity/fwd.hpp>
+#include "../../../Network/RttProbe.h"
+
+struct PeerDatagram;
+class RttUpdateSystem
+{
+public:
+    static void Update(entt::registry& registry);
+
+    // Takes a sample of the Novus-Service connection now, false if it isn't connected or the platform can't tell
+    static bool SampleService(entt::registry& registry, f32& rttMS);
+
+    // Times a TCP handshake to the address, the result is recorded as a backend and also handed to the callback on the asio thread
+    static void ProbeBackend(entt::registry& registry, u32 address, u16 port, RttProbeCallback callback = nullptr);
+
+    // Called by PeerUpdateSystem for every PING and PONG datagram
+    static void HandlePing(entt::registry& registry, PeerDatagram& datagram);
+    static void HandlePong(entt::registry& registry, PeerDatagram& datagram);
+};
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "SharedTableSystems.h"
+#include <entt.hpp>
+#include "../../Components/Singletons/TimerSingleton.h"
+#include "../../Components/Network/LoadBalanceSingleton.h"
+#include "../../Components/Network/SharedTableSingleton.h"
+#include <tracy/Tracy.hpp>
+
+static_assert(SHARED_TABLE_REGION_NONE == REGION_NONE);
+
+static SharedTableEntry GetSharedEntry(const LoadBalanceSingleton& loadBalanceSingleton, AddressType type, u8 realmId, const ServerEntry& entry)
+{
+    SharedTableEntry sharedEntry;
+    sharedEntry.entity = static_cast<u32>(entry.info.entity);
+    sharedEntry.type = static_cast<u8>(type);
+    sharedEntry.realmId = realmId;
+    sharedEntry.region = entry.region;
+    sharedEntry.state = entry.state == ServerState::ACTIVE ? SHARED_TABLE_STATE_ACTIVE : SHARED_TABLE_STATE_DRAINING;
+    sharedEntry.address = entry.info.address;
+    sharedEntry.port = entry.info.port;
+    sharedEntry.hasCapacity = entry.hasCapacity;
+    sharedEntry.weight = loadBalanceSingleton.GetEffectiveWeight(entry);
+    sharedEntry.load = loadBalanceSingleton.GetLoad(entry);
+    sharedEntry.freeCapacity = entry.GetFreeCapacity();
+
+    return sharedEntry;
+}
+
+static void GetSharedEntries(LoadBalanceSingleton& loadBalanceSingleton, std::vector<SharedTableEntry>& entries)
+{
+    entries.clear();
+    loadBalanceSingleton.ForEach([&loadBalanceSingleton, &entries](AddressType type, u8 realmId, const ServerEntry& entry)
+    {
+        entries.push_back(GetSharedEntry(loadBalanceSingleton, type, realmId, entry));
+    });
+}
+
+static void Publish(LoadBalanceSingleton& loadBalanceSingleton, SharedTableSingleton& sharedTableSingleton)
+{
+    GetSharedEntries(loadBalanceSingleton, sharedTableSingleton.entries);
+
+    sharedTableSingleton.writer.Replace(sharedTableSingleton.entries, loadBalanceSingleton.GetTableVersion());
+    sharedTableSingleton.publishedVersion = loadBalanceSingleton.GetTableVersion();
+}
+
+// Runs off the timer wheel, the servers only change through the handlers below so only the loads that moved are written
+static void RefreshLoads(entt::registry& registry)
+{
+    SharedTableSingleton& sharedTableSingleton = registry.ctx<SharedTableSingleton>();
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    if (sharedTableSingleton.publishedVersion != loadBalanceSingleton.GetTableVersion())
+    {
+        Publish(loadBalanceSingleton, sharedTableSingleton);
+        return;
+    }
+
+    GetSharedEntries(loadBalanceSingleton, sharedTableSingleton.entries);
+    sharedTableSingleton.writer.UpdateLoads(sharedTableSingleton.entries, loadBalanceSingleton.GetTableVersion());
+}
+
+void SharedTableUpdateSystem::Update(entt::registry& registry)
+{
+    ZoneScopedNC("SharedTableUpdateSystem::Update", tracy::Color::Blue)
+    SharedTableSingleton& sharedTableSingleton = registry.ctx<SharedTableSingleton>();
+    if (!sharedTableSingleton.writer.IsOpen())
+        return;
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+
+    // Full syncs, replication and console commands change the table without going through the handlers below
+    if (sharedTableSingleton.publishedVersion != loadBalanceSingleton.GetTableVersion())
+    {
+        Publish(loadBalanceSingleton, sharedTableSingleton);
+    }
+
+    if (sharedTableSingleton.refreshTimer == TIMER_INVALID)
+    {
+        entt::registry* registryPointer = &registry;
+        u64 refreshInterval = std::max<u64>(static_cast<u64>(sharedTableSingleton.refreshInterval * 1000.0f), 1);
+
+        sharedTableSingleton.refreshTimer = registry.ctx<TimerSingleton>().wheel.ScheduleRepeating(refreshInterval, [registryPointer]()
+        {
+            RefreshLoads(*registryPointer);
+        });
+    }
+}
+
+void SharedTableUpdateSystem::HandleServerAdd(entt::registry& registry, const ServerInformation& serverInformation, u32 previousVersion)
+{
+    SharedTableSingleton& sharedTableSingleton = registry.ctx<SharedTableSingleton>();
+    if (!sharedTableSingleton.writer.IsOpen() || sharedTableSingleton.publishedVersion != previousVersion)
+        return;
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    ServerEntry* entry = loadBalanceSingleton.FindServer(serverInformation.type, serverInformation.realmId, serverInformation.entity);
+    if (!entry)
+        return;
+
+    // Shared types are published under realm 0 like ForEach visits them, whatever realm the packet named
+    u8 realmId = LoadBalanceSingleton::IsRealmScoped(serverInformation.type) ? serverInformation.realmId : 0;
+    sharedTableSingleton.writer.Upsert(GetSharedEntry(loadBalanceSingleton, serverInformation.type, realmId, *entry), loadBalanceSingleton.GetTableVersion());
+    sharedTableSingleton.publishedVersion = loadBalanceSingleton.GetTableVersion();
+}
+
+void SharedTableUpdateSystem::HandleServerRemove(entt::registry& registry, AddressType type, u8 realmId, entt::entity entity, u32 previousVersion)
+{
+    SharedTableSingleton& sharedTableSingleton = registry.ctx<SharedTableSingleton>();
+    if (!sharedTableSingleton.writer.IsOpen() || sharedTableSingleton.publishedVersion != previousVersion)
+        return;
+
+    LoadBalanceSingleton& loadBalanceSingleton = registry.ctx<LoadBalanceSingleton>();
+    sharedTableSingleton.writer.Remove(type, LoadBalanceSingleton::IsRealmScoped(type) ? realmId : 0, static_cast<u32>(entity), loadBalanceSingleton.GetTableVersion());
+    sharedTableSingleton.publishedVersion = loadBalanceSingleton.GetTableVersion();
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+#include <NovusTypes.h>
+#include <entity/fwd.hpp>
+#include <Networking/AddressType.h>
+
+struct ServerInformation;
+class SharedTableUpdateSystem
+{
+public:
+    static void Update(entt::registry& registry);
+
+    // Called by the server info handlers right after they changed the table, previousVersion is the table version before the change
+    static void HandleServerAdd(entt::registry& registry, const ServerInformation& serverInformation, u32 previousVersion);
+    static void HandleServerRemove(entt::registry& registry, AddressType type, u8 realmId, entt::entity entity, u32 previousVersion);
+};
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include <thread>
 #include <Utils/Timer.h>
 #include "Utils/ServiceLocator.h"
+#include "Utils/Settings.h"
+#include "Utils/ThreadAffinity.h"
+#include "Network/UringTransport.h"
+#include "Network/PeerMessages.h"
 #include <Networking/InputQueue.h>
 #include <Networking/MessageHandler.h>
 #include <Networking/NetworkClient.h>
@@ -9,24 +13,39 @@
 
 // Component Singletons
 #include "ECS/Components/Singletons/TimeSingleton.h"
+#include "ECS/Components/Singletons/TimerSingleton.h"
+#include "ECS/Components/Singletons/FrameSingleton.h"
 #include "ECS/Components/Network/ConnectionSingleton.h"
 #include "ECS/Components/Network/AuthenticationSingleton.h"
 #include "ECS/Components/Network/LoadBalanceSingleton.h"
+#include "ECS/Components/Network/PeerSingleton.h"
+#include "ECS/Components/Network/ReplicationSingleton.h"
+#include "ECS/Components/Network/AddressRequestSingleton.h"
+#include "ECS/Components/Network/RttSingleton.h"
+#include "ECS/Components/Network/SharedTableSingleton.h"
 
 // Components
 
 // Systems
 #include "ECS/Systems/Network/ConnectionSystems.h"
+#include "ECS/Systems/Network/LoadBalanceSystems.h"
+#include "ECS/Systems/Network/PeerSystems.h"
+#include "ECS/Systems/Network/ReplicationSystems.h"
+#include "ECS/Systems/Network/AddressRequestSystems.h"
+#include "ECS/Systems/Network/RttSystems.h"
+#include "ECS/Systems/Network/SharedTableSystems.h"
 
 // Handlers
 #include "Network/Handlers/Auth/AuthHandlers.h"
 #include "Network/Handlers/GeneralHandlers.h"
 
 EngineLoop::EngineLoop()
-    : _isRunning(false), _inputQueue(256), _outputQueue(16)
+    : _isRunning(false), _inputQueue(256), _outputQueue(16), _commandQueue(16)
 {
     _network.asioService = std::make_shared<asio::io_service>(2);
     _network.client = std::make_shared<NetworkClient>(new asio::ip::tcp::socket(*_network.asioService.get()));
+
+    ServiceLocator::SetEngineWakeEvent(&_wakeEvent);
 }
 
 EngineLoop::~EngineLoop()
@@ -58,6 +77,7 @@ void EngineLoop::Stop()
 void EngineLoop::PassMessage(Message& message)
 {
     _inputQueue.enqueue(message);
+    _wakeEvent.Wake();
 }
 
 bool EngineLoop::TryGetMessage(Message& message)
@@ -65,33 +85,221 @@ bool EngineLoop::TryGetMessage(Message& message)
     return _outputQueue.try_dequeue(message);
 }
 
+void EngineLoop::PassCommand(const EngineCommand& command)
+{
+    _commandQueue.enqueue(command);
+    _wakeEvent.Wake();
+}
+
+void EngineLoop::RunWatchdog(FrameSingleton* frameSingleton)
+{
+    // Stalls are reported when the frame ends, this catches the frames that don't end
+    std::chrono::nanoseconds timeout(static_cast<i64>(frameSingleton->watchdogTimeout * 1000000000.0f));
+    u64 reportedFrame = 0;
+
+    while (_isWatchdogRunning)
+    {
+        _watchdogWakeEvent.WaitUntil(std::chrono::steady_clock::now() + timeout / 4);
+
+        u64 frameNumber = frameSingleton->frameNumber;
+        i64 frameStartTime = frameSingleton->frameStartTime;
+        if (frameStartTime == 0 || frameNumber == reportedFrame)
+            continue;
+
+        std::chrono::nanoseconds runningTime = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::nanoseconds(frameStartTime);
+        if (runningTime < timeout)
+            continue;
+
+        std::string activeStages;
+        u32 activeStageBits = frameSingleton->activeStages;
+        for (u32 i = 0; i < static_cast<u32>(FrameStage::COUNT); i++)
+        {
+            if (activeStageBits & (1u << i))
+            {
+                activeStages += activeStages.empty() ? "" : ", ";
+                activeStages += GetFrameStageName(static_cast<FrameStage>(i));
+            }
+        }
+
+        Logger::PrintWarning("[Engine]: Frame %llu has been running for %.0f ms, in %s", frameNumber, std::chrono::duration<f32, std::milli>(runningTime).count(), activeStages.empty() ? "between stages" : activeStages.c_str());
+        reportedFrame = frameNumber;
+    }
+}
 void EngineLoop::RunIoService()
 {
+    ThreadAffinity::Apply("io");
+
     asio::io_service::work ioWork(*_network.asioService.get());
     _network.asioService->run();
 }
 void EngineLoop::Run()
 {
+    // Pin before anything is allocated so the engine's memory is first touched on the local NUMA node
+    ThreadAffinity::Apply("engine");
+
     _isRunning = true;
 
     SetupUpdateFramework();
+    PinWorkers();
     _updateFramework.gameRegistry.create();
 
     TimeSingleton& timeSingleton = _updateFramework.gameRegistry.set<TimeSingleton>();
+    TimerSingleton& timerSingleton = _updateFramework.gameRegistry.set<TimerSingleton>();
+    FrameSingleton& frameSingleton = _updateFramework.gameRegistry.set<FrameSingleton>();
     ConnectionSingleton& connectionSingleton = _updateFramework.gameRegistry.set<ConnectionSingleton>();
     LoadBalanceSingleton& loadBalanceSingleton = _updateFramework.gameRegistry.set<LoadBalanceSingleton>();
     AuthenticationSingleton& authenticationSingleton = _updateFramework.gameRegistry.set<AuthenticationSingleton>();
+    PeerSingleton& peerSingleton = _updateFramework.gameRegistry.set<PeerSingleton>();
+    ReplicationSingleton& replicationSingleton = _updateFramework.gameRegistry.set<ReplicationSingleton>();
+    AddressRequestSingleton& addressRequestSingleton = _updateFramework.gameRegistry.set<AddressRequestSingleton>();
+    RttSingleton& rttSingleton = _updateFramework.gameRegistry.set<RttSingleton>();
+    SharedTableSingleton& sharedTableSingleton = _updateFramework.gameRegistry.set<SharedTableSingleton>();
+
+    addressRequestSingleton.numWorkers = _updateFramework.taskflow.num_workers();
+
+    std::string transport = Settings::GetString("network.transport", "asio");
+    if (transport == "uring")
+    {
+#ifdef NC_IO_URING
+        std::unique_ptr<UringTransport> uringTransport = std::make_unique<UringTransport>();
+        if (uringTransport->Init())
+            connectionSingleton.transport = std::move(uringTransport);
+        else
+            Logger::PrintWarning("[Network]: io_uring is unavailable on this kernel, falling back to asio");
+#else
+        Logger::PrintWarning("[Network]: io_uring is only available on Linux, falling back to asio");
+#endif
+    }
+    else if (transport != "asio")
+    {
+        Logger::PrintWarning("[Network]: Unknown network.transport \"%s\", falling back to asio", transport.c_str());
+    }
+
+    if (!connectionSingleton.transport)
+        connectionSingleton.transport = std::make_unique<AsioTransport>();
+
+    Logger::Print("[Network]: Sending responses through %s", connectionSingleton.transport->GetName());
+
+    connectionSingleton.sendQueueMaxBytes = static_cast<size_t>(Settings::GetInt("send.maxbytes", static_cast<i64>(connectionSingleton.sendQueueMaxBytes)));
+    connectionSingleton.sendQueueMaxBuffers = static_cast<size_t>(Settings::GetInt("send.maxbuffers", static_cast<i64>(connectionSingleton.sendQueueMaxBuffers)));
+    connectionSingleton.maxDeferredRequests = static_cast<size_t>(Settings::GetInt("send.maxdeferred", static_cast<i64>(connectionSingleton.maxDeferredRequests)));
+
+    // Routing state is partitioned into shards that are routed in parallel, one per worker unless configured
+    loadBalanceSingleton.SetNumShards(static_cast<size_t>(Settings::GetInt("routing.shards", addressRequestSingleton.numWorkers)));
+
+    loadBalanceSingleton.leaseDuration = Settings::GetFloat("lease.duration", loadBalanceSingleton.leaseDuration);
+    loadBalanceSingleton.reservationTimeout = Settings::GetFloat("placement.reservationtimeout", loadBalanceSingleton.reservationTimeout);
+    loadBalanceSingleton.placementPolicy = Settings::GetString("placement.policy", "worstfit") == "bestfit" ? PlacementPolicy::BEST_FIT : PlacementPolicy::WORST_FIT;
+    loadBalanceSingleton.slowStartDuration = Settings::GetFloat("slowstart.duration", loadBalanceSingleton.slowStartDuration);
+    loadBalanceSingleton.loadHalfLife = Settings::GetFloat("load.halflife", loadBalanceSingleton.loadHalfLife);
+
+    // Both requesters and servers are placed into regions by address prefix, without a map every server is equally close
+    RegionMap regionMap;
+    if (regionMap.Parse(Settings::GetString("region.map", "")))
+    {
+        loadBalanceSingleton.SetRegionMap(regionMap);
+        if (!regionMap.IsEmpty())
+            Logger::Print("[LoadBalancer]: Routing by region, %u prefixes", static_cast<u32>(regionMap.GetNumPrefixes()));
+    }
+    else
+    {
+        Logger::PrintWarning("[LoadBalancer]: Invalid region.map, expected a list like 10.1.0.0/16=0, 10.2.0.0/16=1");
+    }
+
+    // Peer load reports go over UDP, port 0 binds an ephemeral port which is what we then register with Novus-Service
+    if (Settings::GetBool("peer.enabled", true))
+    {
+        peerSingleton.gossipInterval = Settings::GetFloat("peer.interval", peerSingleton.gossipInterval);
+        peerSingleton.peerTimeout = Settings::GetFloat("peer.timeout", peerSingleton.peerTimeout);
+
+        i64 gossipBudget = Settings::GetInt("peer.budget", peerSingleton.gossipBudget);
+        if (gossipBudget < static_cast<i64>(PEER_MIN_GOSSIP_BUDGET))
+            Logger::PrintWarning("[Network/Peer]: peer.budget must fit at least one server (%u bytes), keeping %u", static_cast<u32>(PEER_MIN_GOSSIP_BUDGET), static_cast<u32>(peerSingleton.gossipBudget));
+        else
+            peerSingleton.gossipBudget = std::min(static_cast<size_t>(gossipBudget), PEER_DATAGRAM_SIZE);
+
+        peerSingleton.socket = std::make_shared<PeerSocket>(_network.asioService);
+        if (!peerSingleton.socket->Open(static_cast<u16>(Settings::GetInt("peer.port", 0))))
+        {
+            peerSingleton.socket = nullptr;
+        }
+    }
+
+    // RTT to Novus-Service and the peers is sampled every interval, backends are only probed on request unless rtt.backends is set
+    rttSingleton.asioService = _network.asioService;
+    rttSingleton.sampleInterval = Settings::GetFloat("rtt.interval", rttSingleton.sampleInterval);
+    rttSingleton.backendProbeInterval = Settings::GetFloat("rtt.backends", rttSingleton.backendProbeInterval);
+    rttSingleton.probeTimeout = static_cast<u32>(Settings::GetFloat("rtt.timeout", rttSingleton.probeTimeout / 1000.0f) * 1000.0f);
+
+    // Processes on this host can route without a round trip by reading the table from shared memory, see SharedTableFormat.h
+    std::string sharedTableName = Settings::GetString("shm.name", "");
+    if (!sharedTableName.empty())
+    {
+        sharedTableSingleton.refreshInterval = Settings::GetFloat("shm.interval", sharedTableSingleton.refreshInterval);
+
+        u32 maxEntries = static_cast<u32>(Settings::GetInt("shm.maxservers", 1024));
+        if (sharedTableSingleton.writer.Open(sharedTableName, maxEntries))
+            Logger::Print("[SharedTable]: Publishing up to %u servers to %s", maxEntries, sharedTableName.c_str());
+        else
+            Logger::PrintWarning("[SharedTable]: Could not open shared memory %s, running without it", sharedTableName.c_str());
+    }
+
+    // Hot standby pairs replicate over the peer socket, ha.partner is the other load balancer's peer.port
+    std::string replicationRole = Settings::GetString("ha.role", "none");
+    if (replicationRole == "active" || replicationRole == "standby")
+    {
+        std::string partner = Settings::GetString("ha.partner", "");
+        size_t separator = partner.find(':');
+
+        asio::error_code error;
+        asio::ip::address_v4 partnerAddress = asio::ip::make_address_v4(partner.substr(0, separator), error);
+
+        if (!peerSingleton.socket)
+        {
+            Logger::PrintWarning("[Replication]: ha.role requires the peer socket, running without a partner");
+        }
+        else if (separator == std::string::npos || error)
+        {
+            Logger::PrintWarning("[Replication]: ha.partner must be ip:port, got \"%s\"", partner.c_str());
+        }
+        else
+        {
+            replicationSingleton.role = replicationRole == "active" ? ReplicationRole::ACTIVE : ReplicationRole::STANDBY;
+            replicationSingleton.partnerAddress = partnerAddress.to_uint();
+            replicationSingleton.partnerPort = static_cast<u16>(std::atoi(partner.c_str() + separator + 1));
+            replicationSingleton.heartbeatInterval = Settings::GetFloat("ha.heartbeat", replicationSingleton.heartbeatInterval);
+            replicationSingleton.failoverTimeout = Settings::GetFloat("ha.timeout", replicationSingleton.failoverTimeout);
+        }
+    }
 
     connectionSingleton.networkClient = _network.client;
     connectionSingleton.networkClient->SetReadHandler(std::bind(&ConnectionUpdateSystem::HandleRead, std::placeholders::_1));
     connectionSingleton.networkClient->SetConnectHandler(std::bind(&ConnectionUpdateSystem::HandleConnect, std::placeholders::_1, std::placeholders::_2));
     connectionSingleton.networkClient->SetDisconnectHandler(std::bind(&ConnectionUpdateSystem::HandleDisconnect, std::placeholders::_1));
-    connectionSingleton.networkClient->Connect("127.0.0.1", 8000); // This is the IP/Port for the local Novus-Service
+    connectionSingleton.transport->Connect(connectionSingleton.networkClient, connectionSingleton.serviceAddress, connectionSingleton.servicePort);
+
+    // Frame times are always tracked, stalls are logged with what the frame was doing since we rarely have a profiler attached when they happen
+    frameSingleton.stallThreshold = Settings::GetFloat("stall.threshold", frameSingleton.stallThreshold);
+    frameSingleton.watchdogTimeout = Settings::GetFloat("stall.watchdog", frameSingleton.watchdogTimeout);
+    frameSingleton.reportInterval = Settings::GetFloat("stall.interval", frameSingleton.reportInterval);
+
+    if (frameSingleton.watchdogTimeout > 0.0f)
+    {
+        _isWatchdogRunning = true;
+        _watchdogThread = std::thread(&EngineLoop::RunWatchdog, this, &frameSingleton);
+    }
 
     Timer timer;
     f32 targetDelta = 1.0f / 60.0f;
     bool shouldFrameSync = false;
 
+    // Without frame sync the loop sleeps until the next timer is due or work is queued, but never longer than this, 0 spins instead.
+    // Periodic and deadline work all runs off the wheel and everything queued for the engine wakes it, so this is only a safety net
+    f32 maxIdleTime = Settings::GetFloat("engine.maxidle", 1.0f);
+
+    // The wheel runs on its own millisecond clock, the f32 lifetime loses millisecond precision after a few hours
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
     while (true)
     {
         f32 deltaTime = timer.GetDeltaTime();
@@ -101,9 +309,33 @@ void EngineLoop::Run()
         timeSingleton.lifeTimeInMS = timeSingleton.lifeTimeInS * 1000;
         timeSingleton.deltaTime = deltaTime;
 
+        // Idle time between frames doesn't count, a frame is the timers and Update
+        std::chrono::steady_clock::time_point frameStartTime = std::chrono::steady_clock::now();
+        frameSingleton.diagnostics = FrameDiagnostics();
+        frameSingleton.diagnostics.inputQueueDepth = _inputQueue.size_approx();
+        frameSingleton.diagnostics.commandQueueDepth = _commandQueue.size_approx();
+        frameSingleton.diagnostics.packetQueueDepth = connectionSingleton.packetQueue.size_approx();
+        frameSingleton.frameNumber++;
+        frameSingleton.frameStartTime = std::chrono::duration_cast<std::chrono::nanoseconds>(frameStartTime.time_since_epoch()).count();
+
+        {
+            ZoneScopedNC("Timers", tracy::Color::Blue2)
+            FrameStageScope stageScope(frameSingleton, FrameStage::TIMERS);
+            timerSingleton.wheel.Advance(static_cast<u64>(std::chrono::duration_cast<std::chrono::milliseconds>(frameStartTime - startTime).count()));
+        }
+
         if (!Update())
             break;
 
+        f32 frameTime = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - frameStartTime).count();
+        frameSingleton.frameStartTime = 0;
+        frameSingleton.histogram.Add(frameTime);
+
+        if (frameTime > frameSingleton.stallThreshold * 1000.0f)
+        {
+            ReportStall(frameSingleton, frameTime, timeSingleton.lifeTimeInS);
+        }
+
         if (shouldFrameSync)
         {
             ZoneScopedNC("WaitForTickRate", tracy::Color::AntiqueWhite1)
@@ -122,22 +354,85 @@ void EngineLoop::Run()
                 }
             }
         }
+        else if (maxIdleTime > 0.0f)
+        {
+            ZoneScopedNC("Idle", tracy::Color::AntiqueWhite1)
+
+            std::chrono::steady_clock::time_point wakeTime = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<i64>(maxIdleTime * 1000000.0f));
+
+            u64 nextDeadline = timerSingleton.wheel.GetNextDeadline();
+            if (nextDeadline != ~0ull)
+                wakeTime = std::min(wakeTime, startTime + std::chrono::milliseconds(nextDeadline));
+
+            // Completions nobody wakes us for are reaped by the next frame's Flush
+            if (connectionSingleton.transport->IsFlushPending())
+                wakeTime = std::min(wakeTime, std::chrono::steady_clock::now() + std::chrono::milliseconds(1));
+
+            _wakeEvent.WaitUntil(wakeTime);
+        }
 
         FrameMark
     }
 
     // Clean up stuff here
 
+    // The watchdog reads the FrameSingleton, it has to be gone before the registry is
+    if (_watchdogThread.joinable())
+    {
+        _isWatchdogRunning = false;
+        _watchdogWakeEvent.Wake();
+        _watchdogThread.join();
+    }
+
     Message exitMessage;
     exitMessage.code = MSG_OUT_EXIT_CONFIRM;
     _outputQueue.enqueue(exitMessage);
 }
 
+void EngineLoop::ReportStall(FrameSingleton& frameSingleton, f32 frameTime, f32 lifeTime)
+{
+    frameSingleton.numStalls++;
+    if (lifeTime - frameSingleton.lastReportTime < frameSingleton.reportInterval)
+    {
+        frameSingleton.numSuppressedStalls++;
+        return;
+    }
+
+    frameSingleton.lastReportTime = lifeTime;
+    const FrameDiagnostics& diagnostics = frameSingleton.diagnostics;
+
+    Logger::PrintWarning("[Engine]: Frame %llu took %.1f ms, over the %.1f ms stall threshold (%llu stalls not reported since the last one)", frameSingleton.frameNumber.load(), frameTime, frameSingleton.stallThreshold * 1000.0f, frameSingleton.numSuppressedStalls);
+    Logger::PrintWarning("    Queued at frame start: %u messages, %u commands, %u packets", static_cast<u32>(diagnostics.inputQueueDepth), static_cast<u32>(diagnostics.commandQueueDepth), static_cast<u32>(diagnostics.packetQueueDepth));
+    Logger::PrintWarning("    Handled %u packets and %u address requests, last opcode %u, slowest handler opcode %u (%.3f ms)", diagnostics.numPackets, diagnostics.numAddressRequests,
+        static_cast<u32>(diagnostics.lastOpcode), static_cast<u32>(diagnostics.slowestOpcode), diagnostics.slowestHandlerTime);
+
+    // Slowest first, stages run in parallel so these don't add up to the frame time
+    std::array<u8, static_cast<size_t>(FrameStage::COUNT)> stages;
+    for (u8 i = 0; i < stages.size(); i++)
+    {
+        stages[i] = i;
+    }
+
+    std::sort(stages.begin(), stages.end(), [&diagnostics](u8 a, u8 b) { return diagnostics.stageTimes[a] > diagnostics.stageTimes[b]; });
+
+    for (u8 stage : stages)
+    {
+        if (diagnostics.stageTimes[stage] < 0.01f)
+            break;
+
+        Logger::PrintWarning("    %s: %.3f ms", GetFrameStageName(static_cast<FrameStage>(stage)), diagnostics.stageTimes[stage]);
+    }
+
+    frameSingleton.numSuppressedStalls = 0;
+}
+
 bool EngineLoop::Update()
 {
     ZoneScopedNC("Update", tracy::Color::Blue2)
+    FrameSingleton& frameSingleton = _updateFramework.gameRegistry.ctx<FrameSingleton>();
     {
         ZoneScopedNC("HandleMessages", tracy::Color::Green3)
+        FrameStageScope stageScope(frameSingleton, FrameStage::MESSAGES);
             Message message;
 
         while (_inputQueue.try_dequeue(message))
@@ -152,13 +447,20 @@ bool EngineLoop::Update()
             else if (message.code == MSG_IN_PING)
             {
                 ZoneScopedNC("Ping", tracy::Color::Green3)
-                    Message pongMessage;
-                pongMessage.code = MSG_OUT_PRINT;
-                pongMessage.message = new std::string("PONG!");
-                _outputQueue.enqueue(pongMessage);
+                PrintMessage("PONG!");
             }
         }
     }
+    {
+        ZoneScopedNC("HandleCommands", tracy::Color::Green3)
+        FrameStageScope stageScope(frameSingleton, FrameStage::COMMANDS);
+            EngineCommand command;
+
+        while (_commandQueue.try_dequeue(command))
+        {
+            command(_updateFramework.gameRegistry);
+        }
+    }
 
     UpdateSystems();
     return true;
@@ -172,12 +474,135 @@ void EngineLoop::SetupUpdateFramework()
     ServiceLocator::SetRegistry(&gameRegistry);
     SetMessageHandler();
 
-    // ConnectionUpdateSystem
+    /*
+        A frame runs in stages: decode, route, encode/send and maintenance, decode, route and encode fan out over the workers.
+        Maintenance only needs the routing table to be settled, so it runs next to encode/send.
+        A subflow is joined after its task returns, so the stages that fan out are timed until the task that follows them starts.
+    */
+
+    // ConnectionUpdateSystem, runs the handlers and queues address requests
     tf::Task connectionUpdateSystemTask = framework.emplace([&gameRegistry]()
     {
         ZoneScopedNC("ConnectionUpdateSystem::Update", tracy::Color::Blue2)
+        FrameStageScope stageScope(gameRegistry.ctx<FrameSingleton>(), FrameStage::CONNECTION);
         ConnectionUpdateSystem::Update(gameRegistry);
     });
+
+    // AddressRequestDecodeSystem
+    tf::Task addressRequestDecodeSystemTask = framework.emplace([&gameRegistry](tf::Subflow& subflow)
+    {
+        ZoneScopedNC("AddressRequestDecodeSystem::Update", tracy::Color::Blue2)
+        gameRegistry.ctx<FrameSingleton>().BeginStage(FrameStage::ADDRESS_REQUEST_DECODE);
+        AddressRequestDecodeSystem::Update(gameRegistry, subflow);
+    });
+    connectionUpdateSystemTask.precede(addressRequestDecodeSystemTask);
+
+    // AddressRequestRouteSystem
+    tf::Task addressRequestRouteSystemTask = framework.emplace([&gameRegistry](tf::Subflow& subflow)
+    {
+        ZoneScopedNC("AddressRequestRouteSystem::Update", tracy::Color::Blue2)
+        FrameSingleton& frameSingleton = gameRegistry.ctx<FrameSingleton>();
+        frameSingleton.EndStage(FrameStage::ADDRESS_REQUEST_DECODE);
+        frameSingleton.BeginStage(FrameStage::ADDRESS_REQUEST_ROUTE);
+        AddressRequestRouteSystem::Update(gameRegistry, subflow);
+    });
+    addressRequestDecodeSystemTask.precede(addressRequestRouteSystemTask);
+
+    // AddressResponseEncodeSystem
+    tf::Task addressResponseEncodeSystemTask = framework.emplace([&gameRegistry](tf::Subflow& subflow)
+    {
+        ZoneScopedNC("AddressResponseEncodeSystem::Update", tracy::Color::Blue2)
+        FrameSingleton& frameSingleton = gameRegistry.ctx<FrameSingleton>();
+        frameSingleton.EndStage(FrameStage::ADDRESS_REQUEST_ROUTE);
+        frameSingleton.BeginStage(FrameStage::ADDRESS_RESPONSE_ENCODE);
+        AddressResponseEncodeSystem::Update(gameRegistry, subflow);
+    });
+    addressRequestRouteSystemTask.precede(addressResponseEncodeSystemTask);
+
+    // AddressResponseSendSystem
+    tf::Task addressResponseSendSystemTask = framework.emplace([&gameRegistry]()
+    {
+        ZoneScopedNC("AddressResponseSendSystem::Update", tracy::Color::Blue2)
+        FrameSingleton& frameSingleton = gameRegistry.ctx<FrameSingleton>();
+        frameSingleton.EndStage(FrameStage::ADDRESS_RESPONSE_ENCODE);
+        FrameStageScope stageScope(frameSingleton, FrameStage::ADDRESS_RESPONSE_SEND);
+        AddressResponseSendSystem::Update(gameRegistry);
+    });
+    addressResponseEncodeSystemTask.precede(addressResponseSendSystemTask);
+
+    // LoadBalanceUpdateSystem
+    tf::Task loadBalanceUpdateSystemTask = framework.emplace([&gameRegistry]()
+    {
+        ZoneScopedNC("LoadBalanceUpdateSystem::Update", tracy::Color::Blue2)
+        FrameStageScope stageScope(gameRegistry.ctx<FrameSingleton>(), FrameStage::LOAD_BALANCE);
+        LoadBalanceUpdateSystem::Update(gameRegistry);
+    });
+    addressRequestRouteSystemTask.precede(loadBalanceUpdateSystemTask);
+
+    // PeerUpdateSystem
+    tf::Task peerUpdateSystemTask = framework.emplace([&gameRegistry]()
+    {
+        ZoneScopedNC("PeerUpdateSystem::Update", tracy::Color::Blue2)
+        FrameStageScope stageScope(gameRegistry.ctx<FrameSingleton>(), FrameStage::PEER);
+        PeerUpdateSystem::Update(gameRegistry);
+    });
+    loadBalanceUpdateSystemTask.precede(peerUpdateSystemTask);
+
+    // ReplicationUpdateSystem
+    tf::Task replicationUpdateSystemTask = framework.emplace([&gameRegistry]()
+    {
+        ZoneScopedNC("ReplicationUpdateSystem::Update", tracy::Color::Blue2)
+        FrameStageScope stageScope(gameRegistry.ctx<FrameSingleton>(), FrameStage::REPLICATION);
+        ReplicationUpdateSystem::Update(gameRegistry);
+    });
+    peerUpdateSystemTask.precede(replicationUpdateSystemTask);
+    addressResponseSendSystemTask.precede(replicationUpdateSystemTask); // Promotion registers through the network client
+
+    // RttUpdateSystem
+    tf::Task rttUpdateSystemTask = framework.emplace([&gameRegistry]()
+    {
+        ZoneScopedNC("RttUpdateSystem::Update", tracy::Color::Blue2)
+        FrameStageScope stageScope(gameRegistry.ctx<FrameSingleton>(), FrameStage::RTT);
+        RttUpdateSystem::Update(gameRegistry);
+    });
+    peerUpdateSystemTask.precede(rttUpdateSystemTask); // Pongs are recorded by PeerUpdateSystem
+    replicationUpdateSystemTask.precede(rttUpdateSystemTask); // Both arm timers, the wheel isn't thread safe
+
+    // SharedTableUpdateSystem
+    tf::Task sharedTableUpdateSystemTask = framework.emplace([&gameRegistry]()
+    {
+        ZoneScopedNC("SharedTableUpdateSystem::Update", tracy::Color::Blue2)
+        FrameStageScope stageScope(gameRegistry.ctx<FrameSingleton>(), FrameStage::SHARED_TABLE);
+        SharedTableUpdateSystem::Update(gameRegistry);
+    });
+    replicationUpdateSystemTask.precede(sharedTableUpdateSystemTask);
+    rttUpdateSystemTask.precede(sharedTableUpdateSystemTask); // Reads the table after everything that changes it this frame
+}
+void EngineLoop::PinWorkers()
+{
+    // Taskflow has no per worker start hook, so every worker is handed one task and they are held until all of them have one
+    tf::Framework pinFramework;
+    size_t numWorkers = _updateFramework.taskflow.num_workers();
+    std::atomic<size_t> numArrived = 0;
+
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        pinFramework.emplace([i, numWorkers, &numArrived]()
+        {
+            numArrived++;
+
+            auto giveUpTime = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            while (numArrived < numWorkers && std::chrono::steady_clock::now() < giveUpTime)
+            {
+                std::this_thread::yield();
+            }
+
+            ThreadAffinity::Apply("workers", i);
+        });
+    }
+
+    _updateFramework.taskflow.run(pinFramework);
+    _updateFramework.taskflow.wait_for_all();
 }
 void EngineLoop::SetMessageHandler()
 {
@@ -25,10 +25,15 @@
 #include <NovusTypes.h>
 #include <entt.hpp>
 #include <taskflow/taskflow.hpp>
+#include <functional>
+#include <thread>
+#include <atomic>
 #include <asio/io_service.hpp>
 #include <Utils/Message.h>
 #include <Utils/StringUtils.h>
 #include <Utils/ConcurrentQueue.h>
+#include "Utils/Logger.h"
+#include "Utils/WakeEvent.h"
 #include <Networking/NetworkServer.h>
 
 namespace tf
@@ -36,6 +41,7 @@ namespace tf
 class Framework;
 }
 
+struct FrameSingleton;
 struct FrameworkRegistryPair
 {
     entt::registry gameRegistry;
@@ -43,6 +49,9 @@ struct FrameworkRegistryPair
     tf::Taskflow taskflow;
 };
 
+// Runs on the engine thread at the start of the next frame, this is how other threads touch the registry
+using EngineCommand = std::function<void(entt::registry&)>;
+
 struct NetworkPair
 {
     std::shared_ptr<NetworkClient> client;
@@ -60,32 +69,38 @@ public:
 
     void PassMessage(Message& message);
     bool TryGetMessage(Message& message);
+    void PassCommand(const EngineCommand& command);
+
+    std::shared_ptr<asio::io_service> GetAsioService() { return _network.asioService; }
 
     template <typename... Args>
-    void PrintMessage(std::string message, Args... args)
+    void PrintMessage(const char* message, const Args&... args)
     {
-        char str[256];
-        StringUtils::FormatString(str, sizeof(str), message.c_str(), args...);
-
-        Message printMessage;
-        printMessage.code = MSG_OUT_PRINT;
-        printMessage.message = new std::string(str);
-        _outputQueue.enqueue(printMessage);
+        Logger::Print(message, args...);
     }
 
 private:
     void Run();
     void RunIoService();
+    void RunWatchdog(FrameSingleton* frameSingleton);
     bool Update();
     void UpdateSystems();
+    void ReportStall(FrameSingleton& frameSingleton, f32 frameTime, f32 lifeTime);
 
     void SetupUpdateFramework();
+    void PinWorkers();
     void SetMessageHandler();
 private:
     bool _isRunning;
 
     moodycamel::ConcurrentQueue<Message> _inputQueue;
     moodycamel::ConcurrentQueue<Message> _outputQueue;
+    moodycamel::ConcurrentQueue<EngineCommand> _commandQueue;
+    WakeEvent _wakeEvent;
+
+    std::thread _watchdogThread;
+    std::atomic<bool> _isWatchdogRunning = false;
+    WakeEvent _watchdogWakeEvent; // Lets Run stop the watchdog without waiting out its sleep
     FrameworkRegistryPair _updateFramework;
     NetworkPair _network;
 };
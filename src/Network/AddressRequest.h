@@ -0,0 +1,205 @@
+#pragma once
+#include <NovusTypes.h>
+#include <algorithm>
+#include <Networking/Opcode.h>
+#include <Networking/AddressType.h>
+#include <Utils/ByteBuffer.h>
+
+/*
+    MSG_REQUEST_ADDRESS keeps its original layout (AddressType followed by an opaque payload we echo back).
+    Setting ADDRESS_REQUEST_EXTENDED on the type byte means a flags byte follows, and every set flag appends its own fields in flag order.
+    Requests without the bit are answered exactly like before.
+*/
+constexpr u8 ADDRESS_REQUEST_EXTENDED = 0x80;
+constexpr size_t ADDRESS_REQUEST_MAX_SIZE = 128;
+
+enum AddressRequestFlags : u8
+{
+    ADDRESS_REQUEST_FLAG_NONE = 0,
+    ADDRESS_REQUEST_FLAG_LEASE = 1 << 0, // Response carries a lease (u32 durationMS, u32 tableVersion)
+    ADDRESS_REQUEST_FLAG_REALM = 1 << 1, // Request carries the target realm (u8 realmId)
+    ADDRESS_REQUEST_FLAG_COST = 1 << 2, // Request carries the expected instance size (u16 cost)
+    ADDRESS_REQUEST_FLAG_CANDIDATES = 1 << 3, // Request carries how many alternates it wants (u8), response carries u8 count and (u32 address, u16 port) per alternate, best first
+    ADDRESS_REQUEST_FLAG_RACE_RESULT = 1 << 4, // Request carries which server of its previous response it connected to (u8, 0 the primary, 1.. the alternates, ADDRESS_RACE_NONE)
+    ADDRESS_REQUEST_FLAG_SOURCE = 1 << 5 // Request carries the address of the client it is made for (u32, host order), servers in the client's region are preferred
+};
+
+// Alternates let a client race connections or fail over without another round trip, they are ranked but not charged to the servers
+constexpr u8 ADDRESS_MAX_CANDIDATES = 4;
+constexpr u8 ADDRESS_RACE_NONE = 0xFF;
+
+struct AddressCandidate
+{
+    u32 address = 0;
+    u16 port = 0;
+};
+
+enum AddressStatus : u8
+{
+    ADDRESS_STATUS_NOT_FOUND = 0,
+    ADDRESS_STATUS_SUCCESS = 1,
+    ADDRESS_STATUS_UNKNOWN_REALM = 2, // Only sent to extended requests, legacy requesters get ADDRESS_STATUS_NOT_FOUND
+    ADDRESS_STATUS_NO_CAPACITY = 3,   // Servers exist but none of them can take the request right now, same legacy fallback
+    ADDRESS_STATUS_OVERLOADED = 4     // We are not keeping up with the requester, it should back off or ask another load balancer, same legacy fallback
+};
+
+struct AddressRequest
+{
+    AddressType type = AddressType::INVALID;
+    u8 flags = ADDRESS_REQUEST_FLAG_NONE;
+    u8 realmId = 0;
+    u16 cost = 1;
+    u8 numCandidates = 0;
+    u8 raceResult = ADDRESS_RACE_NONE;
+    u32 sourceAddress = 0;
+
+    bool IsExtended() const { return _isExtended; }
+    bool HasFlag(AddressRequestFlags flag) const { return (flags & flag) != 0; }
+
+    bool Deserialize(std::shared_ptr<Bytebuffer>& buffer)
+    {
+        u8 typeByte = 0;
+        if (!buffer->GetU8(typeByte))
+            return false;
+
+        _isExtended = (typeByte & ADDRESS_REQUEST_EXTENDED) != 0;
+        type = static_cast<AddressType>(typeByte & ~ADDRESS_REQUEST_EXTENDED);
+
+        if (type < AddressType::AUTH || type >= AddressType::COUNT)
+            return false;
+
+        if (_isExtended)
+        {
+            if (!buffer->GetU8(flags))
+                return false;
+
+            if (HasFlag(ADDRESS_REQUEST_FLAG_REALM) && !buffer->GetU8(realmId))
+                return false;
+
+            if (HasFlag(ADDRESS_REQUEST_FLAG_COST) && !buffer->GetU16(cost))
+                return false;
+
+            if (HasFlag(ADDRESS_REQUEST_FLAG_CANDIDATES))
+            {
+                if (!buffer->GetU8(numCandidates))
+                    return false;
+
+                numCandidates = std::min(numCandidates, ADDRESS_MAX_CANDIDATES);
+            }
+
+            if (HasFlag(ADDRESS_REQUEST_FLAG_RACE_RESULT) && !buffer->GetU8(raceResult))
+                return false;
+
+            if (HasFlag(ADDRESS_REQUEST_FLAG_SOURCE) && !buffer->GetU32(sourceAddress))
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    bool _isExtended = false;
+};
+
+// The candidates field of a response, written when the request set ADDRESS_REQUEST_FLAG_CANDIDATES even if there are none
+inline bool WriteAddressCandidates(std::shared_ptr<Bytebuffer>& buffer, const AddressCandidate* candidates, u8 numCandidates)
+{
+    if (!buffer->PutU8(numCandidates))
+        return false;
+
+    for (u8 i = 0; i < numCandidates; i++)
+    {
+        if (!buffer->PutU32(candidates[i].address) || !buffer->PutU16(candidates[i].port))
+            return false;
+    }
+
+    return true;
+}
+
+struct AddressResponse
+{
+    u8 status = ADDRESS_STATUS_NOT_FOUND;
+    u32 address = 0;
+    u16 port = 0;
+
+    u32 leaseDurationMS = 0;
+    u32 tableVersion = 0;
+
+    u8 numCandidates = 0;
+    AddressCandidate candidates[ADDRESS_MAX_CANDIDATES];
+
+    // Writes the full SMSG_SEND_ADDRESS packet for an extended request, fields appear in the same order as the request flags
+    bool Serialize(std::shared_ptr<Bytebuffer>& buffer, const AddressRequest& request, u8* payload, size_t payloadSize)
+    {
+        if (!buffer->Put(Opcode::SMSG_SEND_ADDRESS))
+            return false;
+
+        size_t sizeOffset = buffer->writtenData;
+        if (!buffer->SkipWrite(sizeof(u16)))
+            return false;
+
+        size_t payloadStart = buffer->writtenData;
+        if (!buffer->PutU8(status) || !buffer->PutU32(address) || !buffer->PutU16(port))
+            return false;
+
+        if (request.HasFlag(ADDRESS_REQUEST_FLAG_LEASE))
+        {
+            if (!buffer->PutU32(leaseDurationMS) || !buffer->PutU32(tableVersion))
+                return false;
+        }
+
+        if (request.HasFlag(ADDRESS_REQUEST_FLAG_CANDIDATES) && !WriteAddressCandidates(buffer, candidates, numCandidates))
+            return false;
+
+        if (payloadSize && !buffer->PutBytes(payload, payloadSize))
+            return false;
+
+        u16 size = static_cast<u16>(buffer->writtenData - payloadStart);
+        return buffer->Put<u16>(size, sizeOffset);
+    }
+};
+
+// Opcode, size, status, address and port, the part of a successful response that only depends on the server
+constexpr size_t ADDRESS_RESPONSE_TEMPLATE_SIZE = sizeof(Opcode) + sizeof(u16) + sizeof(u8) + sizeof(u32) + sizeof(u16);
+
+/*
+    A successful SMSG_SEND_ADDRESS for one server, encoded when the server is added or changes instead of for every request.
+    Writing a response is then a copy of the template followed by the requested fields and the echoed payload, and patching the size.
+*/
+struct AddressResponseTemplate
+{
+    u8 data[ADDRESS_RESPONSE_TEMPLATE_SIZE] = { };
+
+    void Build(u32 address, u16 port)
+    {
+        Bytebuffer buffer(data, ADDRESS_RESPONSE_TEMPLATE_SIZE);
+        buffer.Put(Opcode::SMSG_SEND_ADDRESS);
+        buffer.PutU16(0);
+        buffer.PutU8(ADDRESS_STATUS_SUCCESS);
+        buffer.PutU32(address);
+        buffer.PutU16(port);
+    }
+
+    // Same bytes as AddressResponse::Serialize with ADDRESS_STATUS_SUCCESS, and as PacketUtils::Write_SMSG_SEND_ADDRESS for a legacy request
+    bool Write(std::shared_ptr<Bytebuffer>& buffer, const AddressRequest& request, u32 leaseDurationMS, u32 tableVersion, u8* payload, size_t payloadSize, const AddressCandidate* candidates = nullptr, u8 numCandidates = 0)
+    {
+        size_t sizeOffset = buffer->writtenData + sizeof(Opcode);
+        if (!buffer->PutBytes(data, ADDRESS_RESPONSE_TEMPLATE_SIZE))
+            return false;
+
+        if (request.HasFlag(ADDRESS_REQUEST_FLAG_LEASE))
+        {
+            if (!buffer->PutU32(leaseDurationMS) || !buffer->PutU32(tableVersion))
+                return false;
+        }
+
+        if (request.HasFlag(ADDRESS_REQUEST_FLAG_CANDIDATES) && !WriteAddressCandidates(buffer, candidates, numCandidates))
+            return false;
+
+        if (payloadSize && !buffer->PutBytes(payload, payloadSize))
+            return false;
+
+        u16 size = static_cast<u16>(buffer->writtenData - sizeOffset - sizeof(u16));
+        return buffer->Put<u16>(size, sizeOffset);
+    }
+};
\ No newline at end of file
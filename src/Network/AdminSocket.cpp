@@ -0,0 +1,192 @@
+#include "AdminSocket.h"
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+#include <algorithm>
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Only ever remove a socket, a misconfigured path must not delete whatever file it points at
+static void RemoveSocketFile(const std::string& path)
+{
+    struct stat fileStatus;
+    if (lstat(path.c_str(), &fileStatus) == 0 && S_ISSOCK(fileStatus.st_mode))
+        unlink(path.c_str());
+}
+
+AdminSocket::AdminSocket(std::shared_ptr<asio::io_service> asioService, AdminCommandHandler commandHandler)
+    : _asioService(asioService), _acceptor(*asioService.get()), _commandHandler(commandHandler)
+{
+}
+
+bool AdminSocket::Open(const std::string& path)
+{
+    // A socket file left behind by a previous run would make bind fail
+    RemoveSocketFile(path);
+
+    asio::error_code error;
+    asio::local::stream_protocol::endpoint endpoint(path);
+
+    _acceptor.open(endpoint.protocol(), error);
+    if (!error)
+        _acceptor.bind(endpoint, error);
+
+    // The commands change routing, only our own user may connect. Nobody can connect before listen, so there is no window with the umask's permissions
+    if (!error && chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0)
+        error = asio::error_code(errno, asio::error::get_system_category());
+
+    if (!error)
+        _acceptor.listen(asio::socket_base::max_listen_connections, error);
+
+    if (error)
+    {
+        Logger::PrintWarning("[Network/Admin]: Failed to listen on %s (%s)", path, error.message());
+        _acceptor.close(error);
+        return false;
+    }
+
+    _isOpen = true;
+    _path = path;
+    Logger::Print("[Network/Admin]: Listening on %s", path);
+
+    std::shared_ptr<AdminSocket> self = shared_from_this();
+    asio::post(*_asioService.get(), [self]() { self->Accept(); });
+    return true;
+}
+
+void AdminSocket::Close()
+{
+    if (!_isOpen)
+        return;
+
+    _isOpen = false;
+
+    std::shared_ptr<AdminSocket> self = shared_from_this();
+    asio::post(*_asioService.get(), [self]()
+    {
+        asio::error_code error;
+        self->_acceptor.close(error);
+        RemoveSocketFile(self->_path);
+    });
+}
+
+void AdminSocket::Accept()
+{
+    std::shared_ptr<AdminSocket> self = shared_from_this();
+    std::shared_ptr<AdminConnection> connection = std::make_shared<AdminConnection>(_asioService, _commandHandler);
+
+    _acceptor.async_accept(connection->GetSocket(), [self, connection](const asio::error_code& error)
+    {
+        if (error == asio::error::operation_aborted || !self->_isOpen)
+            return;
+
+        if (!error)
+            connection->Start();
+
+        self->Accept();
+    });
+}
+
+AdminConnection::AdminConnection(std::shared_ptr<asio::io_service> asioService, const AdminCommandHandler& commandHandler)
+    : _asioService(asioService), _socket(*asioService.get()), _commandHandler(commandHandler)
+{
+}
+
+void AdminConnection::Read()
+{
+    std::shared_ptr<AdminConnection> self = shared_from_this();
+    _socket.async_read_some(asio::buffer(_readData, sizeof(_readData)), [self](const asio::error_code& error, size_t bytesRead)
+    {
+        if (error)
+            return;
+
+        for (size_t i = 0; i < bytesRead; i++)
+        {
+            char character = self->_readData[i];
+            if (character == '\n')
+            {
+                self->_commands.push_back(std::move(self->_partialLine));
+                self->_partialLine.clear();
+            }
+            else if (character != '\r')
+            {
+                self->_partialLine.push_back(character);
+            }
+        }
+
+        // Nobody sends commands this long, drop the connection instead of buffering forever
+        if (self->_partialLine.size() > ADMIN_MAX_LINE_SIZE)
+        {
+            asio::error_code closeError;
+            self->_socket.close(closeError);
+            return;
+        }
+
+        self->RunNextCommand();
+        self->Read();
+    });
+}
+
+void AdminConnection::RunNextCommand()
+{
+    if (_isRunningCommand || _commands.empty())
+        return;
+
+    std::string command = std::move(_commands.front());
+    _commands.pop_front();
+    _isRunningCommand = true;
+
+    std::transform(command.begin(), command.end(), command.begin(), ::tolower);
+
+    // The reply is sent when the output is released, which can be much later on the engine thread
+    _commandHandler(command, std::make_shared<AdminCommandOutput>(_asioService, shared_from_this()));
+}
+
+void AdminConnection::Reply(std::string& reply)
+{
+    _replies.push_back(std::move(reply));
+    _isRunningCommand = false;
+
+    if (_replies.size() == 1)
+        Write();
+
+    RunNextCommand();
+}
+
+void AdminConnection::Write()
+{
+    std::shared_ptr<AdminConnection> self = shared_from_this();
+    asio::async_write(_socket, asio::buffer(_replies.front()), [self](const asio::error_code& error, size_t bytesWritten)
+    {
+        if (error)
+            return;
+
+        self->_replies.pop_front();
+        if (!self->_replies.empty())
+            self->Write();
+    });
+}
+
+AdminCommandOutput::~AdminCommandOutput()
+{
+    _reply.push_back('\n');
+
+    std::shared_ptr<AdminConnection> connection = _connection;
+    asio::post(*_asioService.get(), [connection, reply = std::move(_reply)]() mutable
+    {
+        connection->Reply(reply);
+    });
+}
+
+void AdminCommandOutput::WriteLine(LogLevel level, const char* line)
+{
+    // An empty line ends the reply
+    if (line[0] == '\0')
+        return;
+
+    if (level == LogLevel::Warning)
+        _reply.append("! ");
+
+    _reply.append(line);
+    _reply.push_back('\n');
+}
+#endif // ASIO_HAS_LOCAL_SOCKETS
\ No newline at end of file
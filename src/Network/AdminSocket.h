@@ -0,0 +1,107 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <asio.hpp>
+#include <deque>
+#include <functional>
+#include "../Utils/CommandOutput.h"
+
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+constexpr size_t ADMIN_READ_SIZE = 512;
+constexpr size_t ADMIN_MAX_LINE_SIZE = 1024;
+
+// Runs a command line, replies go to the output and the command is done once the last reference to it is released
+using AdminCommandHandler = std::function<void(std::string& command, std::shared_ptr<CommandOutput> output)>;
+
+/*
+    Local control socket for orchestration, served on the asio thread.
+    The protocol is line based: the client sends one command per line and every reply is the command's output lines followed by an empty line, warning lines (bad usage, unknown servers) start with "! ".
+    Commands on a connection run one at a time, so replies always come back in request order.
+*/
+class AdminSocket : public std::enable_shared_from_this<AdminSocket>
+{
+public:
+    AdminSocket(std::shared_ptr<asio::io_service> asioService, AdminCommandHandler commandHandler);
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return _isOpen; }
+
+private:
+    void Accept();
+
+private:
+    std::shared_ptr<asio::io_service> _asioService;
+    asio::local::stream_protocol::acceptor _acceptor;
+    AdminCommandHandler _commandHandler;
+
+    bool _isOpen = false;
+    std::string _path;
+};
+
+class AdminConnection : public std::enable_shared_from_this<AdminConnection>
+{
+public:
+    AdminConnection(std::shared_ptr<asio::io_service> asioService, const AdminCommandHandler& commandHandler);
+
+    asio::local::stream_protocol::socket& GetSocket() { return _socket; }
+
+    void Start() { Read(); }
+    void Reply(std::string& reply);
+
+private:
+    void Read();
+    void RunNextCommand();
+    void Write();
+
+private:
+    std::shared_ptr<asio::io_service> _asioService;
+    asio::local::stream_protocol::socket _socket;
+    AdminCommandHandler _commandHandler;
+
+    char _readData[ADMIN_READ_SIZE];
+    std::string _partialLine;
+    std::deque<std::string> _commands;
+    std::deque<std::string> _replies;
+    bool _isRunningCommand = false;
+};
+
+// Collects a command's output, the reply is sent once the command and every engine command it passed along have released it
+class AdminCommandOutput : public CommandOutput
+{
+public:
+    AdminCommandOutput(std::shared_ptr<asio::io_service> asioService, std::shared_ptr<AdminConnection> connection)
+        : _asioService(asioService), _connection(connection) { }
+    ~AdminCommandOutput();
+
+protected:
+    void WriteLine(LogLevel level, const char* line) override;
+
+private:
+    std::shared_ptr<asio::io_service> _asioService;
+    std::shared_ptr<AdminConnection> _connection;
+    std::string _reply;
+};
+#endif // ASIO_HAS_LOCAL_SOCKETS
\ No newline at end of file
@@ -6,9 +6,13 @@
 #include <Utils/ByteBuffer.h>
 #include "../../../Utils/ServiceLocator.h"
 #include "../../../ECS/Components/Network/AuthenticationSingleton.h"
+#include "../../../ECS/Components/Network/ConnectionSingleton.h"
+#include "../../../ECS/Components/Network/PeerSingleton.h"
+#include "../../../ECS/Components/Network/ReplicationSingleton.h"
 
 // @TODO: Remove Temporary Includes when they're no longer needed
-#include <Utils/DebugHandler.h>
+#include "../../../Utils/Logger.h"
+#include "../../../Utils/BufferPool.h"
 
 namespace InternalSocket
 {
@@ -32,8 +36,8 @@ namespace InternalSocket
             return true;
         }
 
-        std::shared_ptr<Bytebuffer> buffer = Bytebuffer::Borrow<36>();
         ClientLogonHandshake clientResponse;
+        std::shared_ptr<Bytebuffer> buffer = BufferPool::BorrowFor(Opcode::CMSG_LOGON_HANDSHAKE, sizeof(clientResponse.M1));
 
         std::memcpy(clientResponse.M1, authenticationSingleton.srp.M, 32);
 
@@ -42,7 +46,11 @@ namespace InternalSocket
 
         u16 payloadSize = clientResponse.Serialize(buffer);
         buffer->Put<u16>(payloadSize, 2);
-        networkClient->Send(buffer);
+        BufferPool::RecordPacket(Opcode::CMSG_LOGON_HANDSHAKE, payloadSize);
+
+        ConnectionSingleton& connectionSingleton = registry->ctx<ConnectionSingleton>();
+        if (!connectionSingleton.transport->Send(networkClient, buffer))
+            return false;
 
         networkClient->SetStatus(ConnectionStatus::AUTH_HANDSHAKE);
         return true;
@@ -58,28 +66,54 @@ namespace InternalSocket
 
         if (!authenticationSingleton.srp.VerifySession(logonResponse.HAMK))
         {
-            DebugHandler::PrintWarning("Unsuccessful Login");
+            Logger::PrintWarning("Unsuccessful Login");
             networkClient->Close(asio::error::no_permission);
             return true;
         }
         else
         {
-            DebugHandler::PrintSuccess("Successful Login");
+            Logger::PrintSuccess("Successful Login");
+        }
+
+        PeerSingleton& peerSingleton = registry->ctx<PeerSingleton>();
+        auto localEndpoint = networkClient->socket()->local_endpoint();
+        peerSingleton.localAddress = localEndpoint.address().to_v4().to_uint();
+
+        // Novus-Service would route clients to us, the standby stays unregistered until the active load balancer goes quiet
+        ReplicationSingleton& replicationSingleton = registry->ctx<ReplicationSingleton>();
+        if (replicationSingleton.role == ReplicationRole::STANDBY)
+        {
+            Logger::Print("[Replication]: Running as standby, registration is deferred until failover");
+            replicationSingleton.isAwaitingRegistration = true;
+        }
+        else
+        {
+            SendConnected(networkClient);
         }
 
-        std::shared_ptr<Bytebuffer> buffer = Bytebuffer::Borrow<128>();
+        networkClient->SetStatus(ConnectionStatus::AUTH_SUCCESS);
+        return true;
+    }
+    void AuthHandlers::SendConnected(std::shared_ptr<NetworkClient> networkClient)
+    {
+        entt::registry* registry = ServiceLocator::GetRegistry();
+        PeerSingleton& peerSingleton = registry->ctx<PeerSingleton>();
+
+        std::shared_ptr<Bytebuffer> buffer = BufferPool::BorrowFor(Opcode::CMSG_CONNECTED, 8);
         buffer->Put(Opcode::CMSG_CONNECTED);
         buffer->PutU16(8);
         buffer->Put(AddressType::LOADBALANCE);
         buffer->PutU8(0);
 
-        auto localEndpoint = networkClient->socket()->local_endpoint();
-        buffer->PutU32(localEndpoint.address().to_v4().to_uint());
-        buffer->PutU16(0);
+        // The port we register is where other load balancers send their load reports
+        u16 peerPort = peerSingleton.socket ? peerSingleton.socket->GetPort() : 0;
 
-        networkClient->Send(buffer);
+        buffer->PutU32(peerSingleton.localAddress);
+        buffer->PutU16(peerPort);
+        BufferPool::RecordPacket(Opcode::CMSG_CONNECTED, 8);
 
-        networkClient->SetStatus(ConnectionStatus::AUTH_SUCCESS);
-        return true;
+        ConnectionSingleton& connectionSingleton = registry->ctx<ConnectionSingleton>();
+        if (!connectionSingleton.transport->Send(networkClient, buffer))
+            networkClient->Close(asio::error::broken_pipe);
     }
 }
\ No newline at end of file
@@ -12,5 +12,8 @@ namespace InternalSocket
         static void Setup(MessageHandler*);
         static bool HandshakeHandler(std::shared_ptr<NetworkClient>, std::shared_ptr<NetworkPacket>&);
         static bool HandshakeResponseHandler(std::shared_ptr<NetworkClient>, std::shared_ptr<NetworkPacket>&);
+
+        // Registers us with Novus-Service, a standby load balancer calls this once it takes over
+        static void SendConnected(std::shared_ptr<NetworkClient>);
     };
 }
\ No newline at end of file
@@ -3,18 +3,21 @@
 #include <Networking/NetworkPacket.h>
 #include <Networking/NetworkClient.h>
 #include <Networking/AddressType.h>
-#include <Networking/PacketUtils.h>
 #include "../../Utils/ServiceLocator.h"
 #include "../../ECS/Components/Network/LoadBalanceSingleton.h"
+#include "../../ECS/Components/Network/AddressRequestSingleton.h"
+#include "../../ECS/Components/Network/ConnectionSingleton.h"
+#include "../../ECS/Systems/Network/SharedTableSystems.h"
+#include "../../Utils/RequestTracer.h"
 
 namespace InternalSocket
 {
     void GeneralHandlers::Setup(MessageHandler* messageHandler)
     {
         messageHandler->SetMessageHandler(Opcode::SMSG_CONNECTED, { ConnectionStatus::AUTH_SUCCESS, 0, GeneralHandlers::HandleConnected });
-        messageHandler->SetMessageHandler(Opcode::MSG_REQUEST_ADDRESS, { ConnectionStatus::CONNECTED, sizeof(AddressType), 128, GeneralHandlers::HandleRequestAddress });
+        messageHandler->SetMessageHandler(Opcode::MSG_REQUEST_ADDRESS, { ConnectionStatus::CONNECTED, sizeof(AddressType), ADDRESS_REQUEST_MAX_SIZE, GeneralHandlers::HandleRequestAddress });
         messageHandler->SetMessageHandler(Opcode::SMSG_SEND_FULL_INTERNAL_SERVER_INFO, { ConnectionStatus::CONNECTED, sizeof(ServerInformation), NETWORK_BUFFER_SIZE, GeneralHandlers::HandleFullServerInfoUpdate });
-        messageHandler->SetMessageHandler(Opcode::SMSG_SEND_ADD_INTERNAL_SERVER_INFO, { ConnectionStatus::CONNECTED, sizeof(ServerInformation), GeneralHandlers::HandleServerInfoAdd });
+        messageHandler->SetMessageHandler(Opcode::SMSG_SEND_ADD_INTERNAL_SERVER_INFO, { ConnectionStatus::CONNECTED, sizeof(ServerInformation), sizeof(ServerInformation) + sizeof(u32), GeneralHandlers::HandleServerInfoAdd });
         messageHandler->SetMessageHandler(Opcode::SMSG_SEND_REMOVE_INTERNAL_SERVER_INFO, { ConnectionStatus::CONNECTED, sizeof(entt::entity) + sizeof(AddressType), GeneralHandlers::HandleServerInfoRemove });
     }
 
@@ -25,60 +28,20 @@ namespace InternalSocket
     }
     bool GeneralHandlers::HandleRequestAddress(std::shared_ptr<NetworkClient> networkClient, std::shared_ptr<NetworkPacket>& packet)
     {
-        // Validate that we did get an AddressType and that it is valid
-        AddressType requestType;
-        if (!packet->payload->Get(requestType) ||
-            (requestType < AddressType::AUTH || requestType >= AddressType::COUNT))
-        {
-            return false;
-        }
-
+        // Requests are decoded, routed and answered in batches by the AddressRequest systems later this frame
         entt::registry* registry = ServiceLocator::GetRegistry();
-        auto& loadBalanceSingleton = registry->ctx<LoadBalanceSingleton>();
-
-        ServerInformation serverInformation;
-        if (requestType == AddressType::AUTH)
-        {
-            loadBalanceSingleton.Get<AddressType::AUTH>(serverInformation);
-        }
-        else if (requestType == AddressType::REALM)
-        {
-            loadBalanceSingleton.Get<AddressType::REALM>(serverInformation);
-        }
-        else if (requestType == AddressType::WORLD)
-        {
-            loadBalanceSingleton.Get<AddressType::WORLD>(serverInformation);
-        }
-        else if (requestType == AddressType::INSTANCE)
-        {
-            loadBalanceSingleton.Get<AddressType::INSTANCE>(serverInformation);
-        }
-        else if (requestType == AddressType::CHAT)
-        {
-            loadBalanceSingleton.Get<AddressType::CHAT>(serverInformation);
-        }
-        else if (requestType == AddressType::LOADBALANCE)
-        {
-            loadBalanceSingleton.Get<AddressType::LOADBALANCE>(serverInformation);
-        }
-        else if (requestType == AddressType::REGION)
-        {
-            loadBalanceSingleton.Get<AddressType::REGION>(serverInformation);
-        }
+        AddressRequestSingleton& addressRequestSingleton = registry->ctx<AddressRequestSingleton>();
 
-        std::shared_ptr<Bytebuffer> buffer = Bytebuffer::Borrow<128>();
-        u8 status = 1;
+        PendingAddressRequest& pendingRequest = addressRequestSingleton.requests.emplace_back();
+        pendingRequest.packet = packet;
 
-        // If the load balancer couldn't find a valid server, we send status 0 back
-        if (serverInformation.type == AddressType::INVALID)
+        ConnectionSingleton& connectionSingleton = registry->ctx<ConnectionSingleton>();
+        if (connectionSingleton.currentTrace)
         {
-            status = 0;
+            pendingRequest.trace = connectionSingleton.currentTrace;
+            RequestTracer::Mark(*pendingRequest.trace, TraceStage::HANDLER);
         }
 
-        if (!PacketUtils::Write_SMSG_SEND_ADDRESS(buffer, status, serverInformation.address, serverInformation.port, packet->payload->GetReadPointer(), packet->payload->GetReadSpace()))
-            return false;
-
-        networkClient->Send(buffer);
         return true;
     }
     bool GeneralHandlers::HandleFullServerInfoUpdate(std::shared_ptr<NetworkClient> networkClient, std::shared_ptr<NetworkPacket>& packet)
@@ -86,8 +49,8 @@ namespace InternalSocket
         entt::registry* registry = ServiceLocator::GetRegistry();
         LoadBalanceSingleton& loadBalanceSingleton = registry->ctx<LoadBalanceSingleton>();
 
-        // Clear Cache
-        loadBalanceSingleton.Clear();
+        // Servers missing from the sync are removed at the end, the ones still there keep their routing state
+        loadBalanceSingleton.BeginFullSync();
 
         ServerInformation serverInformation;
         while (packet->payload->GetReadSpace())
@@ -110,36 +73,10 @@ namespace InternalSocket
             if (!packet->payload->GetU16(serverInformation.port))
                 return false;
 
-            if (serverInformation.type == AddressType::AUTH)
-            {
-                loadBalanceSingleton.Add<AddressType::AUTH>(serverInformation);
-            }
-            else if (serverInformation.type == AddressType::REALM)
-            {
-                loadBalanceSingleton.Add<AddressType::REALM>(serverInformation);
-            }
-            else if (serverInformation.type == AddressType::WORLD)
-            {
-                loadBalanceSingleton.Add<AddressType::WORLD>(serverInformation);
-            }
-            else if (serverInformation.type == AddressType::INSTANCE)
-            {
-                loadBalanceSingleton.Add<AddressType::INSTANCE>(serverInformation);
-            }
-            else if (serverInformation.type == AddressType::CHAT)
-            {
-                loadBalanceSingleton.Add<AddressType::CHAT>(serverInformation);
-            }
-            else if (serverInformation.type == AddressType::LOADBALANCE)
-            {
-                loadBalanceSingleton.Add<AddressType::LOADBALANCE>(serverInformation);
-            }
-            else if (serverInformation.type == AddressType::REGION)
-            {
-                loadBalanceSingleton.Add<AddressType::REGION>(serverInformation);
-            }
+            loadBalanceSingleton.Add(serverInformation);
         }
 
+        loadBalanceSingleton.EndFullSync();
         return true;
     }
     bool GeneralHandlers::HandleServerInfoAdd(std::shared_ptr<NetworkClient> networkClient, std::shared_ptr<NetworkPacket>& packet)
@@ -167,35 +104,20 @@ namespace InternalSocket
         if (!packet->payload->GetU16(serverInformation.port))
             return false;
 
-        if (serverInformation.type == AddressType::AUTH)
-        {
-            loadBalanceSingleton.Add<AddressType::AUTH>(serverInformation);
-        }
-        else if (serverInformation.type == AddressType::REALM)
-        {
-            loadBalanceSingleton.Add<AddressType::REALM>(serverInformation);
-        }
-        else if (serverInformation.type == AddressType::WORLD)
-        {
-            loadBalanceSingleton.Add<AddressType::WORLD>(serverInformation);
-        }
-        else if (serverInformation.type == AddressType::INSTANCE)
-        {
-            loadBalanceSingleton.Add<AddressType::INSTANCE>(serverInformation);
-        }
-        else if (serverInformation.type == AddressType::CHAT)
-        {
-            loadBalanceSingleton.Add<AddressType::CHAT>(serverInformation);
-        }
-        else if (serverInformation.type == AddressType::LOADBALANCE)
-        {
-            loadBalanceSingleton.Add<AddressType::LOADBALANCE>(serverInformation);
-        }
-        else if (serverInformation.type == AddressType::REGION)
+        u32 previousVersion = loadBalanceSingleton.GetTableVersion();
+        loadBalanceSingleton.Add(serverInformation);
+
+        // INSTANCE servers may append their free capacity, they resend this packet whenever it changes
+        if (serverInformation.type == AddressType::INSTANCE && packet->payload->GetReadSpace() >= sizeof(u32))
         {
-            loadBalanceSingleton.Add<AddressType::REGION>(serverInformation);
+            u32 capacity = 0;
+            if (!packet->payload->GetU32(capacity))
+                return false;
+
+            loadBalanceSingleton.SetCapacity(serverInformation.realmId, serverInformation.entity, capacity);
         }
 
+        SharedTableUpdateSystem::HandleServerAdd(*registry, serverInformation, previousVersion);
         return true;
     }
     bool GeneralHandlers::HandleServerInfoRemove(std::shared_ptr<NetworkClient> networkClient, std::shared_ptr<NetworkPacket>& packet)
@@ -219,7 +141,9 @@ namespace InternalSocket
         if (!packet->payload->GetU8(realmId))
             return false;
 
+        u32 previousVersion = loadBalanceSingleton.GetTableVersion();
         loadBalanceSingleton.Remove(type, entity, realmId);
+        SharedTableUpdateSystem::HandleServerRemove(*registry, type, realmId, entity, previousVersion);
 
         return true;
     }
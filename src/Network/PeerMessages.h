@@ -0,0 +1,49 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+
+// Every datagram exchanged between load balancers starts with PEER_MESSAGE_MAGIC followed by a PeerMessageType
+constexpr u16 PEER_MESSAGE_MAGIC = 0x4C4E; // "NL"
+
+enum class PeerMessageType : u8
+{
+    INVALID,
+    LOAD_REPORT, // u8 count, then count times (u32 entity, AddressType type, u8 realmId, u16 load)
+    SNAPSHOT,    // u32 epoch, u32 snapshotId, u8 chunkIndex, u8 chunkCount, u32 tableVersion, u8 count, then count replicated servers, doubles as the heartbeat
+    PING,        // u64 sendTime, in the sender's clock
+    PONG         // u64 sendTime, echoed from the PING
+};
+
+constexpr size_t PEER_MESSAGE_HEADER_SIZE = sizeof(u16) + sizeof(PeerMessageType);
+constexpr size_t PEER_PING_SIZE = sizeof(u64);
+constexpr size_t PEER_LOAD_REPORT_ENTRY_SIZE = sizeof(u32) + sizeof(u8) + sizeof(u8) + sizeof(u16);
+constexpr size_t PEER_MIN_GOSSIP_BUDGET = PEER_MESSAGE_HEADER_SIZE + sizeof(u8) + PEER_LOAD_REPORT_ENTRY_SIZE; // Room for the count and one server
+
+constexpr size_t PEER_SNAPSHOT_HEADER_SIZE = sizeof(u32) + sizeof(u32) + sizeof(u8) + sizeof(u8) + sizeof(u32) + sizeof(u8);
+// u32 entity, AddressType type, u8 realmId, u32 address, u16 port, ServerState state, f32 weight, f32 age, u16 leases, f32 firstLeaseRemaining, f32 lastLeaseRemaining, u8 hasCapacity, u32 capacity, u32 reservedCapacity
+constexpr size_t PEER_SNAPSHOT_ENTRY_SIZE = sizeof(u32) + sizeof(u8) + sizeof(u8) + sizeof(u32) + sizeof(u16) + sizeof(u8) + sizeof(f32) + sizeof(f32) + sizeof(u16) + sizeof(f32) + sizeof(f32) + sizeof(u8) + sizeof(u32) + sizeof(u32);
+
+// Loads are sent as 12.4 fixed point
+constexpr f32 PEER_LOAD_SCALE = 16.0f;
\ No newline at end of file
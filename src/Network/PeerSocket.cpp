@@ -0,0 +1,92 @@
+#include "PeerSocket.h"
+#include "../Utils/Logger.h"
+#include "../Utils/BufferPool.h"
+#include "../Utils/ServiceLocator.h"
+#include "../Utils/WakeEvent.h"
+
+PeerSocket::PeerSocket(std::shared_ptr<asio::io_service> asioService)
+    : _asioService(asioService), _socket(*asioService.get()), _receiveQueue(64)
+{
+}
+
+bool PeerSocket::Open(u16 port)
+{
+    asio::error_code error;
+    _socket.open(asio::ip::udp::v4(), error);
+    if (error)
+        return false;
+
+    _socket.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), port), error);
+    if (error)
+    {
+        Logger::PrintWarning("[Network/Peer]: Failed to bind UDP port %u (%s)", port, error.message().c_str());
+        _socket.close(error);
+        return false;
+    }
+
+    _isOpen = true;
+    _port = _socket.local_endpoint().port();
+
+    std::shared_ptr<PeerSocket> self = shared_from_this();
+    asio::post(*_asioService.get(), [self]() { self->Receive(); });
+    return true;
+}
+
+void PeerSocket::Close()
+{
+    if (!_isOpen)
+        return;
+
+    _isOpen = false;
+
+    std::shared_ptr<PeerSocket> self = shared_from_this();
+    asio::post(*_asioService.get(), [self]()
+    {
+        asio::error_code error;
+        self->_socket.close(error);
+    });
+}
+
+void PeerSocket::Send(u32 address, u16 port, std::shared_ptr<Bytebuffer> buffer)
+{
+    if (!_isOpen)
+        return;
+
+    std::shared_ptr<PeerSocket> self = shared_from_this();
+    asio::post(*_asioService.get(), [self, address, port, buffer]()
+    {
+        asio::ip::udp::endpoint endpoint(asio::ip::address_v4(address), port);
+        self->_socket.async_send_to(asio::buffer(buffer->GetDataPointer(), buffer->writtenData), endpoint, [self, buffer](const asio::error_code& error, size_t bytesSent)
+        {
+            if (!error)
+                self->_bytesSent += bytesSent;
+        });
+    });
+}
+
+void PeerSocket::Receive()
+{
+    std::shared_ptr<PeerSocket> self = shared_from_this();
+    _socket.async_receive_from(asio::buffer(_receiveData, sizeof(_receiveData)), _remoteEndpoint, [self](const asio::error_code& error, size_t bytesReceived)
+    {
+        if (error == asio::error::operation_aborted || !self->_isOpen)
+            return;
+
+        if (!error && bytesReceived && self->_remoteEndpoint.address().is_v4())
+        {
+            PeerDatagram datagram;
+            datagram.address = self->_remoteEndpoint.address().to_v4().to_uint();
+            datagram.port = self->_remoteEndpoint.port();
+            datagram.buffer = BufferPool::Borrow(PEER_DATAGRAM_SIZE);
+
+            std::memcpy(datagram.buffer->GetDataPointer(), self->_receiveData, bytesReceived);
+            datagram.buffer->writtenData = bytesReceived;
+
+            self->_bytesReceived += bytesReceived;
+            self->_receiveQueue.enqueue(datagram);
+            ServiceLocator::GetEngineWakeEvent()->Wake();
+        }
+
+        self->Receive();
+    });
+}
\ No newline at end of file
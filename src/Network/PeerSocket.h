@@ -0,0 +1,75 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <asio.hpp>
+#include <atomic>
+#include <Utils/ByteBuffer.h>
+#include <Utils/ConcurrentQueue.h>
+
+// Keeps datagrams below the common path MTU so they are never fragmented
+constexpr size_t PEER_DATAGRAM_SIZE = 1200;
+
+struct PeerDatagram
+{
+    u32 address = 0;
+    u16 port = 0;
+    std::shared_ptr<Bytebuffer> buffer;
+};
+
+// UDP endpoint used to talk to other load balancers, datagrams are received on the asio thread and handed to the engine thread through a queue
+class PeerSocket : public std::enable_shared_from_this<PeerSocket>
+{
+public:
+    PeerSocket(std::shared_ptr<asio::io_service> asioService);
+
+    bool Open(u16 port);
+    void Close();
+    bool IsOpen() const { return _isOpen; }
+    u16 GetPort() const { return _port; }
+
+    // Safe to call from any thread, the send itself happens on the asio thread
+    void Send(u32 address, u16 port, std::shared_ptr<Bytebuffer> buffer);
+    bool TryGetDatagram(PeerDatagram& datagram) { return _receiveQueue.try_dequeue(datagram); }
+
+    u64 GetBytesSent() const { return _bytesSent; }
+    u64 GetBytesReceived() const { return _bytesReceived; }
+
+private:
+    void Receive();
+
+private:
+    std::shared_ptr<asio::io_service> _asioService;
+    asio::ip::udp::socket _socket;
+    asio::ip::udp::endpoint _remoteEndpoint;
+
+    std::atomic<bool> _isOpen = false;
+    u16 _port = 0;
+
+    u8 _receiveData[PEER_DATAGRAM_SIZE];
+    moodycamel::ConcurrentQueue<PeerDatagram> _receiveQueue;
+
+    std::atomic<u64> _bytesSent = 0;
+    std::atomic<u64> _bytesReceived = 0;
+};
\ No newline at end of file
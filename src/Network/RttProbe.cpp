@@ -0,0 +1,77 @@
+#include "RttProbe.h"
+#include <chrono>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+struct RttProbeState
+{
+    RttProbeState(asio::io_service& asioService) : socket(asioService), timer(asioService) { }
+
+    asio::ip::tcp::socket socket;
+    asio::steady_timer timer;
+    std::chrono::steady_clock::time_point startTime;
+    RttProbeCallback callback;
+    bool isDone = false;
+};
+
+void RttProbe::Connect(std::shared_ptr<asio::io_service> asioService, u32 address, u16 port, u32 timeoutMS, RttProbeCallback callback)
+{
+    std::shared_ptr<RttProbeState> state = std::make_shared<RttProbeState>(*asioService.get());
+    state->callback = std::move(callback);
+
+    // Both handlers run on the asio thread, whichever comes first reports and cancels the other
+    asio::post(*asioService.get(), [state, address, port, timeoutMS]()
+    {
+        state->timer.expires_after(std::chrono::milliseconds(timeoutMS));
+        state->timer.async_wait([state](const asio::error_code& error)
+        {
+            if (error || state->isDone)
+                return;
+
+            state->isDone = true;
+
+            asio::error_code closeError;
+            state->socket.close(closeError);
+            state->callback(false, 0.0f);
+        });
+
+        state->startTime = std::chrono::steady_clock::now();
+        state->socket.async_connect(asio::ip::tcp::endpoint(asio::ip::address_v4(address), port), [state](const asio::error_code& error)
+        {
+            if (state->isDone)
+                return;
+
+            state->isDone = true;
+            f32 rttMS = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - state->startTime).count();
+
+            asio::error_code closeError;
+            state->timer.cancel();
+            state->socket.close(closeError);
+            state->callback(!error, rttMS);
+        });
+    });
+}
+
+bool RttProbe::GetConnectionRtt(asio::ip::tcp::socket& socket, f32& rttMS)
+{
+#ifdef __linux__
+    tcp_info info = { };
+    socklen_t size = sizeof(info);
+
+    if (getsockopt(socket.native_handle(), IPPROTO_TCP, TCP_INFO, &info, &size) != 0)
+        return false;
+
+    // Zero until the kernel has its first sample
+    if (info.tcpi_rtt == 0)
+        return false;
+
+    rttMS = info.tcpi_rtt / 1000.0f;
+    return true;
+#else
+    return false;
+#endif
+}
\ No newline at end of file
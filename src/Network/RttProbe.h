@@ -0,0 +1,44 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <asio.hpp>
+#include <functional>
+
+// Called on the asio thread, rttMS is only meaningful when the probe succeeded
+using RttProbeCallback = std::function<void(bool success, f32 rttMS)>;
+
+/*
+    Round trip measurements that don't need anything from the other side.
+    Connect times a TCP handshake, which is answered by the backend's kernel, so it measures the network and not how busy the backend is.
+*/
+class RttProbe
+{
+public:
+    // Opens a connection to the address and closes it again as soon as it is established, gives up after timeoutMS
+    static void Connect(std::shared_ptr<asio::io_service> asioService, u32 address, u16 port, u32 timeoutMS, RttProbeCallback callback);
+
+    // The kernel's smoothed RTT of an established connection, only available on Linux
+    static bool GetConnectionRtt(asio::ip::tcp::socket& socket, f32& rttMS);
+};
\ No newline at end of file
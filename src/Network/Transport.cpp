@@ -0,0 +1,113 @@
+#include "Transport.h"
+#include "../Utils/ServiceLocator.h"
+#include "../Utils/WakeEvent.h"
+
+bool AsioTransport::Connect(std::shared_ptr<NetworkClient>& networkClient, const std::string& address, u16 port)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connection++;
+        _isBroken = false;
+
+        // A write still in flight completes on its own and pops itself, everything queued behind it was meant for the old connection
+        size_t numInFlight = _isWriting ? 1 : 0;
+        while (_queue.size() > numInFlight)
+        {
+            _queuedBuffers--;
+            _queuedBytes -= _queue.back().buffer->writtenData;
+            _queue.pop_back();
+        }
+    }
+
+    return networkClient->Connect(address, port);
+}
+
+bool AsioTransport::Send(std::shared_ptr<NetworkClient>& networkClient, std::vector<std::shared_ptr<Bytebuffer>>& buffers)
+{
+    if (_isBroken)
+        return false;
+
+    bool startWriting = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::shared_ptr<Bytebuffer>& buffer : buffers)
+        {
+            if (!buffer->writtenData)
+                continue;
+
+            _queue.push_back({ networkClient, buffer, _connection });
+            _queuedBuffers++;
+            _queuedBytes += buffer->writtenData;
+        }
+
+        startWriting = !_isWriting && !_queue.empty();
+        _isWriting |= startWriting;
+    }
+
+    // The socket is only touched from the asio thread, like the NetworkClient's own reads and writes
+    if (startWriting)
+    {
+        asio::post(networkClient->socket()->get_executor(), [this]()
+        {
+            WriteNext();
+        });
+    }
+
+    return true;
+}
+
+SendQueueState AsioTransport::GetSendQueue(std::shared_ptr<NetworkClient>& /*networkClient*/)
+{
+    SendQueueState state;
+    state.buffers = _queuedBuffers;
+    state.bytes = _queuedBytes;
+
+    return state;
+}
+
+void AsioTransport::WriteNext()
+{
+    QueuedWrite write;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        write = _queue.front();
+    }
+
+    std::shared_ptr<Bytebuffer>& buffer = write.buffer;
+    asio::async_write(*write.networkClient->socket(), asio::buffer(buffer->GetDataPointer(), buffer->writtenData), [this, write](const asio::error_code& error, size_t /*bytesWritten*/)
+    {
+        bool writeNext = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.pop_front();
+            _queuedBuffers--;
+            _queuedBytes -= write.buffer->writtenData;
+
+            // Whatever is still queued would be written to a dead connection
+            if (error && write.connection == _connection)
+            {
+                _isBroken = true;
+                for (QueuedWrite& queuedWrite : _queue)
+                {
+                    _queuedBytes -= queuedWrite.buffer->writtenData;
+                }
+
+                _queuedBuffers = 0;
+                _queue.clear();
+            }
+
+            writeNext = !_queue.empty();
+            _isWriting = writeNext;
+        }
+
+        if (writeNext)
+        {
+            WriteNext();
+        }
+        else if (WakeEvent* wakeEvent = ServiceLocator::GetEngineWakeEvent())
+        {
+            // The engine may be idling on a congested connection with deferred requests
+            wakeEvent->Wake();
+        }
+    });
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <Utils/ByteBuffer.h>
+#include <Networking/NetworkClient.h>
+#include <Networking/NetworkPacket.h>
+
+// What has been handed to a transport but not written to the socket yet
+struct SendQueueState
+{
+    size_t buffers = 0;
+    size_t bytes = 0;
+};
+
+// How the batched address responses reach Novus-Service, picked once at startup by the network.transport setting
+class Transport
+{
+public:
+    virtual ~Transport() { }
+
+    virtual const char* GetName() const = 0;
+
+    // Connects to Novus-Service, transports drop whatever they still hold for the previous connection first
+    virtual bool Connect(std::shared_ptr<NetworkClient>& networkClient, const std::string& address, u16 port) { return networkClient->Connect(address, port); }
+
+    // Sends the buffers in order, false means the connection is broken and should be closed
+    virtual bool Send(std::shared_ptr<NetworkClient>& networkClient, std::vector<std::shared_ptr<Bytebuffer>>& buffers) = 0;
+
+    // Every packet to Novus-Service goes through here, writing to the socket behind the transport's back would interleave with its queue
+    bool Send(std::shared_ptr<NetworkClient>& networkClient, std::shared_ptr<Bytebuffer> buffer)
+    {
+        std::vector<std::shared_ptr<Bytebuffer>> buffers = { std::move(buffer) };
+        return Send(networkClient, buffers);
+    }
+
+    // Called by ConnectionUpdateSystem every frame to write what an earlier Send had to leave queued, false means the connection is broken
+    virtual bool Flush(std::shared_ptr<NetworkClient>& /*networkClient*/) { return true; }
+
+    // True while only a later Flush moves the queue along, the engine then doesn't idle past the next millisecond
+    virtual bool IsFlushPending() { return false; }
+
+    // Read by ConnectionUpdateSystem every frame to decide if Novus-Service keeps up with our responses
+    virtual SendQueueState GetSendQueue(std::shared_ptr<NetworkClient>& networkClient) = 0;
+};
+
+/*
+    Writes the buffers from the asio thread one at a time, so we know how much is still waiting.
+    NetworkClient::Send gives no completion, which left a slow reader invisible until it ran us out of buffers.
+*/
+class AsioTransport : public Transport
+{
+public:
+    const char* GetName() const override { return "asio"; }
+
+    bool Connect(std::shared_ptr<NetworkClient>& networkClient, const std::string& address, u16 port) override;
+    using Transport::Send;
+    bool Send(std::shared_ptr<NetworkClient>& networkClient, std::vector<std::shared_ptr<Bytebuffer>>& buffers) override;
+    SendQueueState GetSendQueue(std::shared_ptr<NetworkClient>& networkClient) override;
+
+private:
+    struct QueuedWrite
+    {
+        std::shared_ptr<NetworkClient> networkClient;
+        std::shared_ptr<Bytebuffer> buffer;
+        u32 connection = 0;
+    };
+
+    void WriteNext();
+
+    std::mutex _mutex;
+    std::deque<QueuedWrite> _queue;
+    bool _isWriting = false;
+    u32 _connection = 0; // Bumped by Connect, a failed write only breaks the connection it was queued on
+
+    std::atomic<size_t> _queuedBuffers = 0;
+    std::atomic<size_t> _queuedBytes = 0;
+    std::atomic<bool> _isBroken = false; // A write failed on the asio thread, every Send fails until the next Connect
+};
\ No newline at end of file
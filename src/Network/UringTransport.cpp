@@ -0,0 +1,418 @@
+#include "UringTransport.h"
+#ifdef NC_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+static i32 SetupRing(u32 entries, io_uring_params& params)
+{
+    return static_cast<i32>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+static i32 EnterRing(i32 ringFd, u32 numSubmit, u32 minComplete, u32 flags)
+{
+    return static_cast<i32>(syscall(__NR_io_uring_enter, ringFd, numSubmit, minComplete, flags, nullptr, 0));
+}
+
+static i32 RegisterRing(i32 ringFd, u32 opcode, void* arguments, u32 numArguments)
+{
+    return static_cast<i32>(syscall(__NR_io_uring_register, ringFd, opcode, arguments, numArguments));
+}
+
+UringTransport::~UringTransport()
+{
+    // Registered buffers stay pinned by the ring until it is torn down, sends still in flight don't care that they are unmapped
+    if (_buffers)
+        munmap(_buffers, URING_NUM_BUFFERS * URING_BUFFER_SIZE);
+    if (_sqes)
+        munmap(_sqes, _sqesSize);
+    if (_cqRing && _cqRing != _sqRing)
+        munmap(_cqRing, _cqRingSize);
+    if (_sqRing)
+        munmap(_sqRing, _sqRingSize);
+    if (_ringFd >= 0)
+        close(_ringFd);
+}
+
+bool UringTransport::Init()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    // Every segment can have its send and its notification waiting, plus the cancels of a broken connection
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_MAX_SEGMENTS * 4;
+
+    _ringFd = SetupRing(URING_QUEUE_DEPTH, params);
+    if (_ringFd < 0)
+        return false;
+
+    if (!(params.features & IORING_FEAT_FAST_POLL) || !(params.features & IORING_FEAT_NODROP))
+        return false;
+
+    // The headers may be newer than the kernel, zero copy sends are only used if it has them
+    std::vector<u8> probeData(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeData.data());
+    if (RegisterRing(_ringFd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0 || probe->last_op < IORING_OP_SEND_ZC ||
+        !(probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED) || !(probe->ops[IORING_OP_ASYNC_CANCEL].flags & IO_URING_OP_SUPPORTED))
+    {
+        return false;
+    }
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (isSingleMmap)
+        _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+
+    _sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED)
+    {
+        _sqRing = nullptr;
+        return false;
+    }
+
+    _cqRing = isSingleMmap ? _sqRing : mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+    if (_cqRing == MAP_FAILED)
+    {
+        _cqRing = nullptr;
+        return false;
+    }
+
+    _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+
+    _sqes = static_cast<io_uring_sqe*>(sqes);
+
+    u8* sqRing = static_cast<u8*>(_sqRing);
+    _sqHead = reinterpret_cast<u32*>(sqRing + params.sq_off.head);
+    _sqTail = reinterpret_cast<u32*>(sqRing + params.sq_off.tail);
+    _sqMask = reinterpret_cast<u32*>(sqRing + params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<u32*>(sqRing + params.sq_off.array);
+
+    u8* cqRing = static_cast<u8*>(_cqRing);
+    _cqHead = reinterpret_cast<u32*>(cqRing + params.cq_off.head);
+    _cqTail = reinterpret_cast<u32*>(cqRing + params.cq_off.tail);
+    _cqMask = reinterpret_cast<u32*>(cqRing + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+    void* buffers = mmap(nullptr, URING_NUM_BUFFERS * URING_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (buffers == MAP_FAILED)
+        return false;
+
+    _buffers = static_cast<u8*>(buffers);
+
+    // Registered once, so the sends neither pin the pages nor look them up every time
+    iovec iovecs[URING_NUM_BUFFERS];
+    for (u32 i = 0; i < URING_NUM_BUFFERS; i++)
+    {
+        iovecs[i].iov_base = _buffers + i * URING_BUFFER_SIZE;
+        iovecs[i].iov_len = URING_BUFFER_SIZE;
+    }
+
+    return RegisterRing(_ringFd, IORING_REGISTER_BUFFERS, iovecs, URING_NUM_BUFFERS) == 0;
+}
+
+bool UringTransport::Connect(std::shared_ptr<NetworkClient>& networkClient, const std::string& address, u16 port)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Reap();
+        Break();
+
+        _connection++;
+        _isBroken = false;
+    }
+
+    return networkClient->Connect(address, port);
+}
+
+bool UringTransport::Send(std::shared_ptr<NetworkClient>& networkClient, std::vector<std::shared_ptr<Bytebuffer>>& buffers)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!Reap())
+        Break();
+
+    if (_isBroken)
+        return false;
+
+    for (std::shared_ptr<Bytebuffer>& buffer : buffers)
+    {
+        if (!buffer->writtenData)
+            continue;
+
+        _backlog.push_back(buffer);
+        _backlogBytes += buffer->writtenData;
+    }
+
+    if (!Submit(static_cast<i32>(networkClient->socket()->native_handle())))
+    {
+        Break();
+        return false;
+    }
+
+    return true;
+}
+
+bool UringTransport::Flush(std::shared_ptr<NetworkClient>& networkClient)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!Reap())
+        Break();
+
+    if (_isBroken)
+        return false;
+
+    if (!Submit(static_cast<i32>(networkClient->socket()->native_handle())))
+    {
+        Break();
+        return false;
+    }
+
+    return true;
+}
+
+bool UringTransport::IsFlushPending()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_segments.empty() || !_backlog.empty();
+}
+
+SendQueueState UringTransport::GetSendQueue(std::shared_ptr<NetworkClient>& networkClient)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    SendQueueState state;
+    state.buffers = _backlog.size();
+    state.bytes = _backlogBytes;
+
+    // Once sent, the bytes are in the socket's queue until the kernel lets go of the buffer
+    for (const Segment& segment : _segments)
+    {
+        if (segment.isSent)
+            continue;
+
+        state.buffers++;
+        state.bytes += segment.size;
+    }
+
+    i32 queuedBytes = 0;
+    if (ioctl(static_cast<i32>(networkClient->socket()->native_handle()), TIOCOUTQ, &queuedBytes) == 0)
+        state.bytes += static_cast<size_t>(queuedBytes);
+
+    return state;
+}
+
+void UringTransport::Stage()
+{
+    while (!_backlog.empty())
+    {
+        // A submitted segment belongs to the kernel, what comes after it starts a new one right behind it
+        if (_segments.empty() || _segments.back().isSubmitted || _segments.back().offset + _segments.back().size == URING_BUFFER_SIZE)
+        {
+            if (_segments.size() == URING_MAX_SEGMENTS)
+                return;
+
+            Segment segment;
+            segment.connection = _connection;
+
+            if (!_segments.empty())
+            {
+                const Segment& back = _segments.back();
+                segment.bufferIndex = back.bufferIndex;
+                segment.offset = back.offset + back.size;
+
+                if (segment.offset == URING_BUFFER_SIZE)
+                {
+                    // The buffers are used as a ring, the next one may still hold the front segment
+                    u32 numBuffersUsed = (back.bufferIndex + URING_NUM_BUFFERS - _segments.front().bufferIndex) % URING_NUM_BUFFERS + 1;
+                    if (numBuffersUsed == URING_NUM_BUFFERS)
+                        return;
+
+                    segment.bufferIndex = (back.bufferIndex + 1) % URING_NUM_BUFFERS;
+                    segment.offset = 0;
+                }
+            }
+
+            // Ids stay consecutive, Reap finds a segment by its distance from the front
+            segment.id = _nextSegmentId++;
+            _segments.push_back(segment);
+        }
+
+        Segment& segment = _segments.back();
+        std::shared_ptr<Bytebuffer>& buffer = _backlog.front();
+
+        size_t usedBufferSize = segment.offset + segment.size;
+        size_t numBytes = std::min(buffer->writtenData - _backlogOffset, URING_BUFFER_SIZE - usedBufferSize);
+
+        std::memcpy(_buffers + segment.bufferIndex * URING_BUFFER_SIZE + usedBufferSize, buffer->GetDataPointer() + _backlogOffset, numBytes);
+        segment.size += numBytes;
+        _backlogOffset += numBytes;
+        _backlogBytes -= numBytes;
+
+        if (_backlogOffset == buffer->writtenData)
+        {
+            _backlog.pop_front();
+            _backlogOffset = 0;
+        }
+    }
+}
+
+bool UringTransport::Submit(i32 fd)
+{
+    // A second chain could overtake the first one while it waits for the socket to have room
+    if (_numInFlight)
+        return true;
+
+    Stage();
+
+    u32 numSegments = 0;
+    for (auto itr = _segments.rbegin(); itr != _segments.rend() && !itr->isSubmitted; itr++)
+    {
+        numSegments++;
+    }
+
+    if (!numSegments)
+        return true;
+
+    for (size_t i = _segments.size() - numSegments; i < _segments.size(); i++)
+    {
+        Segment& segment = _segments[i];
+
+        io_uring_sqe* sqe = GetSqe();
+        sqe->opcode = IORING_OP_SEND_ZC;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<u64>(_buffers + segment.bufferIndex * URING_BUFFER_SIZE + segment.offset);
+        sqe->len = static_cast<u32>(segment.size);
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = static_cast<u16>(segment.bufferIndex);
+        sqe->user_data = segment.id;
+
+        // A plain send raises SIGPIPE once Novus-Service is gone, asio avoids it the same way. MSG_WAITALL makes the kernel finish a short send before the next one in the chain starts
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+
+        // A failed send cancels the rest of the chain, nothing after a gap in the stream may go out
+        if (i + 1 < _segments.size())
+            sqe->flags = IOSQE_IO_LINK;
+
+        segment.isSubmitted = true;
+        segment.isBufferBusy = true;
+    }
+
+    _numInFlight = numSegments;
+    return SubmitPending();
+}
+
+bool UringTransport::Reap()
+{
+    bool isConnected = true;
+
+    u32 head = *_cqHead;
+    u32 tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++)
+    {
+        const io_uring_cqe& cqe = _cqes[head & *_cqMask];
+        if (cqe.user_data == URING_CANCEL_USER_DATA || _segments.empty() || cqe.user_data < _segments.front().id)
+            continue;
+
+        u64 index = cqe.user_data - _segments.front().id;
+        if (index >= _segments.size())
+            continue;
+
+        Segment& segment = _segments[index];
+        if (cqe.flags & IORING_CQE_F_NOTIF)
+        {
+            segment.isBufferBusy = false;
+            continue;
+        }
+
+        // Without IORING_CQE_F_MORE no notification follows, the send never got as far as the buffer or is done with it
+        segment.isSent = true;
+        segment.isBufferBusy = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        _numInFlight--;
+
+        if (cqe.res != static_cast<i32>(segment.size) && segment.connection == _connection)
+            isConnected = false;
+    }
+
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+    while (!_segments.empty() && _segments.front().isSent && !_segments.front().isBufferBusy)
+    {
+        _segments.pop_front();
+    }
+
+    return isConnected;
+}
+
+void UringTransport::Break()
+{
+    _isBroken = true;
+    _backlog.clear();
+    _backlogOffset = 0;
+    _backlogBytes = 0;
+
+    // Submitted segments stay until the kernel is done with their buffers
+    while (!_segments.empty() && !_segments.back().isSubmitted)
+    {
+        _segments.pop_back();
+    }
+
+    // A chain waiting for a socket that went away would hold on to its buffers forever
+    if (_numInFlight)
+    {
+        io_uring_sqe* sqe = GetSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = URING_CANCEL_USER_DATA;
+
+        SubmitPending();
+    }
+}
+
+io_uring_sqe* UringTransport::GetSqe()
+{
+    // Only one chain is in flight and a chain never has more sqes than the queue is deep, so it never runs full
+    u32 index = (*_sqTail + _numPending++) & *_sqMask;
+    _sqArray[index] = index;
+
+    io_uring_sqe* sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    return sqe;
+}
+
+bool UringTransport::SubmitPending()
+{
+    u32 numSubmit = _numPending;
+    _numPending = 0;
+
+    __atomic_store_n(_sqTail, *_sqTail + numSubmit, __ATOMIC_RELEASE);
+
+    // One syscall for the whole chain, the completions are picked up by a later Reap
+    while (numSubmit)
+    {
+        i32 numSubmitted = EnterRing(_ringFd, numSubmit, 0, 0);
+        if (numSubmitted < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        numSubmit -= static_cast<u32>(numSubmitted);
+    }
+
+    return true;
+}
+#endif // NC_IO_URING
\ No newline at end of file
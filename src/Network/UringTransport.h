@@ -0,0 +1,125 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include "Transport.h"
+#include <deque>
+#include <mutex>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+
+// Zero copy sends from registered buffers came with Linux 6.0, older headers are left to asio
+#ifdef IORING_CQE_F_NOTIF
+#define NC_IO_URING
+#endif
+#endif
+
+#ifdef NC_IO_URING
+constexpr u32 URING_NUM_BUFFERS = 32; // Registered with the ring, responses are coalesced into these
+constexpr size_t URING_BUFFER_SIZE = NETWORK_BUFFER_SIZE;
+constexpr u32 URING_MAX_SEGMENTS = 64; // Staged or waiting for the kernel, a segment is a range of one buffer sent by one sqe
+constexpr u32 URING_QUEUE_DEPTH = URING_MAX_SEGMENTS; // Room for a chain over every segment
+constexpr u64 URING_CANCEL_USER_DATA = ~0ull;
+
+/*
+    Sends a frame's responses as one chain of zero copy sends from buffers registered with the ring, submitted without waiting for any of it.
+    The chain is linked and every send uses MSG_WAITALL, so the kernel keeps the stream in order and finishes short sends itself once the socket has room.
+    Completions are reaped by the next Send or Flush, a buffer is only reused after the kernel's notification that it is done with it.
+    Only one chain is in flight, responses sent meanwhile are staged and go out as the next chain. A slow reader shows up in GetSendQueue and ConnectionUpdateSystem defers requests.
+    Reads stay with the NetworkClient, it owns the receive buffer and the packet framing.
+*/
+class UringTransport : public Transport
+{
+public:
+    ~UringTransport();
+
+    // False when the kernel doesn't support io_uring zero copy sends (or it is disabled), the caller falls back to AsioTransport
+    bool Init();
+
+    const char* GetName() const override { return "io_uring"; }
+    bool Connect(std::shared_ptr<NetworkClient>& networkClient, const std::string& address, u16 port) override;
+    using Transport::Send;
+    bool Send(std::shared_ptr<NetworkClient>& networkClient, std::vector<std::shared_ptr<Bytebuffer>>& buffers) override;
+    bool Flush(std::shared_ptr<NetworkClient>& networkClient) override;
+    bool IsFlushPending() override;
+
+    // What we couldn't write yet plus the socket's own send queue
+    SendQueueState GetSendQueue(std::shared_ptr<NetworkClient>& networkClient) override;
+
+private:
+    struct Segment
+    {
+        u64 id = 0; // user_data of its send, consecutive so the segment is found by its distance from the front
+        u32 bufferIndex = 0;
+        size_t offset = 0;
+        size_t size = 0;
+        u32 connection = 0;
+        bool isSubmitted = false;
+        bool isSent = false; // Its send completed, successfully or not
+        bool isBufferBusy = false; // Zero copy sends hold on to the buffer until their notification
+    };
+
+    void Stage();
+    bool Submit(i32 fd);
+    bool Reap();
+    void Break();
+    io_uring_sqe* GetSqe();
+    bool SubmitPending();
+
+private:
+    i32 _ringFd = -1;
+
+    void* _sqRing = nullptr;
+    size_t _sqRingSize = 0;
+    void* _cqRing = nullptr;
+    size_t _cqRingSize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    u32* _sqHead = nullptr;
+    u32* _sqTail = nullptr;
+    u32* _sqMask = nullptr;
+    u32* _sqArray = nullptr;
+    u32* _cqHead = nullptr;
+    u32* _cqTail = nullptr;
+    u32* _cqMask = nullptr;
+    io_uring_cqe* _cqes = nullptr;
+    u32 _numPending = 0;
+
+    u8* _buffers = nullptr;
+
+    // The handshake is sent from the asio thread, the responses from the engine thread
+    std::mutex _mutex;
+
+    std::deque<Segment> _segments; // In stream order, a segment starts where the previous one ends or at the next buffer
+    u64 _nextSegmentId = 0;
+    u32 _numInFlight = 0; // Sends of the current chain that haven't completed
+    std::deque<std::shared_ptr<Bytebuffer>> _backlog; // Waiting for room in the buffers
+    size_t _backlogOffset = 0; // How much of the front buffer is already staged
+    size_t _backlogBytes = 0;
+    u32 _connection = 0; // Bumped by Connect, sends of an earlier connection failing don't break the current one
+    bool _isBroken = false; // A send failed, every Send fails until the next Connect
+};
+#endif // NC_IO_URING
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/AddressType.h>
+#include <utility>
+#include <type_traits>
+
+namespace AddressTypeUtils
+{
+    inline const char* GetName(AddressType type)
+    {
+        switch (type)
+        {
+            case AddressType::AUTH: return "auth";
+            case AddressType::REALM: return "realm";
+            case AddressType::WORLD: return "world";
+            case AddressType::INSTANCE: return "instance";
+            case AddressType::CHAT: return "chat";
+            case AddressType::LOADBALANCE: return "loadbalance";
+            case AddressType::REGION: return "region";
+            default: return "invalid";
+        }
+    }
+
+    // Expects a lowercase name, console commands are lowercased before they are handled
+    inline bool FromName(const std::string& name, AddressType& type)
+    {
+        for (u8 i = static_cast<u8>(AddressType::AUTH); i < static_cast<u8>(AddressType::COUNT); i++)
+        {
+            if (name == GetName(static_cast<AddressType>(i)))
+            {
+                type = static_cast<AddressType>(i);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template <AddressType type, typename Func>
+    inline decltype(auto) InvokeWithType(Func& func)
+    {
+        return func(std::integral_constant<AddressType, type>());
+    }
+
+    template <typename Func, size_t... Indices>
+    inline decltype(auto) DispatchTable(AddressType type, Func& func, std::index_sequence<Indices...>)
+    {
+        using Result = decltype(func(std::integral_constant<AddressType, AddressType::AUTH>()));
+        using Function = Result(*)(Func&);
+
+        static constexpr Function table[] = { &InvokeWithType<static_cast<AddressType>(static_cast<u8>(AddressType::AUTH) + Indices), Func>... };
+        return table[static_cast<u8>(type) - static_cast<u8>(AddressType::AUTH)](func);
+    }
+
+    /*
+        Calls func(std::integral_constant<AddressType, type>) for a type only known at runtime, so it can reach the type's template specialization.
+        The table of specializations is generated at compile time from the enum, so dispatching is one indexed call whatever the number of types.
+        type has to be AUTH up to COUNT, everything that reads a type off the wire checks that before it gets here.
+    */
+    template <typename Func>
+    inline decltype(auto) Dispatch(AddressType type, Func&& func)
+    {
+        constexpr size_t numTypes = static_cast<size_t>(AddressType::COUNT) - static_cast<size_t>(AddressType::AUTH);
+        return DispatchTable(type, func, std::make_index_sequence<numTypes>());
+    }
+
+    // Addresses are stored as host order IPv4
+    inline std::string AddressToString(u32 address)
+    {
+        return std::to_string((address >> 24) & 0xFF) + "." + std::to_string((address >> 16) & 0xFF) + "." + std::to_string((address >> 8) & 0xFF) + "." + std::to_string(address & 0xFF);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include "BufferPool.h"
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <Utils/ConcurrentQueue.h>
+
+static_assert(BUFFER_POOL_MIN_CLASS_SIZE << (BUFFER_POOL_NUM_CLASSES - 1) == NETWORK_BUFFER_SIZE, "The largest class has to hold a full packet");
+
+constexpr size_t POOL_PACKET_CLASS = BUFFER_POOL_NUM_CLASSES;
+constexpr size_t POOL_OVERSIZE_CLASS = BUFFER_POOL_NUM_CLASSES + 1;
+constexpr size_t POOL_CONTROL_BLOCK_SIZE = 64;
+constexpr size_t POOL_RETURN_BATCH_SIZE = 32;
+
+struct PoolArena;
+struct PoolBlock
+{
+    // The shared_ptr control block is placed here, so handing out a pooled block doesn't allocate
+    alignas(std::max_align_t) u8 controlBlock[POOL_CONTROL_BLOCK_SIZE];
+    PoolArena* arena = nullptr;
+    size_t classIndex = 0;
+};
+
+struct BufferBlock : PoolBlock
+{
+    BufferBlock(size_t size) : buffer(reinterpret_cast<u8*>(this + 1), size) { }
+    Bytebuffer buffer; // The data follows the block
+};
+
+struct PacketBlock : PoolBlock
+{
+    NetworkPacket packet;
+};
+
+struct PoolClass
+{
+    std::vector<PoolBlock*> freeBlocks; // Only touched by the owning thread
+    moodycamel::ConcurrentQueue<PoolBlock*> returnedBlocks; // Released by other threads, moved to freeBlocks on a miss
+
+    std::atomic<u64> borrows = 0;
+    std::atomic<u64> hits = 0;
+    std::atomic<u64> inUse = 0;
+    std::atomic<u64> highWater = 0;
+    std::atomic<u64> retained = 0; // freeBlocks and returnedBlocks together
+    std::atomic<u64> bytesRequested = 0;
+    std::atomic<u64> bytesServed = 0;
+};
+
+struct PoolArena
+{
+    PoolClass classes[BUFFER_POOL_NUM_CLASSES + 1];
+};
+
+struct PoolOpcode
+{
+    std::atomic<u64> packets = 0;
+    std::atomic<u64> bytes = 0;
+    std::atomic<u16> maxSize = 0;
+};
+
+static std::mutex arenasMutex;
+static std::vector<PoolArena*> arenas; // Never freed, blocks can outlive the thread that borrowed them
+static std::vector<PoolArena*> freeArenas; // Left behind by threads that exited, taken over by the next thread that borrows
+static std::atomic<size_t> retainLimit = 256;
+static PoolOpcode opcodes[BUFFER_POOL_MAX_OPCODES];
+
+static thread_local PoolArena* threadArena = nullptr;
+
+// Hands the thread's arena to freeArenas when the thread exits, blocks released after that (by this thread or any other) go through the returned queues
+struct PoolArenaOwner
+{
+    ~PoolArenaOwner()
+    {
+        if (!threadArena)
+            return;
+
+        std::lock_guard<std::mutex> lock(arenasMutex);
+        freeArenas.push_back(threadArena);
+        threadArena = nullptr;
+    }
+};
+
+static thread_local PoolArenaOwner threadArenaOwner;
+
+static PoolArena& GetThreadArena()
+{
+    // Threads that only release blocks (the asio thread sending responses) never get an arena
+    if (!threadArena)
+    {
+        {
+            std::lock_guard<std::mutex> lock(arenasMutex);
+            if (!freeArenas.empty())
+            {
+                // The free blocks it still holds come with it, the statistics keep adding up in the same arena
+                threadArena = freeArenas.back();
+                freeArenas.pop_back();
+            }
+            else
+            {
+                threadArena = new PoolArena();
+                arenas.push_back(threadArena);
+            }
+        }
+
+        // Registers the owner's destructor for this thread
+        (void)threadArenaOwner;
+    }
+
+    return *threadArena;
+}
+
+static void DestroyBlock(PoolBlock* block)
+{
+    if (block->classIndex == POOL_PACKET_CLASS)
+        static_cast<PacketBlock*>(block)->~PacketBlock();
+    else
+        static_cast<BufferBlock*>(block)->~BufferBlock();
+
+    ::operator delete(block);
+}
+
+static void ReleaseBlock(PoolBlock* block)
+{
+    if (block->classIndex == POOL_OVERSIZE_CLASS)
+    {
+        DestroyBlock(block);
+        return;
+    }
+
+    PoolClass& poolClass = block->arena->classes[block->classIndex];
+    poolClass.inUse.fetch_sub(1, std::memory_order_relaxed);
+
+    if (poolClass.retained.load(std::memory_order_relaxed) >= retainLimit.load(std::memory_order_relaxed))
+    {
+        DestroyBlock(block);
+        return;
+    }
+
+    poolClass.retained.fetch_add(1, std::memory_order_relaxed);
+
+    if (block->arena == threadArena)
+        poolClass.freeBlocks.push_back(block);
+    else
+        poolClass.returnedBlocks.enqueue(block);
+}
+
+// Takes a free block of the class from the calling thread's arena, nullptr if the caller has to allocate one
+static PoolBlock* AcquireBlock(PoolArena& arena, size_t classIndex, size_t requestedSize, size_t servedSize)
+{
+    PoolClass& poolClass = arena.classes[classIndex];
+
+    if (poolClass.freeBlocks.empty())
+    {
+        PoolBlock* returnedBlocks[POOL_RETURN_BATCH_SIZE];
+        size_t numReturned = poolClass.returnedBlocks.try_dequeue_bulk(returnedBlocks, POOL_RETURN_BATCH_SIZE);
+        poolClass.freeBlocks.insert(poolClass.freeBlocks.end(), returnedBlocks, returnedBlocks + numReturned);
+    }
+
+    PoolBlock* block = nullptr;
+    if (!poolClass.freeBlocks.empty())
+    {
+        block = poolClass.freeBlocks.back();
+        poolClass.freeBlocks.pop_back();
+
+        poolClass.retained.fetch_sub(1, std::memory_order_relaxed);
+        poolClass.hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    poolClass.borrows.fetch_add(1, std::memory_order_relaxed);
+    poolClass.bytesRequested.fetch_add(requestedSize, std::memory_order_relaxed);
+    poolClass.bytesServed.fetch_add(servedSize, std::memory_order_relaxed);
+
+    u64 inUse = poolClass.inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (inUse > poolClass.highWater.load(std::memory_order_relaxed))
+        poolClass.highWater.store(inUse, std::memory_order_relaxed);
+
+    return block;
+}
+
+// Hands the control block storage of the pooled block to shared_ptr, the block goes back to the pool once the control block is gone
+template <typename T>
+struct PoolBlockAllocator
+{
+    using value_type = T;
+
+    explicit PoolBlockAllocator(PoolBlock* inBlock) : block(inBlock) { }
+    template <typename U>
+    PoolBlockAllocator(const PoolBlockAllocator<U>& other) : block(other.block) { }
+
+    T* allocate(size_t count)
+    {
+        static_assert(sizeof(T) <= POOL_CONTROL_BLOCK_SIZE && alignof(T) <= alignof(std::max_align_t), "The shared_ptr control block doesn't fit in a pool block");
+        assert(count == 1);
+        return reinterpret_cast<T*>(block->controlBlock);
+    }
+
+    void deallocate(T*, size_t) { ReleaseBlock(block); }
+
+    template <typename U>
+    bool operator==(const PoolBlockAllocator<U>& other) const { return block == other.block; }
+    template <typename U>
+    bool operator!=(const PoolBlockAllocator<U>& other) const { return block != other.block; }
+
+    PoolBlock* block;
+};
+
+// Nothing to free, the block itself is released by the allocator
+struct PoolBufferDeleter
+{
+    void operator()(Bytebuffer*) const { }
+};
+
+struct PoolPacketDeleter
+{
+    void operator()(NetworkPacket* packet) const { packet->payload.reset(); }
+};
+
+std::shared_ptr<Bytebuffer> BufferPool::Borrow(size_t size)
+{
+    size_t classIndex = GetClassIndex(size);
+    size_t classSize = classIndex == POOL_OVERSIZE_CLASS ? size : GetClassSize(classIndex);
+
+    PoolBlock* block = nullptr;
+    if (classIndex != POOL_OVERSIZE_CLASS)
+    {
+        PoolArena& arena = GetThreadArena();
+        block = AcquireBlock(arena, classIndex, size, classSize);
+
+        if (!block)
+        {
+            block = new (::operator new(sizeof(BufferBlock) + classSize)) BufferBlock(classSize);
+            block->arena = &arena;
+            block->classIndex = classIndex;
+        }
+    }
+    else
+    {
+        block = new (::operator new(sizeof(BufferBlock) + classSize)) BufferBlock(classSize);
+        block->classIndex = classIndex;
+    }
+
+    Bytebuffer* buffer = &static_cast<BufferBlock*>(block)->buffer;
+    buffer->size = classSize;
+    buffer->Reset();
+
+    return std::shared_ptr<Bytebuffer>(buffer, PoolBufferDeleter(), PoolBlockAllocator<Bytebuffer>(block));
+}
+
+std::shared_ptr<NetworkPacket> BufferPool::BorrowPacket(Opcode opcode, u16 size)
+{
+    RecordPacket(opcode, size);
+
+    PoolArena& arena = GetThreadArena();
+    PoolBlock* block = AcquireBlock(arena, POOL_PACKET_CLASS, sizeof(NetworkPacket), sizeof(NetworkPacket));
+
+    if (!block)
+    {
+        block = new (::operator new(sizeof(PacketBlock))) PacketBlock();
+        block->arena = &arena;
+        block->classIndex = POOL_PACKET_CLASS;
+    }
+
+    NetworkPacket* packet = &static_cast<PacketBlock*>(block)->packet;
+    packet->header.opcode = opcode;
+    packet->header.size = size;
+
+    return std::shared_ptr<NetworkPacket>(packet, PoolPacketDeleter(), PoolBlockAllocator<NetworkPacket>(block));
+}
+
+std::shared_ptr<Bytebuffer> BufferPool::BorrowPayload(Opcode opcode, size_t size)
+{
+    return Borrow(std::max(size, GetSizeHint(opcode)));
+}
+
+std::shared_ptr<Bytebuffer> BufferPool::BorrowFor(Opcode opcode, size_t payloadSize)
+{
+    // The largest payload rather than its class, the header on top of a full class would take the next one
+    size_t opcodeIndex = static_cast<size_t>(opcode);
+    if (opcodeIndex < BUFFER_POOL_MAX_OPCODES)
+        payloadSize = std::max<size_t>(payloadSize, opcodes[opcodeIndex].maxSize.load(std::memory_order_relaxed));
+
+    return Borrow(BUFFER_POOL_HEADER_SIZE + payloadSize);
+}
+
+void BufferPool::RecordPacket(Opcode opcode, u16 size)
+{
+    size_t opcodeIndex = static_cast<size_t>(opcode);
+    if (opcodeIndex >= BUFFER_POOL_MAX_OPCODES)
+        return;
+
+    PoolOpcode& poolOpcode = opcodes[opcodeIndex];
+    poolOpcode.packets.fetch_add(1, std::memory_order_relaxed);
+    poolOpcode.bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (size > poolOpcode.maxSize.load(std::memory_order_relaxed))
+        poolOpcode.maxSize.store(size, std::memory_order_relaxed);
+}
+
+void BufferPool::SetRetainLimit(size_t limit)
+{
+    retainLimit = limit;
+}
+
+static BufferPoolStatistics GetStatistics(size_t classIndex)
+{
+    BufferPoolStatistics statistics;
+
+    std::lock_guard<std::mutex> lock(arenasMutex);
+    for (PoolArena* arena : arenas)
+    {
+        const PoolClass& poolClass = arena->classes[classIndex];
+
+        statistics.borrows += poolClass.borrows.load(std::memory_order_relaxed);
+        statistics.hits += poolClass.hits.load(std::memory_order_relaxed);
+        statistics.inUse += poolClass.inUse.load(std::memory_order_relaxed);
+        statistics.highWater += poolClass.highWater.load(std::memory_order_relaxed);
+        statistics.retained += poolClass.retained.load(std::memory_order_relaxed);
+        statistics.bytesRequested += poolClass.bytesRequested.load(std::memory_order_relaxed);
+        statistics.bytesServed += poolClass.bytesServed.load(std::memory_order_relaxed);
+    }
+
+    return statistics;
+}
+
+std::vector<BufferPoolStatistics> BufferPool::GetClassStatistics()
+{
+    std::vector<BufferPoolStatistics> classStatistics;
+    classStatistics.reserve(BUFFER_POOL_NUM_CLASSES);
+
+    for (size_t i = 0; i < BUFFER_POOL_NUM_CLASSES; i++)
+    {
+        BufferPoolStatistics& statistics = classStatistics.emplace_back(GetStatistics(i));
+        statistics.size = GetClassSize(i);
+    }
+
+    return classStatistics;
+}
+
+BufferPoolStatistics BufferPool::GetPacketStatistics()
+{
+    return GetStatistics(POOL_PACKET_CLASS);
+}
+
+std::vector<BufferPoolOpcodeStatistics> BufferPool::GetOpcodeStatistics()
+{
+    std::vector<BufferPoolOpcodeStatistics> opcodeStatistics;
+
+    for (size_t i = 0; i < BUFFER_POOL_MAX_OPCODES; i++)
+    {
+        const PoolOpcode& poolOpcode = opcodes[i];
+
+        u64 packets = poolOpcode.packets.load(std::memory_order_relaxed);
+        if (!packets)
+            continue;
+
+        BufferPoolOpcodeStatistics& statistics = opcodeStatistics.emplace_back();
+        statistics.opcode = static_cast<Opcode>(i);
+        statistics.packets = packets;
+        statistics.bytes = poolOpcode.bytes.load(std::memory_order_relaxed);
+        statistics.maxSize = poolOpcode.maxSize.load(std::memory_order_relaxed);
+    }
+
+    return opcodeStatistics;
+}
+
+size_t BufferPool::GetSizeHint(Opcode opcode)
+{
+    size_t opcodeIndex = static_cast<size_t>(opcode);
+    if (opcodeIndex >= BUFFER_POOL_MAX_OPCODES || !opcodes[opcodeIndex].packets.load(std::memory_order_relaxed))
+        return 0;
+
+    size_t classIndex = GetClassIndex(opcodes[opcodeIndex].maxSize.load(std::memory_order_relaxed));
+    return classIndex < BUFFER_POOL_NUM_CLASSES ? GetClassSize(classIndex) : 0;
+}
+
+size_t BufferPool::GetClassIndex(size_t size)
+{
+    size_t classIndex = 0;
+    while (classIndex < BUFFER_POOL_NUM_CLASSES && GetClassSize(classIndex) < size)
+    {
+        classIndex++;
+    }
+
+    return classIndex < BUFFER_POOL_NUM_CLASSES ? classIndex : POOL_OVERSIZE_CLASS;
+}
\ No newline at end of file
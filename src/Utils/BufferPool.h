@@ -0,0 +1,94 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+#include <Utils/ByteBuffer.h>
+#include <Networking/NetworkPacket.h>
+
+constexpr size_t BUFFER_POOL_NUM_CLASSES = 8; // 64, 128, ... up to NETWORK_BUFFER_SIZE
+constexpr size_t BUFFER_POOL_MIN_CLASS_SIZE = 64;
+constexpr size_t BUFFER_POOL_MAX_OPCODES = 256;
+constexpr size_t BUFFER_POOL_HEADER_SIZE = sizeof(Opcode) + sizeof(u16); // As written by the senders, opcode then payload size
+
+struct BufferPoolStatistics
+{
+    size_t size = 0; // 0 for packets
+
+    u64 borrows = 0;
+    u64 hits = 0; // Borrows served from a free list instead of the heap
+    u64 inUse = 0;
+    u64 highWater = 0;
+    u64 retained = 0; // Free blocks held by the arenas
+    u64 bytesRequested = 0;
+    u64 bytesServed = 0; // bytesServed - bytesRequested is what rounding up to the class cost
+
+    f32 GetHitRate() const { return borrows ? static_cast<f32>(hits) / borrows : 0.0f; }
+    u64 GetBytesWasted() const { return bytesServed - bytesRequested; }
+};
+
+struct BufferPoolOpcodeStatistics
+{
+    Opcode opcode = Opcode::INVALID;
+    u64 packets = 0;
+    u64 bytes = 0;
+    u16 maxSize = 0;
+};
+
+/*
+    Per-thread size-classed arenas for packets and payload buffers.
+    A borrow takes the smallest class that fits and is served from the calling thread's free list, the shared_ptr control block lives inside the pooled block so a hit doesn't touch the heap.
+    Blocks released on another thread (packets read on the io thread are released by the engine) are handed back to their arena through a queue.
+*/
+class BufferPool
+{
+public:
+    // A buffer with room for at least size bytes, anything above NETWORK_BUFFER_SIZE is allocated exactly and not pooled
+    static std::shared_ptr<Bytebuffer> Borrow(size_t size);
+
+    // A packet with the header filled in and no payload, the header also feeds the per-opcode statistics
+    static std::shared_ptr<NetworkPacket> BorrowPacket(Opcode opcode, u16 size);
+
+    // A payload buffer of at least size bytes from the opcode's size hint class, every payload of the opcode is then served from the same free list
+    static std::shared_ptr<Bytebuffer> BorrowPayload(Opcode opcode, size_t size);
+
+    // A buffer for one outgoing packet of the opcode with room for the header and at least payloadSize, rounded up to the largest one sent so far
+    static std::shared_ptr<Bytebuffer> BorrowFor(Opcode opcode, size_t payloadSize);
+
+    // Feeds a packet into the per-opcode statistics and size hints, BorrowPacket does this for what we read and senders call it for what they wrote
+    static void RecordPacket(Opcode opcode, u16 size);
+
+    // Free blocks an arena keeps per class, anything released past that goes back to the heap so a burst doesn't stay resident
+    static void SetRetainLimit(size_t retainLimit);
+
+    static std::vector<BufferPoolStatistics> GetClassStatistics();
+    static BufferPoolStatistics GetPacketStatistics();
+    static std::vector<BufferPoolOpcodeStatistics> GetOpcodeStatistics();
+
+    // The smallest class that fits every payload seen so far for the opcode, 0 if it hasn't been seen
+    static size_t GetSizeHint(Opcode opcode);
+
+    static size_t GetClassSize(size_t classIndex) { return BUFFER_POOL_MIN_CLASS_SIZE << classIndex; }
+    static size_t GetClassIndex(size_t size);
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Utils/StringUtils.h>
+#include "Logger.h"
+
+// Where a command's replies go, the console prints them while the admin socket collects them and replies once the last reference is gone
+class CommandOutput
+{
+public:
+    virtual ~CommandOutput() { }
+
+    template <typename... Args>
+    void Print(const char* format, const Args&... args) { Write(LogLevel::Info, format, args...); }
+    template <typename... Args>
+    void PrintSuccess(const char* format, const Args&... args) { Write(LogLevel::Success, format, args...); }
+    template <typename... Args>
+    void PrintWarning(const char* format, const Args&... args) { Write(LogLevel::Warning, format, args...); }
+
+protected:
+    virtual void WriteLine(LogLevel level, const char* line) = 0;
+
+private:
+    template <typename... Args>
+    void Write(LogLevel level, const char* format, const Args&... args)
+    {
+        char line[LOG_LINE_SIZE];
+        StringUtils::FormatString(line, sizeof(line), format, args...);
+        WriteLine(level, line);
+    }
+};
+
+class ConsoleOutput : public CommandOutput
+{
+protected:
+    void WriteLine(LogLevel level, const char* line) override
+    {
+        switch (level)
+        {
+            case LogLevel::Success:
+                Logger::PrintSuccess("%s", line);
+                break;
+            case LogLevel::Warning:
+                Logger::PrintWarning("%s", line);
+                break;
+            default:
+                Logger::Print("%s", line);
+                break;
+        }
+    }
+};
\ No newline at end of file
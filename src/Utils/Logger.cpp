@@ -0,0 +1,131 @@
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <Utils/DebugHandler.h>
+#include "ThreadAffinity.h"
+
+std::atomic<bool> Logger::_isRunning = false;
+std::atomic<bool> Logger::_isVerbose = false;
+std::atomic<u64> Logger::_numDropped = 0;
+
+static std::mutex ringsMutex;
+static std::vector<std::shared_ptr<LogRing>> rings;
+static std::thread loggerThread;
+static std::vector<std::shared_ptr<LogRing>> activeRings; // Only touched by the logger thread
+static u64 reportedDropped = 0;
+
+LogRing& Logger::GetThreadRing()
+{
+    // The logger keeps its own reference so records are still printed after the thread exits
+    thread_local std::shared_ptr<LogRing> threadRing = []()
+    {
+        std::shared_ptr<LogRing> ring = std::make_shared<LogRing>();
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(ring);
+        return ring;
+    }();
+
+    return *threadRing;
+}
+
+void Logger::Start()
+{
+    if (_isRunning.exchange(true))
+        return;
+
+    loggerThread = std::thread(&Logger::Run);
+}
+
+void Logger::Stop()
+{
+    if (!_isRunning.exchange(false))
+        return;
+
+    loggerThread.join();
+}
+
+void Logger::Run()
+{
+    ThreadAffinity::Apply("logger");
+
+    while (_isRunning)
+    {
+        if (!Drain())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    // Flush whatever was logged before Stop
+    while (Drain()) { }
+}
+
+bool Logger::Drain()
+{
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+
+        // Rings only we reference belong to threads that have exited, drop them once they are empty
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<LogRing>& ring)
+        {
+            return ring.use_count() == 1 && ring->tail.load() == ring->head.load();
+        }), rings.end());
+
+        activeRings = rings;
+    }
+
+    bool didWork = false;
+    char line[LOG_LINE_SIZE];
+
+    for (auto& ring : activeRings)
+    {
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        size_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++)
+        {
+            const LogRecord& record = ring->records[tail & (LOG_RING_SIZE - 1)];
+            record.formatFunction(line, sizeof(line), record.format, record.data);
+
+            switch (record.level)
+            {
+                case LogLevel::Info:
+                    DebugHandler::Print("%s", line);
+                    break;
+                case LogLevel::Success:
+                    DebugHandler::PrintSuccess("%s", line);
+                    break;
+                case LogLevel::Warning:
+                    DebugHandler::PrintWarning("%s", line);
+                    break;
+                case LogLevel::Error:
+                    DebugHandler::PrintError("%s", line);
+                    break;
+            }
+
+            didWork = true;
+        }
+
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    activeRings.clear();
+
+    u64 dropped = _numDropped.load(std::memory_order_relaxed);
+    if (dropped > reportedDropped)
+    {
+        DebugHandler::PrintWarning("[Logger]: Dropped %llu records, the log rings were full", dropped - reportedDropped);
+        reportedDropped = dropped;
+    }
+
+    if (didWork)
+    {
+        fflush(stdout);
+    }
+
+    return didWork;
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <Utils/StringUtils.h>
+
+enum class LogLevel : u8
+{
+    Info,
+    Success,
+    Warning,
+    Error
+};
+
+constexpr size_t LOG_RECORD_DATA_SIZE = 224;
+constexpr size_t LOG_RING_SIZE = 1024; // Records per thread, must be a power of two
+constexpr size_t LOG_LINE_SIZE = 512;
+
+/*
+    Arguments are stored in their binary form and only formatted on the logger thread.
+    Strings are copied into the record (truncated if they don't fit), everything else has to be trivially copyable.
+*/
+template <typename T>
+struct LogArgument
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Log arguments must be trivially copyable or strings");
+    using Decoded = T;
+    static constexpr size_t MinSize = sizeof(T);
+
+    static void Write(u8*& cursor, const u8* end, const T& value)
+    {
+        std::memcpy(cursor, &value, sizeof(T));
+        cursor += sizeof(T);
+    }
+    static Decoded Read(const u8*& cursor)
+    {
+        T value;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+};
+
+struct LogStringArgument
+{
+    using Decoded = const char*;
+    static constexpr size_t MinSize = sizeof(char);
+
+    // end already excludes the space the remaining arguments need
+    static void Write(u8*& cursor, const u8* end, const char* value)
+    {
+        size_t length = std::min(std::strlen(value), static_cast<size_t>(end - cursor) - 1);
+        std::memcpy(cursor, value, length);
+        cursor[length] = '\0';
+        cursor += length + 1;
+    }
+    static Decoded Read(const u8*& cursor)
+    {
+        const char* value = reinterpret_cast<const char*>(cursor);
+        cursor += std::strlen(value) + 1;
+        return value;
+    }
+};
+
+template <> struct LogArgument<const char*> : LogStringArgument { };
+template <> struct LogArgument<char*> : LogStringArgument { };
+template <> struct LogArgument<std::string> : LogStringArgument
+{
+    static void Write(u8*& cursor, const u8* end, const std::string& value) { LogStringArgument::Write(cursor, end, value.c_str()); }
+};
+
+using LogFormatFunction = void(*)(char* output, size_t size, const char* format, const u8* data);
+
+struct LogRecord
+{
+    LogLevel level = LogLevel::Info;
+    const char* format = nullptr; // Must outlive the record, in practice always a string literal
+    LogFormatFunction formatFunction = nullptr;
+    u8 data[LOG_RECORD_DATA_SIZE];
+};
+
+// Single producer (the thread that owns it), single consumer (the logger thread)
+struct LogRing
+{
+    LogRecord records[LOG_RING_SIZE];
+    std::atomic<size_t> head = 0;
+    std::atomic<size_t> tail = 0;
+};
+
+/*
+    Background logger, records are pushed into a ring owned by the calling thread and formatted, printed and flushed on the logger thread.
+    Pushing never blocks or allocates (apart from a thread's first record, which registers its ring), when the ring is full the record is dropped and counted.
+*/
+class Logger
+{
+public:
+    static void Start();
+    static void Stop();
+
+    static bool IsVerbose() { return _isVerbose; }
+    static void SetVerbose(bool isVerbose) { _isVerbose = isVerbose; }
+    static u64 GetNumDropped() { return _numDropped.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    static void Print(const char* format, const Args&... args) { Push(LogLevel::Info, format, args...); }
+    template <typename... Args>
+    static void PrintSuccess(const char* format, const Args&... args) { Push(LogLevel::Success, format, args...); }
+    template <typename... Args>
+    static void PrintWarning(const char* format, const Args&... args) { Push(LogLevel::Warning, format, args...); }
+    template <typename... Args>
+    static void PrintError(const char* format, const Args&... args) { Push(LogLevel::Error, format, args...); }
+
+private:
+    template <typename... Args>
+    static void Push(LogLevel level, const char* format, const Args&... args)
+    {
+        constexpr size_t minSize = (LogArgument<std::decay_t<Args>>::MinSize + ... + 0);
+        static_assert(minSize <= LOG_RECORD_DATA_SIZE, "Too many log arguments to fit in a record");
+
+        LogRing& ring = GetThreadRing();
+        size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= LOG_RING_SIZE)
+        {
+            _numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        LogRecord& record = ring.records[head & (LOG_RING_SIZE - 1)];
+        record.level = level;
+        record.format = format;
+        record.formatFunction = &Format<std::decay_t<Args>...>;
+
+        u8* cursor = record.data;
+        size_t reserved = minSize;
+        ((reserved -= LogArgument<std::decay_t<Args>>::MinSize, LogArgument<std::decay_t<Args>>::Write(cursor, record.data + LOG_RECORD_DATA_SIZE - reserved, args)), ...);
+
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename... Args>
+    static void Format(char* output, size_t size, const char* format, const u8* data)
+    {
+        // Braced initialization guarantees the arguments are read in order
+        std::tuple<typename LogArgument<Args>::Decoded...> values{ LogArgument<Args>::Read(data)... };
+        std::apply([output, size, format](auto... values)
+        {
+            StringUtils::FormatString(output, size, format, values...);
+        }, values);
+    }
+
+    static LogRing& GetThreadRing();
+    static void Run();
+    static bool Drain();
+
+private:
+    static std::atomic<bool> _isRunning;
+    static std::atomic<bool> _isVerbose;
+    static std::atomic<u64> _numDropped;
+};
\ No newline at end of file
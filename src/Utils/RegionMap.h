@@ -0,0 +1,131 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+constexpr u8 REGION_NONE = 0xFF;
+
+/*
+    Maps IPv4 addresses to region ids by prefix, configured as "region.map = 10.1.0.0/16=0, 10.2.0.0/16=1".
+    Requesters and servers are both placed with it, the longest matching prefix wins.
+*/
+class RegionMap
+{
+public:
+    // Replaces the current prefixes, false leaves them untouched if any entry is malformed
+    bool Parse(const std::string& map)
+    {
+        std::vector<Prefix> prefixes;
+
+        size_t position = 0;
+        while (position < map.size())
+        {
+            size_t end = map.find(',', position);
+            if (end == std::string::npos)
+                end = map.size();
+
+            std::string entry = map.substr(position, end - position);
+            position = end + 1;
+
+            entry.erase(std::remove(entry.begin(), entry.end(), ' '), entry.end());
+            if (entry.empty())
+                continue;
+
+            Prefix prefix;
+            if (!ParsePrefix(entry, prefix))
+                return false;
+
+            prefixes.push_back(prefix);
+        }
+
+        // Longest prefix first, so the first match is the most specific one
+        std::stable_sort(prefixes.begin(), prefixes.end(), [](const Prefix& a, const Prefix& b) { return a.length > b.length; });
+        _prefixes = std::move(prefixes);
+        return true;
+    }
+
+    // Addresses are host order like everywhere else, REGION_NONE if no prefix matches
+    u8 Find(u32 address) const
+    {
+        for (const Prefix& prefix : _prefixes)
+        {
+            if ((address & prefix.mask) == prefix.network)
+                return prefix.region;
+        }
+
+        return REGION_NONE;
+    }
+
+    bool IsEmpty() const { return _prefixes.empty(); }
+    size_t GetNumPrefixes() const { return _prefixes.size(); }
+
+private:
+    struct Prefix
+    {
+        u32 network = 0;
+        u32 mask = 0;
+        u8 length = 0;
+        u8 region = REGION_NONE;
+    };
+
+    // "a.b.c.d/length=region"
+    static bool ParsePrefix(const std::string& entry, Prefix& prefix)
+    {
+        const char* text = entry.c_str();
+        char* end = nullptr;
+
+        u32 address = 0;
+        for (u32 i = 0; i < 4; i++)
+        {
+            u32 octet = static_cast<u32>(std::strtoul(text, &end, 10));
+            if (end == text || octet > 255 || *end != (i < 3 ? '.' : '/'))
+                return false;
+
+            address = (address << 8) | octet;
+            text = end + 1;
+        }
+
+        u32 length = static_cast<u32>(std::strtoul(text, &end, 10));
+        if (end == text || length > 32 || *end != '=')
+            return false;
+
+        text = end + 1;
+        u32 region = static_cast<u32>(std::strtoul(text, &end, 10));
+        if (end == text || *end != '\0' || region >= REGION_NONE)
+            return false;
+
+        prefix.mask = length ? ~0u << (32 - length) : 0;
+        prefix.network = address & prefix.mask;
+        prefix.length = static_cast<u8>(length);
+        prefix.region = static_cast<u8>(region);
+        return true;
+    }
+
+private:
+    std::vector<Prefix> _prefixes;
+};
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "RequestTracer.h"
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <Utils/ConcurrentQueue.h>
+#include "Logger.h"
+
+constexpr size_t TRACE_MAX_QUEUED = 65536; // Records waiting for the writer, more are dropped instead of growing without bound
+
+std::atomic<u32> RequestTracer::_sampleRate = 0;
+std::atomic<bool> RequestTracer::_isRunning = false;
+std::atomic<u64> RequestTracer::_numWritten = 0;
+std::atomic<u64> RequestTracer::_numDropped = 0;
+
+static std::mutex tracerMutex; // Guards starting and stopping, SetSampleRate can be called from the console and the admin socket
+static std::string tracePath = "requests.trace";
+static FILE* traceFile = nullptr;
+static std::thread writerThread;
+static moodycamel::ConcurrentQueue<TraceRecord> recordQueue(1024);
+
+static std::atomic<u64> requestCounter = 0;
+static std::atomic<u32> nextTraceId = 1;
+
+void RequestTracer::SetPath(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(tracerMutex);
+    tracePath = path;
+}
+
+const std::string& RequestTracer::GetPath()
+{
+    return tracePath;
+}
+
+bool RequestTracer::SetSampleRate(u32 sampleRate)
+{
+    {
+        std::lock_guard<std::mutex> lock(tracerMutex);
+        if (sampleRate && !_isRunning && !Start())
+            return false;
+    }
+
+    _sampleRate.store(sampleRate, std::memory_order_relaxed);
+    return true;
+}
+
+bool RequestTracer::Start()
+{
+    traceFile = std::fopen(tracePath.c_str(), "wb");
+    if (!traceFile)
+    {
+        Logger::PrintWarning("[Trace]: Failed to open %s", tracePath.c_str());
+        return false;
+    }
+
+    TraceFileHeader header;
+    header.recordSize = sizeof(TraceRecord);
+    std::fwrite(&header, sizeof(header), 1, traceFile);
+
+    _isRunning = true;
+    writerThread = std::thread(&RequestTracer::Run);
+
+    Logger::Print("[Trace]: Writing sampled requests to %s", tracePath.c_str());
+    return true;
+}
+
+void RequestTracer::Stop()
+{
+    _sampleRate = 0;
+
+    std::lock_guard<std::mutex> lock(tracerMutex);
+    if (!_isRunning.exchange(false))
+        return;
+
+    writerThread.join();
+    std::fclose(traceFile);
+    traceFile = nullptr;
+}
+
+std::shared_ptr<TraceRecord> RequestTracer::Sample()
+{
+    u32 sampleRate = _sampleRate.load(std::memory_order_relaxed);
+    if (sampleRate == 0 || requestCounter.fetch_add(1, std::memory_order_relaxed) % sampleRate != 0)
+        return nullptr;
+
+    std::shared_ptr<TraceRecord> record = std::make_shared<TraceRecord>();
+    record->traceId = nextTraceId.fetch_add(1, std::memory_order_relaxed);
+    Mark(*record, TraceStage::READ);
+    return record;
+}
+
+void RequestTracer::Submit(const TraceRecord& record)
+{
+    if (!_isRunning || recordQueue.size_approx() >= TRACE_MAX_QUEUED)
+    {
+        _numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    recordQueue.enqueue(record);
+}
+
+void RequestTracer::Run()
+{
+    while (_isRunning)
+    {
+        if (!Drain())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+    // Write whatever was submitted before Stop
+    while (Drain()) { }
+}
+
+bool RequestTracer::Drain()
+{
+    TraceRecord records[256];
+    size_t numRecords = recordQueue.try_dequeue_bulk(records, 256);
+    if (!numRecords)
+        return false;
+
+    std::fwrite(records, sizeof(TraceRecord), numRecords, traceFile);
+    std::fflush(traceFile);
+
+    _numWritten.fetch_add(numRecords, std::memory_order_relaxed);
+    return true;
+}
\ No newline at end of file
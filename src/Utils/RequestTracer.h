@@ -0,0 +1,72 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "TraceFormat.h"
+
+/*
+    Samples one in every N address requests and records when it passes each TraceStage, the records are written to a binary file by a background thread.
+    An unsampled request costs a counter increment in HandleRead, the sample rate can be changed at any time and 0 turns tracing off.
+    Read the file with tools/tracedump.
+*/
+class RequestTracer
+{
+public:
+    // The file is only created once tracing is first turned on
+    static void SetPath(const std::string& path);
+    static void Stop();
+
+    // False if the trace file could not be opened, tracing then stays off
+    static bool SetSampleRate(u32 sampleRate);
+    static u32 GetSampleRate() { return _sampleRate.load(std::memory_order_relaxed); }
+
+    // Called for every request, returns a record to fill in if this one is sampled
+    static std::shared_ptr<TraceRecord> Sample();
+
+    // Queues a finished record for the writer thread
+    static void Submit(const TraceRecord& record);
+
+    static void Mark(TraceRecord& record, TraceStage stage)
+    {
+        record.timestamps[static_cast<size_t>(stage)] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static const std::string& GetPath();
+    static u64 GetNumWritten() { return _numWritten.load(std::memory_order_relaxed); }
+    static u64 GetNumDropped() { return _numDropped.load(std::memory_order_relaxed); }
+
+private:
+    static bool Start();
+    static void Run();
+    static bool Drain();
+
+private:
+    static std::atomic<u32> _sampleRate;
+    static std::atomic<bool> _isRunning;
+    static std::atomic<u64> _numWritten;
+    static std::atomic<u64> _numDropped;
+};
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 entt::registry* ServiceLocator::_gameRegistry = nullptr;
 MessageHandler* ServiceLocator::_networkMessageHandler = nullptr;
+WakeEvent* ServiceLocator::_engineWakeEvent = nullptr;
 
 void ServiceLocator::SetRegistry(entt::registry* registry)
 {
@@ -13,4 +14,9 @@ void ServiceLocator::SetNetworkMessageHandler(MessageHandler* networkMessageHand
 {
     assert(_networkMessageHandler == nullptr);
     _networkMessageHandler = networkMessageHandler;
+}
+void ServiceLocator::SetEngineWakeEvent(WakeEvent* engineWakeEvent)
+{
+    assert(_engineWakeEvent == nullptr);
+    _engineWakeEvent = engineWakeEvent;
 }
\ No newline at end of file
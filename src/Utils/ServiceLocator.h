@@ -28,6 +28,7 @@
 #include <Utils/Message.h>
 
 class MessageHandler;
+class WakeEvent;
 class ServiceLocator
 {
 public:
@@ -35,8 +36,11 @@ public:
     static void SetRegistry(entt::registry* registry);
     static MessageHandler* GetNetworkMessageHandler() { return _networkMessageHandler; }
     static void SetNetworkMessageHandler(MessageHandler* serverMessageHandler);
+    static WakeEvent* GetEngineWakeEvent() { return _engineWakeEvent; }
+    static void SetEngineWakeEvent(WakeEvent* engineWakeEvent);
 
 private:
     static entt::registry* _gameRegistry;
     static MessageHandler* _networkMessageHandler;
+    static WakeEvent* _engineWakeEvent;
 };
\ No newline at end of file
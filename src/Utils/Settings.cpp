@@ -0,0 +1,104 @@
+#include "Settings.h"
+#include <fstream>
+#include <Utils/DebugHandler.h>
+
+robin_hood::unordered_map<std::string, std::string> Settings::_values;
+
+static std::string Trim(const std::string& string)
+{
+    size_t first = string.find_first_not_of(" \t\r");
+    if (first == std::string::npos)
+        return "";
+
+    size_t last = string.find_last_not_of(" \t\r");
+    return string.substr(first, last - first + 1);
+}
+
+void Settings::Load(const std::string& path, i32 argc, char* argv[])
+{
+    std::ifstream file(path);
+    if (file.is_open())
+    {
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = Trim(line);
+
+            // Skip empty lines and comments
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            Set(line);
+        }
+
+        DebugHandler::Print("[Settings]: Loaded %s", path.c_str());
+    }
+
+    for (i32 i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0)
+        {
+            DebugHandler::PrintWarning("[Settings]: Ignoring argument %s, expected --key=value", argument.c_str());
+            continue;
+        }
+
+        Set(argument.substr(2));
+    }
+}
+
+void Settings::Set(const std::string& line)
+{
+    size_t separator = line.find('=');
+    if (separator == std::string::npos)
+    {
+        // A bare key is a flag that is turned on
+        _values[Trim(line)] = "1";
+        return;
+    }
+
+    _values[Trim(line.substr(0, separator))] = Trim(line.substr(separator + 1));
+}
+
+bool Settings::Has(const std::string& key)
+{
+    return _values.find(key) != _values.end();
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& defaultValue)
+{
+    auto itr = _values.find(key);
+    return itr != _values.end() ? itr->second : defaultValue;
+}
+
+i64 Settings::GetInt(const std::string& key, i64 defaultValue)
+{
+    auto itr = _values.find(key);
+    if (itr == _values.end())
+        return defaultValue;
+
+    char* end = nullptr;
+    i64 value = std::strtoll(itr->second.c_str(), &end, 10);
+    return end != itr->second.c_str() ? value : defaultValue;
+}
+
+f32 Settings::GetFloat(const std::string& key, f32 defaultValue)
+{
+    auto itr = _values.find(key);
+    if (itr == _values.end())
+        return defaultValue;
+
+    char* end = nullptr;
+    f32 value = std::strtof(itr->second.c_str(), &end);
+    return end != itr->second.c_str() ? value : defaultValue;
+}
+
+bool Settings::GetBool(const std::string& key, bool defaultValue)
+{
+    auto itr = _values.find(key);
+    if (itr == _values.end())
+        return defaultValue;
+
+    const std::string& value = itr->second;
+    return value == "1" || value == "true" || value == "yes" || value == "on";
+}
\ No newline at end of file
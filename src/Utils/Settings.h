@@ -0,0 +1,43 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+
+// Runtime configuration, "key = value" lines from a config file with "--key=value" command line arguments applied on top
+class Settings
+{
+public:
+    static void Load(const std::string& path, i32 argc, char* argv[]);
+
+    static bool Has(const std::string& key);
+    static std::string GetString(const std::string& key, const std::string& defaultValue);
+    static i64 GetInt(const std::string& key, i64 defaultValue);
+    static f32 GetFloat(const std::string& key, f32 defaultValue);
+    static bool GetBool(const std::string& key, bool defaultValue);
+
+private:
+    static void Set(const std::string& line);
+
+    static robin_hood::unordered_map<std::string, std::string> _values;
+};
\ No newline at end of file
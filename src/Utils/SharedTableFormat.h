@@ -0,0 +1,263 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/AddressType.h>
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+// This header is copied into projects that don't build with our definitions, Windows.h must not take min and max from them
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+    Layout of the routing table the load balancer publishes into shared memory for processes on the same host, see the shm.* settings.
+    The region is a SharedTableHeader followed by maxEntries SharedTableEntry slots, the first numEntries of them in use and in no particular order.
+    The load balancer is the only writer and guards every change with the sequence counter (a seqlock), it is odd while a write is in progress.
+    This header is all a reader needs, copy it into the other project together with NovusTypes.h and AddressType.h.
+*/
+constexpr u32 SHARED_TABLE_MAGIC = 0x4C42544E; // "NTBL"
+constexpr u16 SHARED_TABLE_VERSION = 1;
+constexpr u8 SHARED_TABLE_REGION_NONE = 0xFF;
+
+enum SharedTableEntryState : u8
+{
+    SHARED_TABLE_STATE_ACTIVE = 0,
+    SHARED_TABLE_STATE_DRAINING = 1 // Must not be handed out, it only stays listed for the assignments it already has
+};
+
+struct SharedTableHeader
+{
+    u32 magic = 0;
+    u16 version = 0;
+    u16 entrySize = 0;
+    u32 maxEntries = 0;
+    std::atomic<u32> sequence = 0;
+    u32 tableVersion = 0; // The load balancer's table version as of the last write, answers carry the same version in their lease
+    u32 numEntries = 0;
+    u64 writeTime = 0; // System clock microseconds of the last write, the load balancer refreshes the loads regularly so an old value means it is gone
+};
+static_assert(sizeof(SharedTableHeader) == 32);
+static_assert(std::atomic<u32>::is_always_lock_free, "The sequence is shared between processes, a lock based atomic would keep its lock in each of them");
+
+struct SharedTableEntry
+{
+    u32 entity = 0;
+    u8 type = 0; // AddressType
+    u8 realmId = 0;
+    u8 region = SHARED_TABLE_REGION_NONE;
+    u8 state = SHARED_TABLE_STATE_ACTIVE;
+    u32 address = 0; // Host order IPv4
+    u16 port = 0;
+    u8 hasCapacity = 0;
+    u8 reserved = 0;
+    f32 weight = 0.0f; // Including the slow start ramp
+    f32 load = 0.0f; // Cluster wide, like the load balancer's own selection uses
+    u32 freeCapacity = 0; // Only meaningful with hasCapacity
+};
+static_assert(sizeof(SharedTableEntry) == 28);
+
+inline size_t GetSharedTableSize(u32 maxEntries)
+{
+    return sizeof(SharedTableHeader) + static_cast<size_t>(maxEntries) * sizeof(SharedTableEntry);
+}
+
+// A consistent copy of the table, taken without any syscall once the reader is open
+struct SharedTableSnapshot
+{
+    u32 tableVersion = 0;
+    u64 writeTime = 0;
+    std::vector<SharedTableEntry> entries;
+};
+
+class SharedTableReader
+{
+public:
+    ~SharedTableReader() { Close(); }
+
+    // The name is the load balancer's shm.name, false until it has created the table
+    bool Open(const std::string& name)
+    {
+        Close();
+
+#ifdef _WIN32
+        _mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+        if (!_mapping)
+            return false;
+
+        void* data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data)
+        {
+            Close();
+            return false;
+        }
+
+        MEMORY_BASIC_INFORMATION memoryInformation;
+        _size = VirtualQuery(data, &memoryInformation, sizeof(memoryInformation)) ? memoryInformation.RegionSize : 0;
+#else
+        i32 fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+
+        struct stat fileStatus;
+        if (fstat(fd, &fileStatus) != 0 || static_cast<size_t>(fileStatus.st_size) < sizeof(SharedTableHeader))
+        {
+            close(fd);
+            return false;
+        }
+
+        _size = static_cast<size_t>(fileStatus.st_size);
+        void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (data == MAP_FAILED)
+            return false;
+#endif
+        _data = static_cast<u8*>(data);
+
+        const SharedTableHeader* header = GetHeader();
+        if (_size < sizeof(SharedTableHeader) || header->magic != SHARED_TABLE_MAGIC || header->version != SHARED_TABLE_VERSION ||
+            header->entrySize != sizeof(SharedTableEntry) || _size < GetSharedTableSize(header->maxEntries))
+        {
+            Close();
+            return false;
+        }
+
+        // The header lives in memory the load balancer writes, only what was checked against our mapping may bound a copy
+        _maxEntries = header->maxEntries;
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (_data)
+            UnmapViewOfFile(_data);
+        if (_mapping)
+            CloseHandle(_mapping);
+        _mapping = nullptr;
+#else
+        if (_data)
+            munmap(_data, _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+        _maxEntries = 0;
+    }
+
+    bool IsOpen() const { return _data != nullptr; }
+
+    /*
+        Copies the table, retrying while the load balancer writes. False if it isn't open or every attempt overlapped a write,
+        or if a restarted load balancer took the region over with another shm.maxservers, Open it again to pick up the new size.
+    */
+    bool Read(SharedTableSnapshot& snapshot, u32 maxAttempts = 64) const
+    {
+        if (!_data)
+            return false;
+
+        const SharedTableHeader* header = GetHeader();
+        const SharedTableEntry* entries = reinterpret_cast<const SharedTableEntry*>(_data + sizeof(SharedTableHeader));
+
+        for (u32 attempt = 0; attempt < maxAttempts; attempt++)
+        {
+            u32 sequence = header->sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+                continue;
+
+            if (header->maxEntries != _maxEntries)
+                return false;
+
+            u32 numEntries = (std::min)(header->numEntries, _maxEntries);
+            snapshot.tableVersion = header->tableVersion;
+            snapshot.writeTime = header->writeTime;
+            snapshot.entries.resize(numEntries);
+            std::memcpy(snapshot.entries.data(), entries, numEntries * sizeof(SharedTableEntry));
+
+            // Whatever we copied is only valid if no write started in the meantime
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_relaxed) == sequence)
+                return true;
+        }
+
+        return false;
+    }
+
+    /*
+        The load balancer's default selection, the active server with the lowest load relative to its weight.
+        With a region its servers are preferred, servers elsewhere are only used when it has none. Nullptr if no server of the type is active.
+        Assignments made from a snapshot are not reported back, the loads only include what the load balancers handed out themselves.
+    */
+    static const SharedTableEntry* Select(const SharedTableSnapshot& snapshot, AddressType type, u8 realmId = 0, u8 region = SHARED_TABLE_REGION_NONE)
+    {
+        const SharedTableEntry* selected = nullptr;
+        f32 selectedScore = 0.0f;
+        bool selectedIsLocal = false;
+
+        for (const SharedTableEntry& entry : snapshot.entries)
+        {
+            if (entry.type != static_cast<u8>(type) || entry.realmId != realmId || entry.state != SHARED_TABLE_STATE_ACTIVE || entry.weight <= 0.0f)
+                continue;
+
+            bool isLocal = region == SHARED_TABLE_REGION_NONE || entry.region == region;
+            if (selected && selectedIsLocal && !isLocal)
+                continue;
+
+            f32 score = (entry.load + 1.0f) / entry.weight;
+            if (!selected || (isLocal && !selectedIsLocal) || score < selectedScore)
+            {
+                selected = &entry;
+                selectedScore = score;
+                selectedIsLocal = isLocal;
+            }
+        }
+
+        return selected;
+    }
+
+private:
+    const SharedTableHeader* GetHeader() const { return reinterpret_cast<const SharedTableHeader*>(_data); }
+
+    u8* _data = nullptr;
+    size_t _size = 0;
+    u32 _maxEntries = 0;
+#ifdef _WIN32
+    HANDLE _mapping = nullptr;
+#endif
+};
\ No newline at end of file
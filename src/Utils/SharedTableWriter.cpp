@@ -0,0 +1,222 @@
+#include "SharedTableWriter.h"
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool SharedTableWriter::Open(const std::string& name, u32 maxEntries)
+{
+    Close();
+
+    size_t size = GetSharedTableSize(maxEntries);
+
+#ifdef _WIN32
+    _mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<u64>(size) >> 32), static_cast<DWORD>(size), name.c_str());
+    if (!_mapping)
+        return false;
+
+    void* data = MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!data)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+        return false;
+    }
+#else
+    i32 fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    // Readers may still have a crashed load balancer's region mapped, shrinking it would fault their next copy, so it only ever grows
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (static_cast<size_t>(fileStatus.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+#endif
+
+    _name = name;
+    _size = size;
+    _header = static_cast<SharedTableHeader*>(data);
+    _entries = reinterpret_cast<SharedTableEntry*>(static_cast<u8*>(data) + sizeof(SharedTableHeader));
+
+    // A region left behind by a crashed load balancer may still have readers attached, they keep retrying while the sequence is odd
+    u32 sequence = _header->sequence.load(std::memory_order_relaxed);
+    _header->sequence.store(sequence | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    _header->version = SHARED_TABLE_VERSION;
+    _header->entrySize = sizeof(SharedTableEntry);
+    _header->maxEntries = maxEntries;
+    _header->numEntries = 0;
+    _header->magic = SHARED_TABLE_MAGIC;
+    _slots.clear();
+
+    EndWrite(0);
+    return true;
+}
+
+void SharedTableWriter::Close()
+{
+    if (!_header)
+        return;
+
+    // Readers still attached keep their mapping, they notice the table went stale through writeTime
+#ifdef _WIN32
+    UnmapViewOfFile(_header);
+    CloseHandle(_mapping);
+    _mapping = nullptr;
+#else
+    munmap(_header, _size);
+    shm_unlink(_name.c_str());
+#endif
+
+    _header = nullptr;
+    _entries = nullptr;
+    _size = 0;
+    _slots.clear();
+}
+
+void SharedTableWriter::Replace(const std::vector<SharedTableEntry>& entries, u32 tableVersion)
+{
+    if (!_header)
+        return;
+
+    u32 numEntries = static_cast<u32>(std::min<size_t>(entries.size(), _header->maxEntries));
+    _numDropped = entries.size() - numEntries;
+
+    BeginWrite();
+    std::memcpy(_entries, entries.data(), numEntries * sizeof(SharedTableEntry));
+    _header->numEntries = numEntries;
+    EndWrite(tableVersion);
+
+    _slots.clear();
+    for (u32 i = 0; i < numEntries; i++)
+    {
+        _slots[GetSlotKey(entries[i].type, entries[i].realmId, entries[i].entity)] = i;
+    }
+}
+
+void SharedTableWriter::Upsert(const SharedTableEntry& entry, u32 tableVersion)
+{
+    if (!_header)
+        return;
+
+    i64 slot = FindSlot(entry.type, entry.realmId, entry.entity);
+    if (slot < 0)
+    {
+        if (_header->numEntries >= _header->maxEntries)
+        {
+            _numDropped++;
+            return;
+        }
+
+        slot = _header->numEntries;
+        _slots[GetSlotKey(entry.type, entry.realmId, entry.entity)] = static_cast<u32>(slot);
+    }
+
+    BeginWrite();
+    _entries[slot] = entry;
+    _header->numEntries = std::max(_header->numEntries, static_cast<u32>(slot + 1));
+    EndWrite(tableVersion);
+}
+
+void SharedTableWriter::UpdateLoads(const std::vector<SharedTableEntry>& entries, u32 tableVersion)
+{
+    if (!_header)
+        return;
+
+    // Compared before the write starts, readers only retry for as long as the changed slots take to copy
+    _changedSlots.clear();
+    for (const SharedTableEntry& entry : entries)
+    {
+        auto itr = _slots.find(GetSlotKey(entry.type, entry.realmId, entry.entity));
+        if (itr == _slots.end())
+            continue;
+
+        const SharedTableEntry& sharedEntry = _entries[itr->second];
+        if (sharedEntry.weight != entry.weight || sharedEntry.load != entry.load || sharedEntry.freeCapacity != entry.freeCapacity)
+            _changedSlots.push_back({ itr->second, &entry });
+    }
+
+    BeginWrite();
+    for (auto& [slot, entry] : _changedSlots)
+    {
+        _entries[slot].weight = entry->weight;
+        _entries[slot].load = entry->load;
+        _entries[slot].freeCapacity = entry->freeCapacity;
+    }
+    EndWrite(tableVersion);
+}
+
+void SharedTableWriter::Remove(AddressType type, u8 realmId, u32 entity, u32 tableVersion)
+{
+    if (!_header)
+        return;
+
+    i64 slot = FindSlot(static_cast<u8>(type), realmId, entity);
+
+    BeginWrite();
+    if (slot >= 0)
+    {
+        u32 last = _header->numEntries - 1;
+        _entries[slot] = _entries[last];
+        _header->numEntries = last;
+    }
+    EndWrite(tableVersion);
+
+    if (slot >= 0)
+    {
+        _slots.erase(GetSlotKey(static_cast<u8>(type), realmId, entity));
+
+        const SharedTableEntry& moved = _entries[slot];
+        if (static_cast<u32>(slot) != _header->numEntries)
+            _slots[GetSlotKey(moved.type, moved.realmId, moved.entity)] = static_cast<u32>(slot);
+    }
+}
+
+void SharedTableWriter::BeginWrite()
+{
+    // Odd tells readers to retry, the fence keeps the entry writes from being seen before it
+    u32 sequence = _header->sequence.load(std::memory_order_relaxed);
+    _header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SharedTableWriter::EndWrite(u32 tableVersion)
+{
+    _header->tableVersion = tableVersion;
+    _header->writeTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    u32 sequence = _header->sequence.load(std::memory_order_relaxed);
+    _header->sequence.store(sequence + 1, std::memory_order_release);
+    _numWrites++;
+}
+
+i64 SharedTableWriter::FindSlot(u8 type, u8 realmId, u32 entity) const
+{
+    auto itr = _slots.find(GetSlotKey(type, realmId, entity));
+    return itr != _slots.end() ? static_cast<i64>(itr->second) : -1;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/AddressType.h>
+#include <string>
+#include <vector>
+#include "SharedTableFormat.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// The load balancer's side of SharedTableFormat.h, every call is a single seqlock write so readers never see half of it
+class SharedTableWriter
+{
+public:
+    ~SharedTableWriter() { Close(); }
+
+    // Creates (or takes over after a crash) the named region with room for maxEntries servers
+    bool Open(const std::string& name, u32 maxEntries);
+    void Close();
+    bool IsOpen() const { return _header != nullptr; }
+
+    // Replaces every entry, used when the table changed without going through Upsert and Remove
+    void Replace(const std::vector<SharedTableEntry>& entries, u32 tableVersion);
+
+    // Updates the server's slot in place, or takes a new one
+    void Upsert(const SharedTableEntry& entry, u32 tableVersion);
+
+    // Rewrites weight, load and free capacity of the servers whose values changed, in place. Always writes, so readers see a fresh writeTime
+    void UpdateLoads(const std::vector<SharedTableEntry>& entries, u32 tableVersion);
+
+    // Moves the last slot into the removed one, the table stays dense
+    void Remove(AddressType type, u8 realmId, u32 entity, u32 tableVersion);
+
+    u32 GetNumEntries() const { return _header ? _header->numEntries : 0; }
+    u32 GetMaxEntries() const { return _header ? _header->maxEntries : 0; }
+    u64 GetNumWrites() const { return _numWrites; }
+    u64 GetNumDropped() const { return _numDropped; }
+
+private:
+    void BeginWrite();
+    void EndWrite(u32 tableVersion);
+    i64 FindSlot(u8 type, u8 realmId, u32 entity) const;
+
+    static u64 GetSlotKey(u8 type, u8 realmId, u32 entity) { return (static_cast<u64>(entity) << 16) | (static_cast<u64>(type) << 8) | realmId; }
+
+private:
+    std::string _name;
+    SharedTableHeader* _header = nullptr;
+    SharedTableEntry* _entries = nullptr;
+    size_t _size = 0;
+
+    robin_hood::unordered_map<u64, u32> _slots; // GetSlotKey to the server's index in _entries
+    std::vector<std::pair<u32, const SharedTableEntry*>> _changedSlots; // Kept so UpdateLoads doesn't allocate
+#ifdef _WIN32
+    HANDLE _mapping = nullptr;
+#endif
+
+    u64 _numWrites = 0;
+    u64 _numDropped = 0; // Servers currently left out because they didn't fit into maxEntries
+};
\ No newline at end of file
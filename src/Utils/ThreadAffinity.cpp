@@ -0,0 +1,159 @@
+#include "ThreadAffinity.h"
+#include "Settings.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// The most CPUs Pin can address, anything past this can't be part of a mask anyway
+#ifdef _WIN32
+constexpr u32 MAX_AFFINITY_CPUS = sizeof(DWORD_PTR) * 8;
+#elif defined(__linux__)
+constexpr u32 MAX_AFFINITY_CPUS = CPU_SETSIZE;
+#else
+constexpr u32 MAX_AFFINITY_CPUS = 64;
+#endif
+
+void ThreadAffinity::Apply(const std::string& role)
+{
+    std::vector<u32> cpus;
+    if (GetCpus(role, cpus))
+    {
+        Report(role, cpus, Pin(cpus));
+    }
+}
+
+void ThreadAffinity::Apply(const std::string& role, size_t index)
+{
+    std::vector<u32> cpus;
+    if (GetCpus(role, cpus))
+    {
+        std::vector<u32> cpu = { cpus[index % cpus.size()] };
+        Report(role, cpu, Pin(cpu));
+    }
+}
+
+bool ThreadAffinity::GetCpus(const std::string& role, std::vector<u32>& cpus)
+{
+    std::string cpuSet = Settings::GetString("affinity." + role, "");
+    if (cpuSet.empty())
+    {
+        Report(role, cpus, false);
+        return false;
+    }
+
+    if (!ParseCpuSet(cpuSet, cpus))
+    {
+        Logger::PrintWarning("[Affinity]: Invalid CPU set \"%s\" for affinity.%s, expected a list like 2-3,6", cpuSet, role);
+        return false;
+    }
+
+    return true;
+}
+
+bool ThreadAffinity::ParseCpuSet(const std::string& cpuSet, std::vector<u32>& cpus)
+{
+    cpus.clear();
+
+    size_t position = 0;
+    while (position < cpuSet.size())
+    {
+        size_t end = cpuSet.find(',', position);
+        if (end == std::string::npos)
+            end = cpuSet.size();
+
+        std::string range = cpuSet.substr(position, end - position);
+        position = end + 1;
+
+        errno = 0;
+        char* rangeEnd = nullptr;
+        unsigned long first = std::strtoul(range.c_str(), &rangeEnd, 10);
+        if (rangeEnd == range.c_str() || errno == ERANGE || first >= MAX_AFFINITY_CPUS)
+            return false;
+
+        unsigned long last = first;
+        if (*rangeEnd == '-')
+        {
+            const char* lastStart = rangeEnd + 1;
+            last = std::strtoul(lastStart, &rangeEnd, 10);
+            if (rangeEnd == lastStart || errno == ERANGE || last < first)
+                return false;
+
+            // "0-4294967295" means every CPU we can pin to
+            last = std::min<unsigned long>(last, MAX_AFFINITY_CPUS - 1);
+        }
+
+        if (*rangeEnd != '\0')
+            return false;
+
+        for (unsigned long cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back(static_cast<u32>(cpu));
+        }
+    }
+
+    return !cpus.empty();
+}
+
+bool ThreadAffinity::Pin(const std::vector<u32>& cpus)
+{
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (u32 cpu : cpus)
+    {
+        if (cpu < sizeof(DWORD_PTR) * 8)
+            mask |= DWORD_PTR(1) << cpu;
+    }
+
+    return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (u32 cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &mask);
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+    return false;
+#endif
+}
+
+void ThreadAffinity::Report(const std::string& role, const std::vector<u32>& cpus, bool isPinned)
+{
+    i32 currentCpu = -1;
+#ifdef _WIN32
+    currentCpu = static_cast<i32>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+    currentCpu = sched_getcpu();
+#endif
+
+    if (cpus.empty())
+    {
+        Logger::Print("[Affinity]: %s thread is unpinned, running on CPU %d", role, currentCpu);
+        return;
+    }
+
+    std::string cpuList;
+    for (u32 cpu : cpus)
+    {
+        cpuList += (cpuList.empty() ? "" : ",") + std::to_string(cpu);
+    }
+
+    if (isPinned)
+    {
+        Logger::Print("[Affinity]: %s thread pinned to CPU %s, running on CPU %d", role, cpuList, currentCpu);
+    }
+    else
+    {
+        Logger::PrintWarning("[Affinity]: Failed to pin %s thread to CPU %s, running unpinned on CPU %d", role, cpuList, currentCpu);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+
+/*
+    Pins the calling thread to the CPUs configured for its role, "affinity.<role> = 2-3,6" in the settings.
+    Memory is placed on first touch, so a thread pinned before it allocates gets its pools from the local NUMA node.
+*/
+class ThreadAffinity
+{
+public:
+    // Pins the calling thread to every CPU configured for the role and reports where it ended up, does nothing if the role isn't configured
+    static void Apply(const std::string& role);
+
+    // Pins the calling thread to a single CPU of the role's set, chosen by index, used to spread pool workers over the set
+    static void Apply(const std::string& role, size_t index);
+
+    static bool ParseCpuSet(const std::string& cpuSet, std::vector<u32>& cpus);
+
+private:
+    static bool GetCpus(const std::string& role, std::vector<u32>& cpus);
+    static bool Pin(const std::vector<u32>& cpus);
+    static void Report(const std::string& role, const std::vector<u32>& cpus, bool isPinned);
+};
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "TimerWheel.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+constexpr u32 TIMER_NODE_NONE = ~0u;
+constexpr u32 TIMER_SLOT_MASK = TIMER_WHEEL_SLOTS - 1;
+constexpr u32 TIMER_LIST_FIRING = TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS;
+constexpr u32 TIMER_LIST_NONE = TIMER_LIST_FIRING + 1;
+constexpr u64 TIMER_WHEEL_RANGE = 1ull << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS);
+
+static_assert(TIMER_WHEEL_SLOTS == 64, "Slot occupancy is tracked in one u64 per level");
+
+static u32 CountTrailingZeros(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return static_cast<u32>(__builtin_ctzll(value));
+#endif
+}
+
+static u64 RotateRight(u64 value, u32 shift)
+{
+    shift &= 63;
+    return shift ? (value >> shift) | (value << (64 - shift)) : value;
+}
+
+TimerWheel::TimerWheel()
+{
+    _lists.resize(TIMER_LIST_FIRING + 1, TIMER_NODE_NONE);
+}
+
+TimerId TimerWheel::Schedule(u64 delayMS, TimerCallback callback)
+{
+    u32 index = AllocateNode();
+    TimerNode& node = _nodes[index];
+    node.expireTime = _currentTime + std::max<u64>(delayMS, 1);
+    node.interval = 0;
+    node.callback = std::move(callback);
+
+    Insert(index);
+    _numTimers++;
+
+    return (static_cast<u64>(node.generation) << 32) | index;
+}
+
+TimerId TimerWheel::ScheduleRepeating(u64 intervalMS, TimerCallback callback)
+{
+    intervalMS = std::max<u64>(intervalMS, 1);
+
+    TimerId timerId = Schedule(intervalMS, std::move(callback));
+    _nodes[static_cast<u32>(timerId)].interval = intervalMS;
+
+    return timerId;
+}
+
+bool TimerWheel::Cancel(TimerId timerId)
+{
+    u32 index = static_cast<u32>(timerId);
+    u32 generation = static_cast<u32>(timerId >> 32);
+
+    if (index >= _nodes.size() || _nodes[index].generation != generation || _nodes[index].list == TIMER_LIST_NONE)
+        return false;
+
+    Unlink(index);
+    FreeNode(index);
+    _numTimers--;
+
+    return true;
+}
+
+void TimerWheel::Advance(u64 nowMS)
+{
+    // Jump straight to the next tick that has anything to fire or cascade, there is nothing to do in between
+    while (_currentTime < nowMS)
+    {
+        u64 tick = GetNextDeadline();
+        if (tick > nowMS)
+        {
+            _currentTime = nowMS;
+            break;
+        }
+
+        _currentTime = tick;
+
+        if ((tick & TIMER_SLOT_MASK) == 0)
+            Cascade(tick);
+
+        Fire(tick);
+    }
+}
+
+u64 TimerWheel::GetNextDeadline() const
+{
+    u64 nextDeadline = ~0ull;
+
+    // The first occupied slot after the current one on every level, for the upper levels that is when the slot cascades
+    for (u32 level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        if (!_occupied[level])
+            continue;
+
+        u32 shift = level * TIMER_WHEEL_SLOT_BITS;
+        u64 block = _currentTime >> shift;
+        u32 start = (static_cast<u32>(block) + 1) & TIMER_SLOT_MASK;
+        u64 offset = CountTrailingZeros(RotateRight(_occupied[level], start)) + 1;
+
+        nextDeadline = std::min(nextDeadline, (block + offset) << shift);
+    }
+
+    return nextDeadline;
+}
+
+u32 TimerWheel::AllocateNode()
+{
+    if (!_freeNodes.empty())
+    {
+        u32 index = _freeNodes.back();
+        _freeNodes.pop_back();
+        return index;
+    }
+
+    _nodes.emplace_back().list = TIMER_LIST_NONE;
+    return static_cast<u32>(_nodes.size() - 1);
+}
+
+void TimerWheel::FreeNode(u32 index)
+{
+    TimerNode& node = _nodes[index];
+    node.callback = nullptr;
+
+    // Ids of the old timer must not match whoever gets the node next, and 0 stays TIMER_INVALID
+    if (++node.generation == 0)
+        node.generation = 1;
+
+    _freeNodes.push_back(index);
+}
+
+void TimerWheel::Insert(u32 index)
+{
+    TimerNode& node = _nodes[index];
+
+    // Past the range of the top level the timer waits in the furthest slot and is placed again once it cascades
+    u64 delta = node.expireTime - _currentTime;
+    u64 placementTime = node.expireTime;
+    if (delta >= TIMER_WHEEL_RANGE)
+    {
+        delta = TIMER_WHEEL_RANGE - 1;
+        placementTime = _currentTime + delta;
+    }
+
+    u32 level = 0;
+    while (delta >= (1ull << ((level + 1) * TIMER_WHEEL_SLOT_BITS)))
+    {
+        level++;
+    }
+
+    u32 slot = static_cast<u32>(placementTime >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_SLOT_MASK;
+    Link(index, level * TIMER_WHEEL_SLOTS + slot);
+}
+
+void TimerWheel::Link(u32 index, u32 list)
+{
+    TimerNode& node = _nodes[index];
+    node.list = list;
+    node.previous = TIMER_NODE_NONE;
+    node.next = _lists[list];
+
+    if (node.next != TIMER_NODE_NONE)
+        _nodes[node.next].previous = index;
+
+    _lists[list] = index;
+
+    if (list < TIMER_LIST_FIRING)
+        _occupied[list / TIMER_WHEEL_SLOTS] |= 1ull << (list & TIMER_SLOT_MASK);
+}
+
+void TimerWheel::Unlink(u32 index)
+{
+    TimerNode& node = _nodes[index];
+
+    if (node.previous != TIMER_NODE_NONE)
+        _nodes[node.previous].next = node.next;
+    else
+        _lists[node.list] = node.next;
+
+    if (node.next != TIMER_NODE_NONE)
+        _nodes[node.next].previous = node.previous;
+
+    if (node.list < TIMER_LIST_FIRING && _lists[node.list] == TIMER_NODE_NONE)
+        _occupied[node.list / TIMER_WHEEL_SLOTS] &= ~(1ull << (node.list & TIMER_SLOT_MASK));
+
+    node.list = TIMER_LIST_NONE;
+}
+
+void TimerWheel::Cascade(u64 tick)
+{
+    // A level only comes around when every level below it wrapped
+    for (u32 level = 1; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        u32 slot = static_cast<u32>(tick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_SLOT_MASK;
+        u32 list = level * TIMER_WHEEL_SLOTS + slot;
+
+        while (_lists[list] != TIMER_NODE_NONE)
+        {
+            u32 index = _lists[list];
+            Unlink(index);
+            Insert(index);
+        }
+
+        if (slot != 0)
+            break;
+    }
+}
+
+void TimerWheel::Fire(u64 tick)
+{
+    // Move the slot aside first, callbacks may schedule and cancel timers, including ones in this slot
+    u32 list = tick & TIMER_SLOT_MASK;
+    while (_lists[list] != TIMER_NODE_NONE)
+    {
+        u32 index = _lists[list];
+        Unlink(index);
+        Link(index, TIMER_LIST_FIRING);
+    }
+
+    while (_lists[TIMER_LIST_FIRING] != TIMER_NODE_NONE)
+    {
+        u32 index = _lists[TIMER_LIST_FIRING];
+        Unlink(index);
+
+        TimerNode& node = _nodes[index];
+        if (node.expireTime > tick)
+        {
+            Insert(index);
+            continue;
+        }
+
+        TimerCallback callback = std::move(node.callback);
+
+        if (node.interval)
+        {
+            // Rearm before the callback so it can cancel itself, _nodes may grow while it runs
+            u32 generation = node.generation;
+            node.expireTime = tick + node.interval;
+            Insert(index);
+
+            callback();
+
+            if (_nodes[index].generation == generation)
+                _nodes[index].callback = std::move(callback);
+        }
+        else
+        {
+            FreeNode(index);
+            _numTimers--;
+
+            callback();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <vector>
+#include <functional>
+
+using TimerId = u64; // Index and generation of the timer, stale ids are ignored by Cancel
+using TimerCallback = std::function<void()>;
+
+constexpr TimerId TIMER_INVALID = 0;
+constexpr u32 TIMER_WHEEL_LEVELS = 5;
+constexpr u32 TIMER_WHEEL_SLOT_BITS = 6;
+constexpr u32 TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS; // One bit per slot in the level's occupancy mask
+
+/*
+    Hierarchical timing wheel with millisecond ticks, five levels of 64 slots cover about 12 days and longer timers are re-armed when they reach the end.
+    Schedule and Cancel are O(1), a timer lives in an intrusive list and only moves down a level when its slot comes up.
+    Advance skips empty stretches through the occupancy masks, so idle time and the number of timers don't add per-frame work.
+*/
+class TimerWheel
+{
+public:
+    TimerWheel();
+
+    // Runs the callback once after delayMS, 0 runs it on the next tick
+    TimerId Schedule(u64 delayMS, TimerCallback callback);
+
+    // Runs the callback every intervalMS until cancelled, the first time after intervalMS
+    TimerId ScheduleRepeating(u64 intervalMS, TimerCallback callback);
+
+    // False if the timer already fired or was cancelled, safe to call from a callback, including the timer's own
+    bool Cancel(TimerId timerId);
+
+    // Fires every timer due up to nowMS in deadline order, nowMS is the caller's monotonic clock
+    void Advance(u64 nowMS);
+
+    // The earliest time a timer can be due, never later than the real deadline, ~0 if nothing is scheduled
+    u64 GetNextDeadline() const;
+
+    u64 GetTime() const { return _currentTime; }
+    size_t GetNumTimers() const { return _numTimers; }
+
+private:
+    struct TimerNode
+    {
+        u64 expireTime = 0;
+        u64 interval = 0;
+        TimerCallback callback;
+
+        u32 generation = 1;
+        u32 list = 0; // Slot list index, or one of the special lists below
+        u32 previous = 0;
+        u32 next = 0;
+    };
+
+    u32 AllocateNode();
+    void FreeNode(u32 index);
+
+    void Insert(u32 index);
+    void Link(u32 index, u32 list);
+    void Unlink(u32 index);
+
+    void Cascade(u64 tick);
+    void Fire(u64 tick);
+
+private:
+    std::vector<TimerNode> _nodes;
+    std::vector<u32> _freeNodes;
+
+    // One list per slot followed by the list that is being fired, heads are node indices
+    std::vector<u32> _lists;
+    u64 _occupied[TIMER_WHEEL_LEVELS] = { };
+
+    u64 _currentTime = 0;
+    size_t _numTimers = 0;
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+
+/*
+    Layout of the request trace files, shared with tools/tracedump.
+    A file is a TraceFileHeader followed by TraceRecords in the order the requests were answered, all fields are little endian.
+*/
+constexpr u32 TRACE_FILE_MAGIC = 0x5254434E; // "NCTR"
+constexpr u16 TRACE_FILE_VERSION = 1;
+
+// Where a sampled MSG_REQUEST_ADDRESS was timestamped, in the order it passes them
+enum class TraceStage : u8
+{
+    READ,    // Parsed out of the socket's receive buffer in HandleRead
+    DEQUEUE, // Taken off the packet queue by ConnectionUpdateSystem
+    HANDLER, // Queued for the AddressRequest systems by its handler
+    DECODE,
+    ROUTE,   // A server was selected, or the lookup failed
+    ENCODE,
+    SEND,    // Transport::Send returned, the response is with the kernel or queued on the asio thread
+    COUNT
+};
+
+inline const char* GetTraceStageName(TraceStage stage)
+{
+    constexpr const char* names[] = { "Read", "Dequeue", "Handler", "Decode", "Route", "Encode", "Send" };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(TraceStage::COUNT));
+
+    return stage < TraceStage::COUNT ? names[static_cast<size_t>(stage)] : "Unknown";
+}
+
+#pragma pack(push, 1)
+struct TraceFileHeader
+{
+    u32 magic = TRACE_FILE_MAGIC;
+    u16 version = TRACE_FILE_VERSION;
+    u8 numStages = static_cast<u8>(TraceStage::COUNT);
+    u8 reserved = 0;
+    u32 recordSize = 0;
+};
+
+struct TraceRecord
+{
+    u32 traceId = 0;
+    u8 addressType = 0;
+    u8 status = 0;
+    u8 flags = 0; // The request's AddressRequestFlags
+    u8 reserved = 0;
+    u64 timestamps[static_cast<size_t>(TraceStage::COUNT)] = { }; // Steady clock NS, 0 for stages the request never reached
+};
+#pragma pack(pop)
\ No newline at end of file
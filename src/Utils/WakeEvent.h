@@ -0,0 +1,56 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 NovusCore
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#pragma once
+#include <NovusTypes.h>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+// Lets the engine thread sleep between frames, threads that queue work for it call Wake so nothing waits for the timeout
+class WakeEvent
+{
+public:
+    void Wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isWoken = true;
+        }
+
+        _condition.notify_one();
+    }
+
+    // Returns early if Wake was called since the last wait, even before this one started
+    void WaitUntil(std::chrono::steady_clock::time_point time)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait_until(lock, time, [this]() { return _isWoken; });
+        _isWoken = false;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _isWoken = false;
+};
\ No newline at end of file
@@ -1,3 +1,4 @@
 #pragma once
 
-#define WINDOWNAME "Novus Load Balancer"
\ No newline at end of file
+#define WINDOWNAME "Novus Load Balancer"
+#define SETTINGS_PATH "loadbalancer.conf"
\ No newline at end of file
@@ -7,21 +7,55 @@
 
 #include "EngineLoop.h"
 #include "ConsoleCommands.h"
+#include "Utils/Settings.h"
+#include "Utils/Logger.h"
+#include "Utils/BufferPool.h"
+#include "Utils/RequestTracer.h"
+#include "Utils/CommandOutput.h"
+#include "Network/AdminSocket.h"
 
 #ifdef _WIN32
 #include <Windows.h>
 #endif
 
-i32 main()
+i32 main(i32 argc, char* argv[])
 {
 #ifdef _WIN32 //Windows
     SetConsoleTitle(WINDOWNAME);
 #endif
 
+    Settings::Load(SETTINGS_PATH, argc, argv);
+
+    // Verbose logging prints every packet, the logger thread keeps that off the engine and network threads
+    Logger::SetVerbose(Settings::GetBool("log.verbose", false));
+    Logger::Start();
+
+    BufferPool::SetRetainLimit(static_cast<size_t>(Settings::GetInt("pool.retain", 256)));
+
+    // Request tracing is off unless trace.rate is set, the "trace" command changes the rate while running
+    RequestTracer::SetPath(Settings::GetString("trace.file", RequestTracer::GetPath()));
+    RequestTracer::SetSampleRate(static_cast<u32>(Settings::GetInt("trace.rate", 0)));
+
     EngineLoop engineLoop;
     engineLoop.Start();
 
     ConsoleCommandHandler consoleCommandHandler;
+
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+    // Lets orchestration run the console commands without a TTY, off unless admin.socket names a path
+    std::shared_ptr<AdminSocket> adminSocket;
+    std::string adminSocketPath = Settings::GetString("admin.socket", "");
+    if (!adminSocketPath.empty())
+    {
+        adminSocket = std::make_shared<AdminSocket>(engineLoop.GetAsioService(), [&engineLoop, &consoleCommandHandler](std::string& command, std::shared_ptr<CommandOutput> output)
+        {
+            consoleCommandHandler.HandleCommand(engineLoop, command, output);
+        });
+        adminSocket->Open(adminSocketPath);
+    }
+#endif // ASIO_HAS_LOCAL_SOCKETS
+
+    std::shared_ptr<CommandOutput> consoleOutput = std::make_shared<ConsoleOutput>();
     std::future<std::string> future = std::async(std::launch::async, StringUtils::GetLineFromCin);
     while (true)
     {
@@ -50,11 +84,18 @@ i32 main()
             std::string command = future.get();
             std::transform(command.begin(), command.end(), command.begin(), ::tolower); // Convert command to lowercase
 
-            consoleCommandHandler.HandleCommand(engineLoop, command);
+            consoleCommandHandler.HandleCommand(engineLoop, command, consoleOutput);
             future = std::async(std::launch::async, StringUtils::GetLineFromCin);
         }
     }
 
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+    if (adminSocket)
+        adminSocket->Close();
+#endif // ASIO_HAS_LOCAL_SOCKETS
+
     engineLoop.Stop();
+    RequestTracer::Stop();
+    Logger::Stop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include <NovusTypes.h>
+#include <Networking/PacketUtils.h>
+#include <Network/AddressRequest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+constexpr size_t BENCH_DEFAULT_COUNT = 10000000;
+
+// TSC cycles where we have them, steady_clock ticks elsewhere
+static u64 ReadCycleCounter()
+{
+#if defined(_MSC_VER)
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return static_cast<u64>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// A Bytebuffer over storage that lives as long as the buffer
+static std::shared_ptr<Bytebuffer> CreateBuffer(size_t size)
+{
+    std::shared_ptr<std::vector<u8>> storage = std::make_shared<std::vector<u8>>(size);
+    Bytebuffer* buffer = new Bytebuffer(storage->data(), size);
+
+    return std::shared_ptr<Bytebuffer>(buffer, [storage](Bytebuffer* buffer) { delete buffer; });
+}
+
+struct BenchResult
+{
+    f64 bytesPerResponse = 0.0;
+    f64 cyclesPerResponse = 0.0;
+    f64 nanosecondsPerResponse = 0.0;
+};
+
+// Writes count responses back to back, starting over whenever the buffer can't fit another one like the encode stage does
+template <typename Func>
+static BenchResult RunBench(size_t count, Func writeResponse)
+{
+    std::shared_ptr<Bytebuffer> buffer = CreateBuffer(NETWORK_BUFFER_SIZE);
+    u64 bytesWritten = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    u64 startCycles = ReadCycleCounter();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t writtenBefore = buffer->writtenData;
+        writeResponse(buffer, static_cast<u32>(i));
+        bytesWritten += buffer->writtenData - writtenBefore;
+
+        if (buffer->GetSpace() < ADDRESS_REQUEST_MAX_SIZE * 2)
+            buffer->Reset();
+    }
+
+    u64 cycles = ReadCycleCounter() - startCycles;
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    BenchResult result;
+    result.bytesPerResponse = static_cast<f64>(bytesWritten) / count;
+    result.cyclesPerResponse = static_cast<f64>(cycles) / count;
+    result.nanosecondsPerResponse = static_cast<f64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / count;
+    return result;
+}
+
+static void PrintBenchResult(const char* name, const BenchResult& result)
+{
+    printf("  %-20s %8.1f bytes %8.1f cycles %8.1f ns per response\n", name, result.bytesPerResponse, result.cyclesPerResponse, result.nanosecondsPerResponse);
+}
+
+static bool IsSameOutput(const std::shared_ptr<Bytebuffer>& a, const std::shared_ptr<Bytebuffer>& b)
+{
+    return a->writtenData == b->writtenData && std::memcmp(a->GetDataPointer(), b->GetDataPointer(), a->writtenData) == 0;
+}
+
+i32 main(i32 argc, char* argv[])
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : BENCH_DEFAULT_COUNT;
+    if (argc > 2 || count == 0)
+    {
+        printf("Usage: bench [count]\n");
+        printf("  Encodes count successful address responses field by field and from the pre-encoded template the load balancer uses, %llu by default\n", static_cast<u64>(BENCH_DEFAULT_COUNT));
+        printf("  Fails if the two put different bytes on the wire\n");
+        return 1;
+    }
+
+    u32 address = 0x0100007F;
+    u16 port = 8001;
+
+    // A typical echoed payload, the requester's own tracking data
+    u8 payload[16];
+    std::memset(payload, 0xAB, sizeof(payload));
+
+    AddressResponseTemplate responseTemplate;
+    responseTemplate.Build(address, port);
+
+    AddressRequest legacyRequest;
+    AddressRequest leaseRequest;
+    leaseRequest.flags = ADDRESS_REQUEST_FLAG_LEASE;
+
+    // Both paths have to put the same bytes on the wire, there is no point in timing them otherwise
+    std::shared_ptr<Bytebuffer> serialized = CreateBuffer(ADDRESS_REQUEST_MAX_SIZE * 2);
+    std::shared_ptr<Bytebuffer> templated = CreateBuffer(ADDRESS_REQUEST_MAX_SIZE * 2);
+
+    PacketUtils::Write_SMSG_SEND_ADDRESS(serialized, ADDRESS_STATUS_SUCCESS, address, port, payload, sizeof(payload));
+    responseTemplate.Write(templated, legacyRequest, 0, 0, payload, sizeof(payload));
+
+    if (!IsSameOutput(serialized, templated))
+    {
+        fprintf(stderr, "Legacy template output differs from PacketUtils::Write_SMSG_SEND_ADDRESS\n");
+        return 1;
+    }
+
+    serialized->Reset();
+    templated->Reset();
+
+    AddressResponse response;
+    response.status = ADDRESS_STATUS_SUCCESS;
+    response.address = address;
+    response.port = port;
+    response.leaseDurationMS = 30000;
+    response.tableVersion = 7;
+    response.Serialize(serialized, leaseRequest, payload, sizeof(payload));
+    responseTemplate.Write(templated, leaseRequest, 30000, 7, payload, sizeof(payload));
+
+    if (!IsSameOutput(serialized, templated))
+    {
+        fprintf(stderr, "Lease template output differs from AddressResponse::Serialize\n");
+        return 1;
+    }
+
+    BenchResult legacySerialized = RunBench(count, [&](std::shared_ptr<Bytebuffer>& buffer, u32 i)
+    {
+        PacketUtils::Write_SMSG_SEND_ADDRESS(buffer, ADDRESS_STATUS_SUCCESS, address, port, payload, sizeof(payload));
+    });
+    BenchResult legacyTemplated = RunBench(count, [&](std::shared_ptr<Bytebuffer>& buffer, u32 i)
+    {
+        responseTemplate.Write(buffer, legacyRequest, 0, 0, payload, sizeof(payload));
+    });
+
+    BenchResult leaseSerialized = RunBench(count, [&](std::shared_ptr<Bytebuffer>& buffer, u32 i)
+    {
+        AddressResponse response;
+        response.status = ADDRESS_STATUS_SUCCESS;
+        response.address = address;
+        response.port = port;
+        response.leaseDurationMS = 30000;
+        response.tableVersion = i;
+        response.Serialize(buffer, leaseRequest, payload, sizeof(payload));
+    });
+    BenchResult leaseTemplated = RunBench(count, [&](std::shared_ptr<Bytebuffer>& buffer, u32 i)
+    {
+        responseTemplate.Write(buffer, leaseRequest, 30000, i, payload, sizeof(payload));
+    });
+
+    printf("%llu responses with a %u byte payload\n", static_cast<u64>(count), static_cast<u32>(sizeof(payload)));
+    PrintBenchResult("Legacy, serialized", legacySerialized);
+    PrintBenchResult("Legacy, template", legacyTemplated);
+    PrintBenchResult("Lease, serialized", leaseSerialized);
+    PrintBenchResult("Lease, template", leaseTemplated);
+
+    return 0;
+}
\ No newline at end of file
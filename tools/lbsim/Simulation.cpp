@@ -0,0 +1,449 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+constexpr u32 NO_SERVER = ~0u;
+
+// Timed separately on the final table, timing every frame's handful of requests would mostly measure the clock
+constexpr u32 SELECTION_BENCH_REQUESTS = 4096;
+
+struct SimServer
+{
+    f32 weight = 1.0f;
+    u32 capacity = 0;
+    u32 load = 0; // Cost of the sessions it hosts
+    u32 activeLeases = 0; // What the load balancer should be counting
+    bool isPresent = true;
+};
+
+struct SimLease
+{
+    f32 expireTime = 0.0f;
+    u32 serverIndex = 0;
+};
+
+struct SimSession
+{
+    f32 endTime = 0.0f;
+    u32 serverIndex = 0;
+    u32 requester = 0;
+    u16 cost = 1;
+};
+
+struct SimRequester
+{
+    u32 lastServer = NO_SERVER;
+    u32 lastTopologyChange = 0; // Topology changes seen when it last asked
+    u16 cost = 1;
+};
+
+class Scenario
+{
+public:
+    Scenario(const SimulationOptions& options, u64 seed) : _options(options), _random(seed)
+    {
+        _result.seed = seed;
+
+        _loadBalanceSingleton.leaseDuration = options.leaseDuration;
+        _loadBalanceSingleton.loadHalfLife = options.loadHalfLife;
+        _loadBalanceSingleton.slowStartDuration = options.slowStartDuration;
+        _loadBalanceSingleton.placementPolicy = options.placementPolicy;
+    }
+
+    SimulationResult Run()
+    {
+        SetupRequesters();
+
+        u32 numServers = std::uniform_int_distribution<u32>(_options.minServers, std::max(_options.minServers, _options.maxServers))(_random);
+        for (u32 i = 0; i < numServers; i++)
+        {
+            AddServer();
+        }
+        _result.initialServers = numServers;
+
+        std::bernoulli_distribution churnDistribution(std::min(_options.churnRate / 60.0f * _options.tickTime, 1.0f));
+        std::poisson_distribution<u32> requestDistribution(_options.requestRate * _options.tickTime);
+
+        f32 nextSampleTime = 1.0f;
+        f32 nextAdvertiseTime = _options.advertiseInterval;
+        u32 numTicks = static_cast<u32>(_options.duration / _options.tickTime);
+
+        for (u32 tick = 1; tick <= numTicks; tick++)
+        {
+            _time = tick * _options.tickTime;
+            _loadBalanceSingleton.Update(_time);
+
+            EndSessions();
+            ExpireLeases();
+
+            if (_options.failoverTime > 0.0f && !_hasFailedOver && _time >= _options.failoverTime)
+                FailOver();
+
+            if (_hasFailedOver)
+                CheckLeases();
+
+            if (churnDistribution(_random))
+                ChangeTopology();
+
+            if (_options.type == AddressType::INSTANCE && _time >= nextAdvertiseTime)
+            {
+                AdvertiseCapacity();
+                nextAdvertiseTime += _options.advertiseInterval;
+            }
+
+            // Requesters that lost their server ask again right away, before the new ones of this frame
+            std::vector<u32> requesters;
+            requesters.swap(_retryRequesters);
+
+            u32 numRequests = requestDistribution(_random);
+            for (u32 i = 0; i < numRequests; i++)
+            {
+                requesters.push_back(SampleRequester());
+            }
+
+            for (u32 requester : requesters)
+            {
+                Request(requester);
+            }
+
+            if (_time >= nextSampleTime)
+            {
+                SampleImbalance();
+                nextSampleTime += 1.0f;
+            }
+        }
+
+        if (_numSamples)
+        {
+            _result.maxOverMean /= _numSamples;
+            _result.coefficientOfVariation /= _numSamples;
+        }
+
+        MeasureSelectionCost();
+        return _result;
+    }
+
+private:
+    // Zipf over the requester ids, every requester gets a heavy tailed session cost independent of how often it asks
+    void SetupRequesters()
+    {
+        u32 numRequesters = std::max(_options.numRequesters, 1u);
+        _requesters.resize(numRequesters);
+        _requesterCdf.resize(numRequesters);
+
+        std::uniform_int_distribution<u32> costDistribution(0, 7);
+
+        f64 total = 0.0;
+        for (u32 i = 0; i < numRequesters; i++)
+        {
+            total += 1.0 / std::pow(static_cast<f64>(i + 1), _options.skew);
+            _requesterCdf[i] = total;
+
+            u32 costRoll = costDistribution(_random);
+            _requesters[i].cost = costRoll == 7 ? 8 : costRoll >= 5 ? 2 : 1;
+        }
+    }
+
+    u32 SampleRequester()
+    {
+        f64 roll = std::uniform_real_distribution<f64>(0.0, _requesterCdf.back())(_random);
+        auto itr = std::upper_bound(_requesterCdf.begin(), _requesterCdf.end(), roll);
+        return static_cast<u32>(std::min<size_t>(itr - _requesterCdf.begin(), _requesterCdf.size() - 1));
+    }
+
+    ServerInformation GetInformation(u32 serverIndex) const
+    {
+        ServerInformation info;
+        info.entity = static_cast<entt::entity>(serverIndex);
+        info.type = _options.type;
+        info.realmId = 0;
+        info.address = 0x0A000000 + serverIndex;
+        info.port = 4000;
+
+        return info;
+    }
+
+    void AddServer()
+    {
+        static constexpr f32 weights[] = { 0.5f, 1.0f, 1.0f, 2.0f, 4.0f };
+
+        u32 serverIndex = static_cast<u32>(_servers.size());
+        SimServer& server = _servers.emplace_back();
+        server.weight = weights[std::uniform_int_distribution<u32>(0, 4)(_random)];
+        server.capacity = static_cast<u32>(server.weight * _options.sessionsPerWeight);
+
+        ServerInformation info = GetInformation(serverIndex);
+        _loadBalanceSingleton.Add(info);
+        _loadBalanceSingleton.SetWeight(info.type, info.realmId, info.entity, server.weight);
+
+        if (_options.type == AddressType::INSTANCE)
+            _loadBalanceSingleton.SetCapacity(info.realmId, info.entity, server.capacity);
+
+        _numPresent++;
+    }
+
+    void RemoveServer()
+    {
+        std::vector<u32> present;
+        for (u32 i = 0; i < _servers.size(); i++)
+        {
+            if (_servers[i].isPresent)
+                present.push_back(i);
+        }
+
+        u32 serverIndex = present[std::uniform_int_distribution<size_t>(0, present.size() - 1)(_random)];
+        _servers[serverIndex].isPresent = false;
+        _numPresent--;
+
+        ServerInformation info = GetInformation(serverIndex);
+        _loadBalanceSingleton.Remove(info.type, info.entity, info.realmId);
+
+        // Its sessions are lost, their requesters have to be placed somewhere else
+        for (const SimSession& session : _sessions)
+        {
+            if (session.serverIndex == serverIndex)
+                _retryRequesters.push_back(session.requester);
+        }
+    }
+
+    void ChangeTopology()
+    {
+        bool add = _numPresent <= _options.minServers || (_numPresent < _options.maxServers && std::bernoulli_distribution(0.5)(_random));
+        if (add)
+            AddServer();
+        else
+            RemoveServer();
+
+        _result.topologyChanges++;
+    }
+
+    void AdvertiseCapacity()
+    {
+        for (u32 i = 0; i < _servers.size(); i++)
+        {
+            const SimServer& server = _servers[i];
+            if (!server.isPresent)
+                continue;
+
+            u32 freeCapacity = server.capacity > server.load ? server.capacity - server.load : 0;
+            _loadBalanceSingleton.SetCapacity(0, static_cast<entt::entity>(i), freeCapacity);
+        }
+    }
+
+    void EndSessions()
+    {
+        // _sessions is a min heap on endTime, kept as a vector so RemoveServer can walk it
+        while (_sessions.size() && _sessions.front().endTime <= _time)
+        {
+            std::pop_heap(_sessions.begin(), _sessions.end(), SessionEndsLater);
+            SimSession& session = _sessions.back();
+
+            SimServer& server = _servers[session.serverIndex];
+            server.load -= std::min<u32>(server.load, session.cost);
+
+            _sessions.pop_back();
+        }
+    }
+
+    void ExpireLeases()
+    {
+        // Same rule as LoadBalanceSingleton::Update, so both agree on the frame a lease runs out
+        while (_leases.size() && _leases.front().expireTime <= _time)
+        {
+            SimServer& server = _servers[_leases.front().serverIndex];
+            server.activeLeases -= std::min<u32>(server.activeLeases, 1);
+            _leases.pop_front();
+        }
+    }
+
+    // Replicates the table like a snapshot does, a count and a window of remaining time per server, and lets the standby take over
+    void FailOver()
+    {
+        robin_hood::unordered_map<u32, LeaseWindow> leaseWindows;
+        _loadBalanceSingleton.GetLeaseWindows(leaseWindows);
+
+        std::vector<ServerEntry> serverEntries;
+        std::vector<LeaseWindow> entryLeaseWindows;
+        _loadBalanceSingleton.ForEach([&serverEntries, &entryLeaseWindows, &leaseWindows](AddressType type, u8 realmId, const ServerEntry& entry)
+        {
+            serverEntries.push_back(entry);
+
+            auto itr = leaseWindows.find(entry.id);
+            entryLeaseWindows.push_back(itr != leaseWindows.end() ? itr->second : LeaseWindow());
+        });
+
+        // From here on a server's leases are expected to run out where the standby spreads them, computed the same way Restore does
+        _leases.clear();
+        for (size_t i = 0; i < serverEntries.size(); i++)
+        {
+            const ServerEntry& entry = serverEntries[i];
+            const LeaseWindow& leaseWindow = entryLeaseWindows[i];
+
+            u32 serverIndex = static_cast<u32>(entry.info.entity);
+            _servers[serverIndex].activeLeases = entry.activeLeases;
+
+            for (u32 lease = 0; lease < entry.activeLeases; lease++)
+            {
+                f32 spread = entry.activeLeases > 1 ? static_cast<f32>(lease) / (entry.activeLeases - 1) : 1.0f;
+                _leases.push_back({ _time + leaseWindow.first + (leaseWindow.last - leaseWindow.first) * spread, serverIndex });
+            }
+        }
+
+        std::sort(_leases.begin(), _leases.end(), [](const SimLease& a, const SimLease& b) { return a.expireTime < b.expireTime; });
+
+        _loadBalanceSingleton.Restore(serverEntries, entryLeaseWindows, _loadBalanceSingleton.GetTableVersion());
+        _hasFailedOver = true;
+    }
+
+    void CheckLeases()
+    {
+        for (u32 i = 0; i < _servers.size(); i++)
+        {
+            if (!_servers[i].isPresent)
+                continue;
+
+            ServerInformation info = GetInformation(i);
+            const ServerEntry* entry = _loadBalanceSingleton.FindServer(info.type, info.realmId, info.entity);
+
+            _result.leaseChecks++;
+            _result.leaseMismatches += !entry || entry->activeLeases != _servers[i].activeLeases;
+        }
+    }
+
+    void Request(u32 requesterIndex)
+    {
+        SimRequester& requester = _requesters[requesterIndex];
+
+        SelectionParameters parameters;
+        parameters.leaseDuration = _options.leaseDuration;
+        parameters.cost = requester.cost;
+
+        _result.requests++;
+
+        ServerInformation info;
+        if (!_loadBalanceSingleton.Get(_options.type, info, parameters))
+        {
+            _result.failures++;
+            return;
+        }
+
+        u32 serverIndex = static_cast<u32>(info.entity);
+        if (requester.lastServer != NO_SERVER)
+        {
+            bool moved = requester.lastServer != serverIndex;
+            if (requester.lastTopologyChange != _result.topologyChanges)
+            {
+                _result.requestsAfterChange++;
+                _result.movedAfterChange += moved;
+            }
+            else
+            {
+                _result.requestsBetweenChanges++;
+                _result.movedBetweenChanges += moved;
+            }
+        }
+
+        requester.lastServer = serverIndex;
+        requester.lastTopologyChange = _result.topologyChanges;
+
+        _servers[serverIndex].load += requester.cost;
+
+        if (parameters.leaseDuration > 0.0f)
+        {
+            _servers[serverIndex].activeLeases++;
+            _leases.push_back({ _time + parameters.leaseDuration, serverIndex });
+        }
+
+        SimSession& session = _sessions.emplace_back();
+        session.endTime = _time + std::exponential_distribution<f32>(1.0f / _options.sessionDuration)(_random);
+        session.serverIndex = serverIndex;
+        session.requester = requesterIndex;
+        session.cost = requester.cost;
+        std::push_heap(_sessions.begin(), _sessions.end(), SessionEndsLater);
+    }
+
+    void SampleImbalance()
+    {
+        f64 total = 0.0;
+        f64 max = 0.0;
+        u32 count = 0;
+
+        for (const SimServer& server : _servers)
+        {
+            if (!server.isPresent)
+                continue;
+
+            f64 load = server.load / server.weight;
+            total += load;
+            max = std::max(max, load);
+            count++;
+        }
+
+        if (count == 0 || total <= 0.0)
+            return;
+
+        f64 mean = total / count;
+        f64 variance = 0.0;
+        for (const SimServer& server : _servers)
+        {
+            if (!server.isPresent)
+                continue;
+
+            f64 difference = server.load / server.weight - mean;
+            variance += difference * difference;
+        }
+
+        f64 maxOverMean = max / mean;
+        _result.maxOverMean += maxOverMean;
+        _result.worstMaxOverMean = std::max(_result.worstMaxOverMean, maxOverMean);
+        _result.coefficientOfVariation += std::sqrt(variance / count) / mean;
+        _numSamples++;
+    }
+
+    void MeasureSelectionCost()
+    {
+        SelectionParameters parameters;
+        parameters.leaseDuration = _options.leaseDuration;
+
+        ServerInformation info;
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        for (u32 i = 0; i < SELECTION_BENCH_REQUESTS; i++)
+        {
+            _loadBalanceSingleton.Get(_options.type, info, parameters);
+        }
+
+        f64 selectionTime = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+        _result.selectionCost = selectionTime / SELECTION_BENCH_REQUESTS;
+    }
+
+    static bool SessionEndsLater(const SimSession& a, const SimSession& b) { return a.endTime > b.endTime; }
+
+private:
+    const SimulationOptions& _options;
+    std::mt19937_64 _random;
+    SimulationResult _result;
+
+    LoadBalanceSingleton _loadBalanceSingleton;
+    f32 _time = 0.0f;
+
+    std::vector<SimServer> _servers; // Indexed by entity, removed servers keep their slot
+    u32 _numPresent = 0;
+    std::vector<SimSession> _sessions;
+    std::vector<SimRequester> _requesters;
+    std::vector<f64> _requesterCdf;
+    std::vector<u32> _retryRequesters;
+    u32 _numSamples = 0;
+
+    std::deque<SimLease> _leases; // Every lease has the same duration, so this is ordered by expireTime
+    bool _hasFailedOver = false;
+};
+
+SimulationResult RunScenario(const SimulationOptions& options, u64 seed)
+{
+    Scenario scenario(options, seed);
+    return scenario.Run();
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <NovusTypes.h>
+#include <Networking/AddressType.h>
+#include <ECS/Components/Network/LoadBalanceSingleton.h>
+
+// Everything a scenario is generated from, the seed picks the cluster, the churn and the requests
+struct SimulationOptions
+{
+    AddressType type = AddressType::WORLD;
+
+    f32 duration = 60.0f; // Virtual seconds per scenario
+    f32 tickTime = 0.01f; // One engine frame
+    f32 requestRate = 200.0f; // Requests per virtual second
+
+    u32 minServers = 4;
+    u32 maxServers = 32;
+    f32 churnRate = 6.0f; // Servers added or removed per virtual minute
+
+    u32 numRequesters = 1000;
+    f32 skew = 1.1f; // Zipf exponent of how often each requester asks, 0 is uniform
+    f32 sessionDuration = 20.0f; // Mean, exponentially distributed
+
+    // Copied onto the LoadBalanceSingleton, the policy under test
+    f32 leaseDuration = 0.0f;
+    f32 loadHalfLife = 1.0f;
+    f32 slowStartDuration = 30.0f;
+    PlacementPolicy placementPolicy = PlacementPolicy::WORST_FIT;
+
+    // INSTANCE servers advertise weight * sessionsPerWeight capacity, less what they host, every advertiseInterval
+    u32 sessionsPerWeight = 400;
+    f32 advertiseInterval = 5.0f;
+
+    // Virtual second the table is replicated to a standby that takes over, the way a snapshot carries it, 0 never fails over
+    f32 failoverTime = 0.0f;
+};
+
+struct SimulationResult
+{
+    u64 seed = 0;
+    u32 initialServers = 0;
+    u64 requests = 0;
+    u64 failures = 0;
+
+    // Sampled once per virtual second over the servers present, load is the cost of the sessions a server hosts divided by its weight
+    f64 maxOverMean = 0.0; // Averaged over the samples
+    f64 worstMaxOverMean = 0.0;
+    f64 coefficientOfVariation = 0.0; // Averaged over the samples
+
+    // A requester moved if its answer differs from its previous one, counted separately for its first request after a topology change
+    u32 topologyChanges = 0;
+    u64 requestsAfterChange = 0;
+    u64 movedAfterChange = 0;
+    u64 requestsBetweenChanges = 0;
+    u64 movedBetweenChanges = 0;
+
+    f64 selectionCost = 0.0; // Wall clock nanoseconds per LoadBalanceSingleton::Get, measured on the final table
+
+    // From the failover on, the standby's lease counts have to match the replicated leases running out on schedule plus the ones it handed out itself
+    u64 leaseChecks = 0; // Servers compared, once per frame each
+    u64 leaseMismatches = 0;
+
+    f64 GetMovedPerChange() const { return topologyChanges ? static_cast<f64>(movedAfterChange) / topologyChanges : 0.0; }
+};
+
+// Runs one scenario against its own LoadBalanceSingleton, scenarios share nothing and can run on any thread
+SimulationResult RunScenario(const SimulationOptions& options, u64 seed);
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include <NovusTypes.h>
+#include <Utils/AddressTypeUtils.h>
+#include "Simulation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void PrintUsage()
+{
+    printf("Usage: lbsim [options]\n");
+    printf("  Runs the load balancer's server selection against generated clusters on a virtual clock and reports how well it spreads load\n");
+    printf("  --scenarios <n>        Scenarios to run, every one gets its own seed (1000)\n");
+    printf("  --seed <n>             Seed of the first scenario (1)\n");
+    printf("  --threads <n>          Worker threads, 0 uses every core (0)\n");
+    printf("  --type <name>          AddressType to route, auth, realm, world, instance, chat, loadbalance or region (world)\n");
+    printf("  --duration <s>         Virtual seconds per scenario (60)\n");
+    printf("  --rate <n>             Requests per virtual second (200)\n");
+    printf("  --servers <min> <max>  Cluster size, the initial size is picked in between and churn stays within it (4 32)\n");
+    printf("  --churn <n>            Servers added or removed per virtual minute (6)\n");
+    printf("  --requesters <n>       Distinct requesters (1000)\n");
+    printf("  --skew <s>             Zipf exponent of how often each requester asks, 0 is uniform (1.1)\n");
+    printf("  --session <s>          Mean session length in virtual seconds (20)\n");
+    printf("  --lease <s>            Lease duration handed out with every answer, 0 asks without a lease (0)\n");
+    printf("  --halflife <s>         load.halflife (1)\n");
+    printf("  --slowstart <s>        slowstart.duration (30)\n");
+    printf("  --placement <policy>   INSTANCE placement, bestfit or worstfit (worstfit)\n");
+    printf("  --capacity <n>         Capacity an INSTANCE server advertises per unit of weight (400)\n");
+    printf("  --failover <s>         Replicates the table to a standby at this virtual second and checks it expires the leases on time, 0 never fails over (0)\n");
+    printf("  --csv                  Prints one line per scenario instead of the summary\n");
+}
+
+static f64 GetPercentile(std::vector<f64> values, f64 percentile)
+{
+    if (values.empty())
+        return 0.0;
+
+    size_t rank = std::min(static_cast<size_t>(percentile * values.size()), values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+static void PrintRow(const char* name, const std::vector<f64>& values)
+{
+    f64 total = 0.0;
+    for (f64 value : values)
+        total += value;
+
+    f64 max = values.empty() ? 0.0 : *std::max_element(values.begin(), values.end());
+    printf("%-22s %10.3f %10.3f %10.3f %10.3f\n", name, values.empty() ? 0.0 : total / values.size(), GetPercentile(values, 0.5), GetPercentile(values, 0.99), max);
+}
+
+i32 main(i32 argc, char* argv[])
+{
+    SimulationOptions options;
+    u32 numScenarios = 1000;
+    u64 firstSeed = 1;
+    u32 numThreads = 0;
+    bool isCsv = false;
+
+    for (i32 i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--csv")
+        {
+            isCsv = true;
+        }
+        else if (argument == "--scenarios" && hasValue)
+        {
+            numScenarios = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--seed" && hasValue)
+        {
+            firstSeed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--threads" && hasValue)
+        {
+            numThreads = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--type" && hasValue)
+        {
+            if (!AddressTypeUtils::FromName(argv[++i], options.type))
+            {
+                fprintf(stderr, "Unknown type %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (argument == "--duration" && hasValue)
+        {
+            options.duration = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--rate" && hasValue)
+        {
+            options.requestRate = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--servers" && i + 2 < argc)
+        {
+            options.minServers = std::max(static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)), 1u);
+            options.maxServers = std::max(static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)), options.minServers);
+        }
+        else if (argument == "--churn" && hasValue)
+        {
+            options.churnRate = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--requesters" && hasValue)
+        {
+            options.numRequesters = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--skew" && hasValue)
+        {
+            options.skew = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--session" && hasValue)
+        {
+            options.sessionDuration = std::max(std::strtof(argv[++i], nullptr), options.tickTime);
+        }
+        else if (argument == "--lease" && hasValue)
+        {
+            options.leaseDuration = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--halflife" && hasValue)
+        {
+            options.loadHalfLife = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--slowstart" && hasValue)
+        {
+            options.slowStartDuration = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--capacity" && hasValue)
+        {
+            options.sessionsPerWeight = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--failover" && hasValue)
+        {
+            options.failoverTime = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--placement" && hasValue)
+        {
+            std::string policy = argv[++i];
+            if (policy == "bestfit")
+                options.placementPolicy = PlacementPolicy::BEST_FIT;
+            else if (policy == "worstfit")
+                options.placementPolicy = PlacementPolicy::WORST_FIT;
+            else
+            {
+                fprintf(stderr, "Unknown placement policy %s\n", policy.c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // Scenarios are independent, every worker takes the next one until none are left
+    std::vector<SimulationResult> results(numScenarios);
+    std::atomic<u32> nextScenario = 0;
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (u32 i = 0; i < std::min(numThreads, numScenarios); i++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (u32 scenario = nextScenario++; scenario < numScenarios; scenario = nextScenario++)
+            {
+                results[scenario] = RunScenario(options, firstSeed + scenario);
+            }
+        });
+    }
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    f64 wallTime = std::chrono::duration<f64>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (isCsv)
+    {
+        printf("seed,servers,requests,failures,maxOverMean,worstMaxOverMean,cv,topologyChanges,movedPerChange,movedAfterChange,requestsAfterChange,movedBetweenChanges,requestsBetweenChanges,selectionNs,leaseChecks,leaseMismatches\n");
+        for (const SimulationResult& result : results)
+        {
+            printf("%llu,%u,%llu,%llu,%.4f,%.4f,%.4f,%u,%.2f,%llu,%llu,%llu,%llu,%.1f,%llu,%llu\n", static_cast<unsigned long long>(result.seed), result.initialServers, static_cast<unsigned long long>(result.requests),
+                static_cast<unsigned long long>(result.failures), result.maxOverMean, result.worstMaxOverMean, result.coefficientOfVariation, result.topologyChanges, result.GetMovedPerChange(),
+                static_cast<unsigned long long>(result.movedAfterChange), static_cast<unsigned long long>(result.requestsAfterChange), static_cast<unsigned long long>(result.movedBetweenChanges),
+                static_cast<unsigned long long>(result.requestsBetweenChanges), result.selectionCost, static_cast<unsigned long long>(result.leaseChecks),
+                static_cast<unsigned long long>(result.leaseMismatches));
+        }
+
+        return 0;
+    }
+
+    std::vector<f64> maxOverMean, worstMaxOverMean, coefficientOfVariation, movedPerChange, moveRateAfterChange, moveRateBetweenChanges, failureRate, selectionCost;
+    u64 totalRequests = 0;
+    u64 leaseChecks = 0;
+    u64 leaseMismatches = 0;
+
+    for (const SimulationResult& result : results)
+    {
+        maxOverMean.push_back(result.maxOverMean);
+        worstMaxOverMean.push_back(result.worstMaxOverMean);
+        coefficientOfVariation.push_back(result.coefficientOfVariation);
+        movedPerChange.push_back(result.GetMovedPerChange());
+        moveRateAfterChange.push_back(result.requestsAfterChange ? static_cast<f64>(result.movedAfterChange) / result.requestsAfterChange : 0.0);
+        moveRateBetweenChanges.push_back(result.requestsBetweenChanges ? static_cast<f64>(result.movedBetweenChanges) / result.requestsBetweenChanges : 0.0);
+        failureRate.push_back(result.requests ? static_cast<f64>(result.failures) / result.requests : 0.0);
+        selectionCost.push_back(result.selectionCost);
+
+        totalRequests += result.requests;
+        leaseChecks += result.leaseChecks;
+        leaseMismatches += result.leaseMismatches;
+    }
+
+    printf("%u %s scenarios, %llu requests, %.2f s on %u threads (%.0f scenarios per minute)\n\n", numScenarios, AddressTypeUtils::GetName(options.type), static_cast<unsigned long long>(totalRequests), wallTime,
+        std::min(numThreads, numScenarios), wallTime > 0.0 ? numScenarios / wallTime * 60.0 : 0.0);
+
+    printf("Across scenarios\n");
+    printf("%-22s %10s %10s %10s %10s\n", "Metric", "Mean", "p50", "p99", "Max");
+    PrintRow("Max / mean load", maxOverMean);
+    PrintRow("Worst max / mean load", worstMaxOverMean);
+    PrintRow("Load CV", coefficientOfVariation);
+    PrintRow("Moved per change", movedPerChange);
+    PrintRow("Move rate after change", moveRateAfterChange);
+    PrintRow("Move rate otherwise", moveRateBetweenChanges);
+    PrintRow("Failure rate", failureRate);
+    PrintRow("Selection ns", selectionCost);
+
+    if (options.failoverTime > 0.0f)
+    {
+        printf("\nAfter failover, %llu of %llu server lease counts differed from the leases handed out\n", static_cast<unsigned long long>(leaseMismatches), static_cast<unsigned long long>(leaseChecks));
+        if (leaseMismatches)
+            return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include <NovusTypes.h>
+#include <Utils/TraceFormat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+constexpr size_t NUM_STAGES = static_cast<size_t>(TraceStage::COUNT);
+
+// Time from the previous stage the request reached to this one, in microseconds, negative if the request never reached it
+static void GetStageTimes(const TraceRecord& record, f64 (&stageTimes)[NUM_STAGES], f64& totalTime)
+{
+    u64 previous = record.timestamps[0];
+    for (size_t stage = 0; stage < NUM_STAGES; stage++)
+    {
+        u64 timestamp = record.timestamps[stage];
+        if (timestamp == 0 || previous == 0)
+        {
+            stageTimes[stage] = -1.0;
+            continue;
+        }
+
+        stageTimes[stage] = (timestamp - previous) / 1000.0;
+        previous = timestamp;
+    }
+
+    totalTime = previous && record.timestamps[0] ? (previous - record.timestamps[0]) / 1000.0 : -1.0;
+}
+
+static f64 GetPercentile(std::vector<f64>& values, f64 percentile)
+{
+    if (values.empty())
+        return 0.0;
+
+    size_t rank = std::min(static_cast<size_t>(percentile * values.size()), values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+static void PrintRow(const char* name, std::vector<f64>& values)
+{
+    if (values.empty())
+    {
+        printf("%-10s %10u\n", name, 0u);
+        return;
+    }
+
+    f64 max = *std::max_element(values.begin(), values.end());
+    printf("%-10s %10zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, values.size(), GetPercentile(values, 0.5), GetPercentile(values, 0.9), GetPercentile(values, 0.99), GetPercentile(values, 0.999), max);
+}
+
+static bool ReadRecords(const char* path, std::vector<TraceRecord>& records)
+{
+    FILE* file = std::fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_FILE_MAGIC)
+    {
+        fprintf(stderr, "%s is not a request trace\n", path);
+        std::fclose(file);
+        return false;
+    }
+
+    // Newer writers may only append stages and fields, anything else is a new version
+    if (header.version != TRACE_FILE_VERSION || header.numStages < NUM_STAGES || header.recordSize < sizeof(TraceRecord))
+    {
+        fprintf(stderr, "%s is version %u with %u stages, this tool reads version %u\n", path, header.version, header.numStages, TRACE_FILE_VERSION);
+        std::fclose(file);
+        return false;
+    }
+
+    std::vector<u8> recordData(header.recordSize);
+    while (std::fread(recordData.data(), header.recordSize, 1, file) == 1)
+    {
+        TraceRecord& record = records.emplace_back();
+        std::memcpy(&record, recordData.data(), sizeof(TraceRecord));
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+i32 main(i32 argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: tracedump <file> [--csv]\n");
+        printf("  Prints per stage latency percentiles of the sampled requests and where the slowest 1%% spent their time\n");
+        printf("  --csv prints every record instead, one line per request with the time spent reaching each stage in microseconds\n");
+        return 1;
+    }
+
+    std::vector<TraceRecord> records;
+    if (!ReadRecords(argv[1], records))
+        return 1;
+
+    bool isCsv = argc > 2 && std::strcmp(argv[2], "--csv") == 0;
+    if (isCsv)
+    {
+        printf("traceId,addressType,status,flags");
+        for (size_t stage = 1; stage < NUM_STAGES; stage++)
+        {
+            printf(",%s", GetTraceStageName(static_cast<TraceStage>(stage)));
+        }
+        printf(",total\n");
+
+        for (const TraceRecord& record : records)
+        {
+            f64 stageTimes[NUM_STAGES];
+            f64 totalTime = 0.0;
+            GetStageTimes(record, stageTimes, totalTime);
+
+            printf("%u,%u,%u,%u", record.traceId, record.addressType, record.status, record.flags);
+            for (size_t stage = 1; stage < NUM_STAGES; stage++)
+            {
+                if (stageTimes[stage] < 0.0)
+                    printf(",");
+                else
+                    printf(",%.3f", stageTimes[stage]);
+            }
+            printf(",%.3f\n", totalTime);
+        }
+
+        return 0;
+    }
+
+    std::vector<f64> stageValues[NUM_STAGES];
+    std::vector<f64> totalValues;
+    std::vector<std::pair<f64, size_t>> totals; // (total, record index), for the tail breakdown
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        f64 stageTimes[NUM_STAGES];
+        f64 totalTime = 0.0;
+        GetStageTimes(records[i], stageTimes, totalTime);
+
+        for (size_t stage = 1; stage < NUM_STAGES; stage++)
+        {
+            if (stageTimes[stage] >= 0.0)
+                stageValues[stage].push_back(stageTimes[stage]);
+        }
+
+        // Only requests that were answered count towards the end to end time
+        if (records[i].timestamps[static_cast<size_t>(TraceStage::SEND)])
+        {
+            totalValues.push_back(totalTime);
+            totals.push_back({ totalTime, i });
+        }
+    }
+
+    printf("%zu requests, %zu answered\n\n", records.size(), totals.size());
+    printf("Time to reach each stage from the previous one, in microseconds\n");
+    printf("%-10s %10s %10s %10s %10s %10s %10s\n", "Stage", "Count", "p50", "p90", "p99", "p99.9", "Max");
+    for (size_t stage = 1; stage < NUM_STAGES; stage++)
+    {
+        PrintRow(GetTraceStageName(static_cast<TraceStage>(stage)), stageValues[stage]);
+    }
+    PrintRow("Total", totalValues);
+
+    if (totals.empty())
+        return 0;
+
+    // Where the slowest 1% spent their time, this is what a p99 regression is made of
+    std::sort(totals.begin(), totals.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    size_t numTail = std::max<size_t>(totals.size() / 100, 1);
+
+    f64 tailStageTotals[NUM_STAGES] = { };
+    f64 tailTotal = 0.0;
+    for (size_t i = 0; i < numTail; i++)
+    {
+        f64 stageTimes[NUM_STAGES];
+        f64 totalTime = 0.0;
+        GetStageTimes(records[totals[i].second], stageTimes, totalTime);
+
+        for (size_t stage = 1; stage < NUM_STAGES; stage++)
+        {
+            tailStageTotals[stage] += std::max(stageTimes[stage], 0.0);
+        }
+        tailTotal += totalTime;
+    }
+
+    printf("\nSlowest %zu requests, %.1f us on average\n", numTail, tailTotal / numTail);
+    for (size_t stage = 1; stage < NUM_STAGES; stage++)
+    {
+        printf("%-10s %10.1f us %6.1f%%\n", GetTraceStageName(static_cast<TraceStage>(stage)), tailStageTotals[stage] / numTail, tailTotal > 0.0 ? tailStageTotals[stage] / tailTotal * 100.0 : 0.0);
+    }
+
+    return 0;
+}
\ No newline at end of file